@@ -0,0 +1,228 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "xrun/utils/path.h"
+
+#define XRB_PATH_ROUNDS 200000
+
+struct xrb_path_case_s {
+  const char *path, *expect;
+};
+
+/* paths seen from compilers resolving includes and python resolving imports */
+static const struct xrb_path_case_s xrb_path_corpus[] = {
+  {"/usr/lib/gcc/x86_64-linux-gnu/12/../../../../include/c++/12/vector",
+   "/usr/include/c++/12/vector"},
+  {"/usr/lib/gcc/x86_64-linux-gnu/12/../../../../include/x86_64-linux-gnu/"
+   "c++/12/bits/c++config.h",
+   "/usr/include/x86_64-linux-gnu/c++/12/bits/c++config.h"},
+  {"/usr/lib/gcc/x86_64-linux-gnu/12/include/stddef.h",
+   "/usr/lib/gcc/x86_64-linux-gnu/12/include/stddef.h"},
+  {"/usr/include/c++/12/bits/../ext/../bits/stl_algo.h",
+   "/usr/include/c++/12/bits/stl_algo.h"},
+  {"/home/judge/run/./main.cpp", "/home/judge/run/main.cpp"},
+  {"/home/judge/run//./include/../src/solution.h",
+   "/home/judge/run/src/solution.h"},
+  {"/usr/lib/python3.11/encodings/__init__.py",
+   "/usr/lib/python3.11/encodings/__init__.py"},
+  {"/usr/lib/python3.11/../python3.11/./collections/__init__.py",
+   "/usr/lib/python3.11/collections/__init__.py"},
+  {"/usr/lib/python3/dist-packages/../../python3.11/lib-dynload/"
+   "_heapq.cpython-311-x86_64-linux-gnu.so",
+   "/usr/lib/python3.11/lib-dynload/_heapq.cpython-311-x86_64-linux-gnu.so"},
+  {"/usr/local/lib/python3.11/dist-packages/numpy/core/../linalg/linalg.py",
+   "/usr/local/lib/python3.11/dist-packages/numpy/linalg/linalg.py"},
+  {"/tmp/../../../../etc/ld.so.cache", "/etc/ld.so.cache"},
+  {"/lib/x86_64-linux-gnu/libc.so.6", "/lib/x86_64-linux-gnu/libc.so.6"},
+  {"/proc/self/fd/3", "/proc/self/fd/3"},
+  {"/", "/"},
+};
+
+/* relative paths, ".." above root and trailing slashes, as `realpath -ms` */
+static const struct xrb_path_case_s xrb_path_edges[] = {
+  {"main.cpp", "main.cpp"},
+  {"./main.cpp", "main.cpp"},
+  {"src/../include/./solution.h", "include/solution.h"},
+  {"src/", "src"},
+  {"src/..", "."},
+  {"src/../..", ".."},
+  {"../include/../../lib", "../../lib"},
+  {"./../.././a", "../../a"},
+  {".", "."},
+  {"..", ".."},
+  {"./", "."},
+  {"...", "..."},
+  {".a/..b/a..", ".a/..b/a.."},
+  {"/..", "/"},
+  {"/../a/../..", "/"},
+  {"/../../../tmp/./x/", "/tmp/x"},
+  {"/usr/lib/", "/usr/lib"},
+  {"/usr//lib//", "/usr/lib"},
+  {"/usr/lib/..//", "/usr"},
+  {"//", "/"},
+  {"/./", "/"},
+};
+
+#define XRB_PATH_CORPUS_SIZE \
+  (sizeof(xrb_path_corpus) / sizeof(struct xrb_path_case_s))
+#define XRB_PATH_EDGES_SIZE \
+  (sizeof(xrb_path_edges) / sizeof(struct xrb_path_case_s))
+
+/* levels joined by the generated paths checked against the reference */
+static const char *const xrb_path_levels[] = {"a", "bc", ".", "..", ""};
+
+#define XRB_PATH_LEVELS_SIZE \
+  (sizeof(xrb_path_levels) / sizeof(const char *))
+#define XRB_PATH_LEVELS_DEPTH 5
+
+static inline long long xrb_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static inline void xrb_path_load(xr_path_t *path, const char *raw) {
+  path->length = 0;
+  xr_string_concat_raw(path, raw, strlen(raw));
+}
+
+/*
+ * Reference normalizer which splits path into levels and keeps them on a
+ * stack, the way `realpath -ms` does. It is slow but obviously right.
+ *
+ * @param raw path to normalize
+ * @param out buffer of at least strlen(raw) + 2 bytes
+ */
+static void xrb_path_reference(const char *raw, char *out) {
+  const bool absolute = raw[0] == '/';
+  size_t length = 0, nlevel = 0, nparent = 0;
+  size_t starts[XR_PATH_MAX / 2 + 1];
+  out[0] = 0;
+  for (const char *cur = raw; *cur != 0;) {
+    const char *next = cur + strcspn(cur, "/");
+    const size_t level_length = next - cur;
+    if (level_length == 0 || (level_length == 1 && cur[0] == '.')) {
+      // empty level or "." changes nothing.
+    } else if (level_length == 2 && cur[0] == '.' && cur[1] == '.' &&
+               nlevel > nparent) {
+      length = starts[--nlevel];
+      out[length] = 0;
+    } else if (level_length == 2 && cur[0] == '.' && cur[1] == '.' &&
+               absolute) {
+      // ".." of root is root itself.
+    } else {
+      if (level_length == 2 && cur[0] == '.' && cur[1] == '.') {
+        nparent++;
+      }
+      starts[nlevel++] = length;
+      length += sprintf(out + length, "/%.*s", (int)level_length, cur);
+    }
+    cur = *next == '/' ? next + 1 : next;
+  }
+  if (length == 0) {
+    strcpy(out, absolute ? "/" : ".");
+  } else if (!absolute) {
+    memmove(out, out + 1, length);
+  }
+}
+
+static bool xrb_path_check(xr_path_t *path, const char *raw,
+                           const char *expect) {
+  xrb_path_load(path, raw);
+  xr_path_abs(path);
+  if (strcmp(path->string, expect) != 0 || path->length != strlen(expect)) {
+    fprintf(stderr, "path_abs(%s) = %s, expect %s.\n", raw, path->string,
+            expect);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  long rounds = argc > 1 ? strtol(argv[1], NULL, 10) : XRB_PATH_ROUNDS;
+  xr_path_t path;
+  xr_string_init(&path, XR_PATH_MAX);
+
+  // a benchmark over a wrong normalizer is worthless, verify corpus first.
+  for (size_t i = 0; i < XRB_PATH_CORPUS_SIZE; ++i) {
+    if (!xrb_path_check(&path, xrb_path_corpus[i].path,
+                        xrb_path_corpus[i].expect)) {
+      xr_path_delete(&path);
+      return 1;
+    }
+  }
+  for (size_t i = 0; i < XRB_PATH_EDGES_SIZE; ++i) {
+    if (!xrb_path_check(&path, xrb_path_edges[i].path,
+                        xrb_path_edges[i].expect)) {
+      xr_path_delete(&path);
+      return 1;
+    }
+  }
+
+  // then every path of up to XRB_PATH_LEVELS_DEPTH levels, with or without
+  // leading and trailing slash, against the reference normalizer.
+  char raw[64], expect[64];
+  size_t ngenerated = 0, total_paths = 1;
+  for (int i = 0; i < XRB_PATH_LEVELS_DEPTH; ++i) {
+    total_paths *= XRB_PATH_LEVELS_SIZE;
+  }
+  for (size_t code = 0; code < total_paths * 4; ++code) {
+    size_t length = 0, levels = code / 4;
+    if (code & 1) {
+      raw[length++] = '/';
+    }
+    for (int i = 0; i < XRB_PATH_LEVELS_DEPTH; ++i) {
+      length += sprintf(raw + length, i == 0 ? "%s" : "/%s",
+                        xrb_path_levels[levels % XRB_PATH_LEVELS_SIZE]);
+      levels /= XRB_PATH_LEVELS_SIZE;
+    }
+    if (code & 2) {
+      raw[length++] = '/';
+    }
+    raw[length] = 0;
+    xrb_path_reference(raw, expect);
+    if (!xrb_path_check(&path, raw, expect)) {
+      xr_path_delete(&path);
+      return 1;
+    }
+    ngenerated++;
+  }
+
+  // loading a path costs the same as the copy in file checker before abs.
+  long long start = xrb_now_ns();
+  for (long r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < XRB_PATH_CORPUS_SIZE; ++i) {
+      xrb_path_load(&path, xrb_path_corpus[i].path);
+    }
+    for (size_t i = 0; i < XRB_PATH_EDGES_SIZE; ++i) {
+      xrb_path_load(&path, xrb_path_edges[i].path);
+    }
+  }
+  long long load = xrb_now_ns() - start;
+
+  start = xrb_now_ns();
+  for (long r = 0; r < rounds; ++r) {
+    for (size_t i = 0; i < XRB_PATH_CORPUS_SIZE; ++i) {
+      xrb_path_load(&path, xrb_path_corpus[i].path);
+      xr_path_abs(&path);
+    }
+    for (size_t i = 0; i < XRB_PATH_EDGES_SIZE; ++i) {
+      xrb_path_load(&path, xrb_path_edges[i].path);
+      xr_path_abs(&path);
+    }
+  }
+  long long total = xrb_now_ns() - start;
+
+  long long npath =
+    rounds * (long long)(XRB_PATH_CORPUS_SIZE + XRB_PATH_EDGES_SIZE);
+  printf(
+    "{\"bench\": \"path_abs\", \"paths\": %lld, \"checked\": %zu, "
+    "\"ns_per_path\": %.2f, \"ns_per_load\": %.2f}\n",
+    npath, XRB_PATH_CORPUS_SIZE + XRB_PATH_EDGES_SIZE + ngenerated,
+    (double)(total - load) / npath, (double)load / npath);
+  xr_path_delete(&path);
+  return 0;
+}
@@ -0,0 +1,553 @@
+#define _GNU_SOURCE
+
+#include <getopt.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xrun/capture.h"
+#include "xrun/checkers.h"
+#include "xrun/entry.h"
+#include "xrun/option.h"
+#include "xrun/result.h"
+#include "xrun/sandbox.h"
+#include "xrun/stats.h"
+#include "xrun/tracer.h"
+#include "xrun/tracers/ptrace/tracer.h"
+#include "xrun/tracers/replay/tracer.h"
+#include "xrun/tracers/seccomp/tracer.h"
+#include "xrun/workspace.h"
+
+/*
+ * Run every workload of tracee natively and under xr_tracer_trace, and print
+ * one json object per workload:
+ *
+ *   stops         traps reported by tracer in a traced run
+ *   threads       threads of all processes seen by tracer in a traced run
+ *   native_ns     best wall time of native runs
+ *   traced_ns     best wall time of traced runs
+ *   ns_per_stop   (traced_ns - native_ns) / stops
+ *   stops_per_sec stops / traced_ns
+ *   overhead      traced_ns / native_ns
+ *   native_cpu_ns best cpu time of native runs, from rusage of the tree
+ *   traced_cpu_ns best cpu time of traced runs, which tracer sums up over
+ *                 processes. A workload fails if it is below
+ *                 XRB_TRACE_CPU_SLACK of native_cpu_ns, tracer has lost cpu
+ *                 time of tracees then.
+ *   teardown_ns   best time from the end of trap loop to all tracees reaped,
+ *                 only with -S, which needs --enable-stats
+ *   sandbox       sandboxes kept ready, only with -N, which runs traced runs
+ *                 in sandboxes. -N 0 builds one per run, hence traced_ns of
+ *                 a tiny workload, e.g. -s 0.0001 getpid, compares spawn
+ *                 latency of warm and cold sandboxes.
+ *   replay_ns     best time to replay a captured traced run through the same
+ *                 checkers, only with -R
+ *   replay_stops_per_sec
+ *                 stops / replay_ns, which is free of kernel noise, only
+ *                 with -R
+ *
+ * With -W, traced runs take a tmpfs workspace under the given dir as pwd.
+ *
+ * Workloads with a process limit are expected to be stopped by it, and are
+ * not run natively, native_ns and overhead are 0 then.
+ */
+
+extern char **environ;
+
+#define XRB_TRACE_REPEAT 5
+// stops only add to cpu time of tracees, traced runs may be below native
+// ones by noise of the best runs alone.
+#define XRB_TRACE_CPU_SLACK 0.9
+#define XRB_TRACE_WORKDIR "/tmp/xrb_trace_XXXXXX"
+#define XRB_TRACE_CAPTURE "/tmp/xrb_capture_XXXXXX"
+
+struct xrb_trace_case_s {
+  const char *name;
+  long n, arg;
+  // fork tree takes a depth, which is not scaled.
+  bool scale;
+  // process limit of traced runs, 0 for unlimited.
+  int nprocess;
+};
+
+static const struct xrb_trace_case_s xrb_trace_cases[] = {
+  {"getpid", 100000, 0, true}, {"write", 100000, 0, true},
+  {"open", 20000, 0, true},    {"clone", 2000, 16, true},
+  {"fork", 6, 0, false},       {"mmap", 20000, 0, true},
+  {"storm", 2000, 0, true},    {"pthread", 2000, 16, true},
+  {"bomb", 2000, 0, false, 1000},
+};
+
+#define XRB_TRACE_NCASE \
+  (sizeof(xrb_trace_cases) / sizeof(struct xrb_trace_case_s))
+
+struct xrb_trace_checker_s {
+  const char *name;
+  xr_checker_id_t id;
+};
+
+static const struct xrb_trace_checker_s xrb_trace_checkers[] = {
+  {"file", XR_CHECKER_FILE},
+  {"fork", XR_CHECKER_FORK},
+  {"syscall", XR_CHECKER_SYSCALL},
+  {"resource", XR_CHECKER_RESOURCE},
+  {"io", XR_CHECKER_IO},
+};
+
+#define XRB_TRACE_NCHECKER \
+  (sizeof(xrb_trace_checkers) / sizeof(struct xrb_trace_checker_s))
+
+struct xrb_trace_config_s {
+  const char *tracer, *tracee;
+  // indexed by checker id
+  bool checkers[XR_CHECKER_IO + 1];
+  char checker_names[64];
+  long repeat;
+  double scale;
+  bool stats;
+  // sandboxes kept ready, -1 for no sandbox.
+  long sandbox;
+  // base of workspaces, NULL to run in a temporary dir.
+  const char *workspace;
+  // replay a captured run of each workload as well.
+  bool replay;
+};
+typedef struct xrb_trace_config_s xrb_trace_config_t;
+
+static inline long long xrb_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static bool xrb_trace_parse_checkers(xrb_trace_config_t *cfg, char *arg) {
+  memset(cfg->checkers, 0, sizeof(cfg->checkers));
+  if (strcmp(arg, "all") == 0) {
+    for (size_t i = 0; i < XRB_TRACE_NCHECKER; ++i) {
+      cfg->checkers[xrb_trace_checkers[i].id] = true;
+    }
+    return true;
+  }
+  if (strcmp(arg, "none") == 0) {
+    return true;
+  }
+  for (char *name = strtok(arg, ","); name; name = strtok(NULL, ",")) {
+    size_t i = 0;
+    while (i < XRB_TRACE_NCHECKER &&
+           strcmp(name, xrb_trace_checkers[i].name) != 0) {
+      ++i;
+    }
+    if (i == XRB_TRACE_NCHECKER) {
+      fprintf(stderr, "unknown checker %s.\n", name);
+      return false;
+    }
+    cfg->checkers[xrb_trace_checkers[i].id] = true;
+  }
+  return true;
+}
+
+static void xrb_trace_option(xr_option_t *option) {
+  xr_option_init(option);
+  for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
+    option->calls[i] = true;
+  }
+  option->nprocess = XR_NPROC_UNLIMITED;
+  // every path and flags is accessible, checkers still do all the work.
+  xr_access_list_append(&option->directories, "/", 1, ~0l,
+                        XR_ACCESS_MODE_FLAG_CONTAINS);
+  xr_option_default(option);
+}
+
+// tracer replays capture if it is not NULL.
+static bool xrb_trace_tracer(xr_tracer_t *tracer, xr_option_t *option,
+                             xrb_trace_config_t *cfg, const char *capture) {
+  if (capture != NULL) {
+    xr_tracer_replay_init(tracer, "trace_bench");
+    if (xr_tracer_replay_load(tracer, capture) == false) {
+      return false;
+    }
+  } else if (strcmp(cfg->tracer, "seccomp") == 0) {
+    xr_tracer_seccomp_init(tracer, "trace_bench");
+  } else {
+    xr_tracer_ptrace_init(tracer, "trace_bench");
+  }
+  for (size_t i = 0; i < XRB_TRACE_NCHECKER; ++i) {
+    if (cfg->checkers[xrb_trace_checkers[i].id] &&
+        xr_tracer_add_checker(tracer, xrb_trace_checkers[i].id) == false) {
+      return false;
+    }
+  }
+  return xr_tracer_setup(tracer, option);
+}
+
+static long long xrb_trace_native(xr_entry_t *entry, long long *cpu) {
+  long long start = xrb_now_ns();
+  pid_t pid = fork();
+  if (pid == 0) {
+    xr_entry_execve(entry);
+    _exit(127);
+  } else if (pid == -1) {
+    return -1;
+  }
+  int status = 0;
+  struct rusage ru;
+  if (wait4(pid, &status, 0, &ru) != pid || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0) {
+    return -1;
+  }
+  long long elapsed = xrb_now_ns() - start;
+  *cpu = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ll +
+         (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ll;
+  return elapsed;
+}
+
+static long long xrb_trace_traced(xr_tracer_t *tracer, xr_entry_t *entry,
+                                  xr_tracer_code_t expect, unsigned long *ntrap,
+                                  int *nthread, long long *teardown,
+                                  long long *cpu) {
+  xr_result_t result;
+  xr_result_init(&result);
+  unsigned long long teardown_total =
+    tracer->stats ? tracer->stats->phases[XR_STATS_TEARDOWN].total : 0;
+  long long start = xrb_now_ns();
+  bool ok = xr_tracer_trace(tracer, entry, &result);
+  long long elapsed = xrb_now_ns() - start;
+  if (tracer->stats != NULL) {
+    teardown_total =
+      tracer->stats->phases[XR_STATS_TEARDOWN].total - teardown_total;
+  }
+  *teardown = teardown_total;
+  if (ok == false || result.status != expect) {
+    xr_string_t error;
+    xr_string_zero(&error);
+    xr_error_tostring(&tracer->error, &error);
+    fprintf(stderr, "trace failed with status %d: %s\n", result.status,
+            error.string ? error.string : "");
+    xr_string_delete(&error);
+    elapsed = -1;
+  }
+  *ntrap = result.ntrap;
+  *cpu = result.cpu_ns;
+  *nthread = 0;
+  for (xr_tracer_process_result_t *p = result.exited_processes; p != NULL;
+       p = p->next) {
+    *nthread += p->nthread;
+  }
+  xr_result_delete(&result);
+  return elapsed;
+}
+
+/**
+ * Capture a traced run, then replay it repeat times through the same
+ * checkers and option.
+ *
+ * @return best time of replays, -1 if any run failed or did not end as
+ * expected.
+ */
+static long long xrb_trace_replay(xr_tracer_t *tracer, xr_entry_t *entry,
+                                  xr_tracer_code_t expect,
+                                  xrb_trace_config_t *cfg) {
+  char path[] = XRB_TRACE_CAPTURE;
+  int fd = mkstemp(path);
+  if (fd == -1) {
+    perror("mkstemp");
+    return -1;
+  }
+  close(fd);
+  xr_capture_t capture;
+  unsigned long ntrap;
+  int nthread;
+  long long teardown, cpu, replayed = -1;
+  if (xr_capture_open(&capture, tracer, path) == false) {
+    perror(path);
+    unlink(path);
+    return -1;
+  }
+  long long elapsed =
+    xrb_trace_traced(tracer, entry, expect, &ntrap, &nthread, &teardown, &cpu);
+  if (xr_capture_close(&capture, tracer) == false || elapsed < 0) {
+    fprintf(stderr, "capture failed.\n");
+    unlink(path);
+    return -1;
+  }
+  xr_tracer_t replayer;
+  if (xrb_trace_tracer(&replayer, tracer->option, cfg, path) == false) {
+    fprintf(stderr, "replay tracer setup failed.\n");
+    xr_tracer_delete(&replayer);
+    unlink(path);
+    return -1;
+  }
+  for (long r = 0; r < cfg->repeat; ++r) {
+    elapsed = xrb_trace_traced(&replayer, entry, expect, &ntrap, &nthread,
+                               &teardown, &cpu);
+    if (elapsed < 0) {
+      replayed = -1;
+      break;
+    }
+    if (replayed < 0 || elapsed < replayed) {
+      replayed = elapsed;
+    }
+  }
+  xr_tracer_delete(&replayer);
+  unlink(path);
+  return replayed;
+}
+
+static bool xrb_trace_case(xr_tracer_t *tracer, xr_entry_t *entry,
+                           const struct xrb_trace_case_s *tcase,
+                           xrb_trace_config_t *cfg) {
+  long n = tcase->scale ? (long)(tcase->n * cfg->scale) : tcase->n;
+  char nstr[32], argstr[32];
+  snprintf(nstr, sizeof(nstr), "%ld", n);
+  snprintf(argstr, sizeof(argstr), "%ld", tcase->arg);
+  char *argv[] = {(char *)cfg->tracee, (char *)tcase->name, nstr, argstr,
+                  NULL};
+  entry->argv = argv;
+  xr_option_t *option = tracer->option;
+  xr_tracer_code_t expect = XR_RESULT_OK;
+  if (tcase->nprocess != 0) {
+    option->nprocess = tcase->nprocess;
+    expect = XR_RESULT_TASKOUT;
+    if (xr_tracer_setup(tracer, option) == false) {
+      return false;
+    }
+  }
+
+  long long native = 0, traced = -1, teardown = -1;
+  long long native_cpu = 0, traced_cpu = -1;
+  unsigned long ntrap = 0;
+  int nthread = 0;
+  bool ok = true;
+  for (long r = 0; ok && r < cfg->repeat; ++r) {
+    long long elapsed = 0, spent = 0, cpu = 0;
+    if (tcase->nprocess == 0) {
+      elapsed = xrb_trace_native(entry, &cpu);
+      if (elapsed < 0) {
+        fprintf(stderr, "native %s failed.\n", tcase->name);
+        ok = false;
+        break;
+      }
+      if (r == 0 || elapsed < native) {
+        native = elapsed;
+      }
+      if (r == 0 || cpu < native_cpu) {
+        native_cpu = cpu;
+      }
+    }
+    elapsed = xrb_trace_traced(tracer, entry, expect, &ntrap, &nthread,
+                               &spent, &cpu);
+    if (elapsed < 0) {
+      ok = false;
+      break;
+    }
+    if (traced < 0 || elapsed < traced) {
+      traced = elapsed;
+    }
+    if (traced_cpu < 0 || cpu < traced_cpu) {
+      traced_cpu = cpu;
+    }
+    if (teardown < 0 || spent < teardown) {
+      teardown = spent;
+    }
+  }
+  long long replay = -1;
+  if (ok && traced_cpu < native_cpu * XRB_TRACE_CPU_SLACK) {
+    fprintf(stderr, "traced %s took %lld ns of cpu time, native one %lld.\n",
+            tcase->name, traced_cpu, native_cpu);
+    ok = false;
+  }
+  if (ok && cfg->replay) {
+    replay = xrb_trace_replay(tracer, entry, expect, cfg);
+    ok = replay >= 0;
+  }
+  entry->argv = NULL;
+  if (tcase->nprocess != 0) {
+    option->nprocess = XR_NPROC_UNLIMITED;
+    ok = xr_tracer_setup(tracer, option) && ok;
+  }
+  if (ok == false) {
+    return false;
+  }
+
+  printf(
+    "{\"bench\": \"%s\", \"tracer\": \"%s\", \"checkers\": \"%s\", "
+    "\"n\": %ld, \"stops\": %lu, \"threads\": %d, \"native_ns\": %lld, "
+    "\"traced_ns\": %lld, "
+    "\"ns_per_stop\": %.2f, \"stops_per_sec\": %.0f, \"overhead\": %.3f, "
+    "\"native_cpu_ns\": %lld, \"traced_cpu_ns\": %lld",
+    tcase->name, cfg->tracer, cfg->checker_names, n, ntrap, nthread, native,
+    traced,
+    ntrap && native ? (double)(traced - native) / ntrap : 0.0,
+    (double)ntrap * 1e9 / traced, native ? (double)traced / native : 0.0,
+    native_cpu, traced_cpu);
+  if (cfg->stats) {
+    printf(", \"teardown_ns\": %lld", teardown);
+  }
+  if (cfg->sandbox != -1) {
+    printf(", \"sandbox\": %ld", cfg->sandbox);
+  }
+  if (cfg->replay) {
+    printf(", \"replay_ns\": %lld, \"replay_stops_per_sec\": %.0f", replay,
+           (double)ntrap * 1e9 / replay);
+  }
+  printf("}\n");
+  fflush(stdout);
+  return true;
+}
+
+static void xrb_trace_usage(const char *prog) {
+  fprintf(stderr,
+          "usage: %s [-t ptrace|seccomp] [-c all|none|file,fork,...] "
+          "[-r repeat] [-s scale] [-e tracee] [-S] [-N nwarm] [-W dir] [-R] "
+          "[workload...]\n",
+          prog);
+}
+
+int main(int argc, char *argv[]) {
+  xrb_trace_config_t cfg = {.tracer = "ptrace",
+                            .tracee = NULL,
+                            .repeat = XRB_TRACE_REPEAT,
+                            .scale = 1.0,
+                            .sandbox = -1};
+  char checkers[64] = "all";
+  int opt;
+  while ((opt = getopt(argc, argv, "t:c:r:s:e:SN:W:Rh")) != -1) {
+    switch (opt) {
+      case 't':
+        cfg.tracer = optarg;
+        break;
+      case 'c':
+        snprintf(checkers, sizeof(checkers), "%s", optarg);
+        break;
+      case 'r':
+        cfg.repeat = strtol(optarg, NULL, 10);
+        break;
+      case 's':
+        cfg.scale = strtod(optarg, NULL);
+        break;
+      case 'e':
+        cfg.tracee = optarg;
+        break;
+      case 'S':
+        cfg.stats = true;
+        break;
+      case 'N':
+        cfg.sandbox = strtol(optarg, NULL, 10);
+        break;
+      case 'W':
+        cfg.workspace = optarg;
+        break;
+      case 'R':
+        cfg.replay = true;
+        break;
+      default:
+        xrb_trace_usage(argv[0]);
+        return 2;
+    }
+  }
+  if (strcmp(cfg.tracer, "ptrace") != 0 && strcmp(cfg.tracer, "seccomp") != 0) {
+    xrb_trace_usage(argv[0]);
+    return 2;
+  }
+  snprintf(cfg.checker_names, sizeof(cfg.checker_names), "%s", checkers);
+  if (cfg.repeat <= 0 || cfg.scale <= 0 || cfg.sandbox < -1 ||
+      xrb_trace_parse_checkers(&cfg, checkers) == false) {
+    xrb_trace_usage(argv[0]);
+    return 2;
+  }
+
+  // tracee is next to trace_bench by default, tracees run in a workdir.
+  char tracee[PATH_MAX];
+  if (cfg.tracee == NULL) {
+    char self[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (len == -1) {
+      perror("readlink");
+      return 1;
+    }
+    self[len] = '\0';
+    snprintf(tracee, sizeof(tracee), "%s/tracee", dirname(self));
+  } else if (realpath(cfg.tracee, tracee) == NULL) {
+    perror(cfg.tracee);
+    return 1;
+  }
+  cfg.tracee = tracee;
+  char workdir[] = XRB_TRACE_WORKDIR;
+  if (mkdtemp(workdir) == NULL) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  xr_entry_t entry;
+  xr_entry_init(&entry);
+  xr_string_concat_raw(&entry.path, cfg.tracee, strlen(cfg.tracee));
+  xr_string_concat_raw(&entry.pwd, workdir, strlen(workdir));
+  xr_string_copy(&entry.root, &xr_path_slash);
+  entry.environs = environ;
+  for (int i = 0; i < 3; ++i) {
+    entry.stdio[i] = i;
+  }
+
+  int retval = 0;
+  xr_option_t option;
+  xr_tracer_t tracer;
+  xr_sandbox_pool_t sandboxes;
+  xr_workspace_pool_t workspaces;
+  xrb_trace_option(&option);
+  if (xrb_trace_tracer(&tracer, &option, &cfg, NULL) == false) {
+    fprintf(stderr, "tracer setup failed.\n");
+    retval = 1;
+    goto xrb_trace_failed;
+  }
+  if (cfg.stats && xr_tracer_enable_stats(&tracer) == false) {
+    fprintf(stderr, "xrun is configured without --enable-stats.\n");
+    retval = 1;
+    goto xrb_trace_failed;
+  }
+  if (cfg.workspace != NULL) {
+    if (xr_workspace_pool_init(&workspaces, cfg.workspace, NULL, 0,
+                               XR_WORKSPACE_DEFAULT_WARM) == false) {
+      perror("workspace pool");
+      retval = 1;
+      goto xrb_trace_failed;
+    }
+    tracer.workspaces = &workspaces;
+  }
+  if (cfg.sandbox != -1) {
+    if (xr_sandbox_pool_init(&sandboxes, 0, cfg.sandbox) == false) {
+      perror("sandbox pool");
+      retval = 1;
+      goto xrb_trace_failed;
+    }
+    tracer.sandboxes = &sandboxes;
+  }
+  for (size_t i = 0; i < XRB_TRACE_NCASE; ++i) {
+    bool selected = optind == argc;
+    for (int j = optind; j < argc && !selected; ++j) {
+      selected = strcmp(argv[j], xrb_trace_cases[i].name) == 0;
+    }
+    if (selected &&
+        !xrb_trace_case(&tracer, &entry, &xrb_trace_cases[i], &cfg)) {
+      retval = 1;
+      break;
+    }
+  }
+
+xrb_trace_failed:
+  xr_tracer_delete(&tracer);
+  if (tracer.sandboxes != NULL) {
+    xr_sandbox_pool_delete(&sandboxes);
+  }
+  if (tracer.workspaces != NULL) {
+    xr_workspace_pool_delete(&workspaces);
+  }
+  xr_access_list_delete(&option.directories);
+  xr_entry_delete(&entry);
+  rmdir(workdir);
+  return retval;
+}
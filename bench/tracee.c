@@ -0,0 +1,288 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Workloads traced by trace_bench, each one hammers a single kind of stop:
+ *
+ *   tracee getpid N        N getpid syscalls
+ *   tracee write N         N one byte writes into /dev/null
+ *   tracee open N          N open/close pairs over relative paths
+ *   tracee clone N [W]     N threads, W of them alive at the same time
+ *   tracee storm N [C]     N threads alive at the same time, created by C
+ *                          threads at once, C is number of cpus by default
+ *   tracee pthread N [W]   like clone, but each thread opens a file, glibc
+ *                          2.34 or later tries clone3 first, which tracers
+ *                          fail, then falls back to clone
+ *   tracee fork D          a binary tree of processes with depth D
+ *   tracee mmap N          N mmap/touch/munmap rounds of 64KiB
+ *   tracee bomb N          every process forks until N processes have been
+ *                          forked in total, then all of them sleep a while
+ */
+
+#define XRB_TRACEE_OPEN_FILES 8
+#define XRB_TRACEE_CLONE_WIDTH 16
+#define XRB_TRACEE_MMAP_SIZE (64 * 1024)
+#define XRB_TRACEE_STORM_STACK (64 * 1024)
+#define XRB_TRACEE_BOMB_LINGER 5
+
+static int xrb_tracee_getpid(long n, long arg) {
+  for (long i = 0; i < n; ++i) {
+    // bypass any pid cache of libc
+    syscall(SYS_getpid);
+  }
+  return 0;
+}
+
+static int xrb_tracee_write(long n, long arg) {
+  int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return 1;
+  }
+  for (long i = 0; i < n; ++i) {
+    if (write(fd, "x", 1) != 1) {
+      return 1;
+    }
+  }
+  close(fd);
+  return 0;
+}
+
+static int xrb_tracee_open(long n, long arg) {
+  char name[32];
+  for (long i = 0; i < n; ++i) {
+    snprintf(name, sizeof(name), "xrb_open_%ld", i % XRB_TRACEE_OPEN_FILES);
+    int fd = open(name, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (fd == -1) {
+      return 1;
+    }
+    close(fd);
+  }
+  for (int i = 0; i < XRB_TRACEE_OPEN_FILES && i < n; ++i) {
+    snprintf(name, sizeof(name), "xrb_open_%d", i);
+    unlink(name);
+  }
+  return 0;
+}
+
+static void *xrb_tracee_thread(void *arg) {
+  return arg;
+}
+
+static int xrb_tracee_clone(long n, long width) {
+  if (width <= 0) {
+    width = XRB_TRACEE_CLONE_WIDTH;
+  }
+  pthread_t *threads = malloc(sizeof(pthread_t) * width);
+  for (long i = 0; i < n; i += width) {
+    long batch = n - i < width ? n - i : width;
+    for (long j = 0; j < batch; ++j) {
+      if (pthread_create(&threads[j], NULL, xrb_tracee_thread, NULL) != 0) {
+        free(threads);
+        return 1;
+      }
+    }
+    for (long j = 0; j < batch; ++j) {
+      pthread_join(threads[j], NULL);
+    }
+  }
+  free(threads);
+  return 0;
+}
+
+static void *xrb_tracee_pthread_thread(void *arg) {
+  // file set and fs of thread come from clone flags of its creation.
+  int fd = open(".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd == -1) {
+    return (void *)1;
+  }
+  close(fd);
+  return NULL;
+}
+
+static int xrb_tracee_pthread(long n, long width) {
+  if (width <= 0) {
+    width = XRB_TRACEE_CLONE_WIDTH;
+  }
+  pthread_t *threads = malloc(sizeof(pthread_t) * width);
+  int failed = 0;
+  for (long i = 0; i < n; i += width) {
+    long batch = n - i < width ? n - i : width;
+    for (long j = 0; j < batch; ++j) {
+      if (pthread_create(&threads[j], NULL, xrb_tracee_pthread_thread, NULL) !=
+          0) {
+        free(threads);
+        return 1;
+      }
+    }
+    for (long j = 0; j < batch; ++j) {
+      void *retval = NULL;
+      pthread_join(threads[j], &retval);
+      failed |= retval != NULL;
+    }
+  }
+  free(threads);
+  return failed;
+}
+
+struct xrb_tracee_storm_s {
+  long n;
+  pthread_attr_t attr;
+  // all threads of storm wait here until every one has been created
+  pthread_barrier_t *barrier;
+};
+
+static void *xrb_tracee_storm_thread(void *arg) {
+  pthread_barrier_wait(((struct xrb_tracee_storm_s *)arg)->barrier);
+  return NULL;
+}
+
+static void *xrb_tracee_storm_creator(void *arg) {
+  struct xrb_tracee_storm_s *storm = arg;
+  pthread_t *threads = malloc(sizeof(pthread_t) * storm->n);
+  long created = 0;
+  for (; created < storm->n; ++created) {
+    // threads created so far would wait on barrier forever.
+    if (threads == NULL || pthread_create(&threads[created], &storm->attr,
+                                          xrb_tracee_storm_thread,
+                                          storm) != 0) {
+      _exit(1);
+    }
+  }
+  for (long i = 0; i < created; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+  return (void *)created;
+}
+
+static int xrb_tracee_storm(long n, long ncreator) {
+  if (n <= 0) {
+    return 0;
+  }
+  if (ncreator <= 0) {
+    ncreator = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  if (ncreator <= 0 || n < ncreator) {
+    ncreator = 1;
+  }
+  struct xrb_tracee_storm_s *storms =
+    malloc(sizeof(struct xrb_tracee_storm_s) * ncreator);
+  pthread_t *creators = malloc(sizeof(pthread_t) * ncreator);
+  pthread_barrier_t barrier;
+  pthread_barrier_init(&barrier, NULL, n);
+  long total = 0, started = 0;
+  for (; started < ncreator; ++started) {
+    storms[started].n = n / ncreator + (started < n % ncreator);
+    storms[started].barrier = &barrier;
+    pthread_attr_init(&storms[started].attr);
+    pthread_attr_setstacksize(&storms[started].attr, XRB_TRACEE_STORM_STACK);
+    if (pthread_create(&creators[started], NULL, xrb_tracee_storm_creator,
+                       &storms[started]) != 0) {
+      _exit(1);
+    }
+  }
+  for (long i = 0; i < started; ++i) {
+    void *created = NULL;
+    pthread_join(creators[i], &created);
+    pthread_attr_destroy(&storms[i].attr);
+    total += (long)created;
+  }
+  pthread_barrier_destroy(&barrier);
+  free(storms);
+  free(creators);
+  return total == n ? 0 : 1;
+}
+
+static int xrb_tracee_fork(long depth, long arg) {
+  if (depth <= 0) {
+    return 0;
+  }
+  pid_t children[2];
+  for (int i = 0; i < 2; ++i) {
+    children[i] = fork();
+    if (children[i] == 0) {
+      _exit(xrb_tracee_fork(depth - 1, arg));
+    } else if (children[i] == -1) {
+      return 1;
+    }
+  }
+  int failed = 0;
+  for (int i = 0; i < 2; ++i) {
+    int status = 0;
+    if (waitpid(children[i], &status, 0) == -1 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0) {
+      failed = 1;
+    }
+  }
+  return failed;
+}
+
+static int xrb_tracee_mmap(long n, long arg) {
+  for (long i = 0; i < n; ++i) {
+    char *map = mmap(NULL, XRB_TRACEE_MMAP_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED) {
+      return 1;
+    }
+    map[0] = map[XRB_TRACEE_MMAP_SIZE - 1] = 1;
+    munmap(map, XRB_TRACEE_MMAP_SIZE);
+  }
+  return 0;
+}
+
+static int xrb_tracee_bomb(long n, long arg) {
+  // forks so far, shared by every process of the bomb.
+  long *forked = mmap(NULL, sizeof(long), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (forked == MAP_FAILED) {
+    return 1;
+  }
+  // parent and child both keep forking.
+  while (__atomic_fetch_add(forked, 1, __ATOMIC_RELAXED) < n &&
+         fork() != -1) {
+  }
+  // processes linger, hence all of them are alive at the same time.
+  sleep(XRB_TRACEE_BOMB_LINGER);
+  return 0;
+}
+
+struct xrb_tracee_s {
+  const char *name;
+  int (*run)(long n, long arg);
+};
+
+static const struct xrb_tracee_s xrb_tracees[] = {
+  {"getpid", xrb_tracee_getpid}, {"write", xrb_tracee_write},
+  {"open", xrb_tracee_open},     {"clone", xrb_tracee_clone},
+  {"fork", xrb_tracee_fork},     {"mmap", xrb_tracee_mmap},
+  {"storm", xrb_tracee_storm},   {"pthread", xrb_tracee_pthread},
+  {"bomb", xrb_tracee_bomb},
+};
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: %s getpid|write|open|clone|fork|mmap|storm|pthread|bomb "
+            "N [arg]\n",
+            argv[0]);
+    return 2;
+  }
+  long n = strtol(argv[2], NULL, 10);
+  long arg = argc > 3 ? strtol(argv[3], NULL, 10) : 0;
+  for (size_t i = 0; i < sizeof(xrb_tracees) / sizeof(xrb_tracees[0]); ++i) {
+    if (strcmp(argv[1], xrb_tracees[i].name) == 0) {
+      return xrb_tracees[i].run(n, arg);
+    }
+  }
+  fprintf(stderr, "unknown workload %s.\n", argv[1]);
+  return 2;
+}
@@ -5,11 +5,51 @@
 
 #define XR_CALLS_CONVERT(name, compat) xr_calls_convert_impl(name, compat)
 #define XR_CALLS_NAME(scno, compat) xr_calls_name_impl(scno, compat)
+#define XR_CALLS_COMPAT_NAME(compat) xr_calls_compat_name_impl(compat)
 static int xr_calls_convert_impl(const char* name, int compat);
 static const char* const xr_calls_name_impl(long scno, int compat);
+static const char* const xr_calls_compat_name_impl(int compat);
 
 #define XR_COMPAT_SYSCALL_INVALID 0
 
+#include <stdint.h>
+#include <string.h>
+
+typedef struct xr_calls_phash_s xr_calls_phash_t;
+
+/*
+ * collision-free hash of syscall names of an abi, generated by
+ * tools/phash.awk. slots map each hash slot to the only syscall number whose
+ * name can be there.
+ */
+struct xr_calls_phash_s {
+  uint32_t seed, nbucket, nslot;
+  const unsigned short *disp;
+  const short *slots;
+};
+
+/**
+ * Lookup syscall number by name with one string comparison.
+ *
+ * @phash perfect hash of abi
+ * @names syscall name table of abi
+ * @name syscall name
+ *
+ * @return syscall number, or -1 if name is not a syscall of abi.
+ */
+static inline int xr_calls_phash_lookup(const xr_calls_phash_t *phash,
+                                        const char *const *names,
+                                        const char *name) {
+  uint32_t h0 = phash->seed, h1 = 0;
+  for (const unsigned char *c = (const unsigned char *)name; *c; ++c) {
+    h0 = h0 * 31 + *c;
+    h1 = h1 * 131 + *c;
+  }
+  uint32_t bucket = h0 & (phash->nbucket - 1);
+  int nr = phash->slots[(h1 + phash->disp[bucket]) & (phash->nslot - 1)];
+  return names[nr] != NULL && strcmp(name, names[nr]) == 0 ? nr : -1;
+}
+
 #if defined(XR_ARCH_X86_IA32) || defined(XR_ARCH_X86_64)
 /* call table for x64_86 and i386 compat */
 #include "xrun/calls/x86/calls.h"
@@ -7,30 +7,30 @@
 
 #define XR_COMPAT_SYSCALL_ARM_EABI 1
 #define XR_COMPAT_SYSCALL_ARM_OABI 2
+// compat modes are less than it
+#define XR_COMPAT_SYSCALL_MAX 3
 #define XR_COMPAT_SYSCALL_DEFAULT XR_COMPAT_SYSCALL_ARM_EABI
 
+static inline const char *const xr_calls_compat_name_impl(int compat) {
+  switch (compat) {
+    case XR_COMPAT_SYSCALL_ARM_EABI:
+      return "eabi";
+    case XR_COMPAT_SYSCALL_ARM_OABI:
+      return "oabi";
+    default:
+      return NULL;
+  }
+}
+
 static inline int xr_calls_convert_impl(const char *name, int compat) {
   switch (compat) {
     case XR_COMPAT_SYSCALL_ARM_EABI:
-      for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
-        if (xr_syscall_table_arm[i] != NULL &&
-            strcmp(name, xr_syscall_table_arm[i]) == 0) {
-          return i;
-        }
-      }
-      break;
     case XR_COMPAT_SYSCALL_ARM_OABI:
-      for (int i = XR_SYSCALL_MAX - 1; i >= 0; --i) {
-        if (xr_syscall_table_arm[i] != NULL &&
-            strcmp(name, xr_syscall_table_arm[i])) {
-          return i;
-        }
-      }
-      break;
+      return xr_calls_phash_lookup(&xr_syscall_phash_arm, xr_syscall_table_arm,
+                                   name);
     default:
       return -1;
   }
-  return -1;
 }
 
 static inline const char *const xr_calls_name_impl(long scno, int compat) {
@@ -6,6 +6,8 @@
 #define XR_COMPAT_SYSCALL_X86_64 1
 #define XR_COMPAT_SYSCALL_X86_X32 2
 #define XR_COMPAT_SYSCALL_X86_IA32 3
+// compat modes are less than it
+#define XR_COMPAT_SYSCALL_MAX 4
 
 #ifdef XR_ARCH_X86_64
 #define XR_ARCH_X86_IA32
@@ -18,38 +20,35 @@
 
 #include "./calls_32.h"
 
-static inline int xr_calls_convert_ia32_impl(const char *name) {
-  for (int i = 0; i < XR_IA32_SYSCALL_MAX; ++i) {
-    if (xr_syscall_table_ia32[i] != NULL &&
-        strcmp(name, xr_syscall_table_ia32[i]) == 0) {
-      return i;
-    }
+static inline const char *const xr_calls_compat_name_impl(int compat) {
+  switch (compat) {
+    case XR_COMPAT_SYSCALL_X86_64:
+      return "x86_64";
+    case XR_COMPAT_SYSCALL_X86_X32:
+      return "x32";
+    case XR_COMPAT_SYSCALL_X86_IA32:
+      return "ia32";
+    default:
+      return NULL;
   }
-  return -1;
+}
+
+static inline int xr_calls_convert_ia32_impl(const char *name) {
+  return xr_calls_phash_lookup(&xr_syscall_phash_ia32, xr_syscall_table_ia32,
+                               name);
 }
 
 #ifdef XR_ARCH_X86_64
 
 static inline int xr_calls_convert_impl(const char *name, int compat) {
   switch (compat) {
-    case XR_COMPAT_SYSCALL_X86_64: {
-      for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
-        if (xr_syscall_table_x64[i] != NULL &&
-            strcmp(name, xr_syscall_table_x64[i]) == 0) {
-          return i;
-        }
-      }
-      break;
-    }
-    case XR_COMPAT_SYSCALL_X86_X32: {
-      for (int i = XR_SYSCALL_MAX - 1; i >= 0; --i) {
-        if (xr_syscall_table_x64[i] != NULL &&
-            strcmp(name, xr_syscall_table_x64[i]) == 0) {
-          return i;
-        }
-      }
-      break;
-    }
+    case XR_COMPAT_SYSCALL_X86_64:
+      return xr_calls_phash_lookup(&xr_syscall_phash_x64,
+                                   xr_syscall_table_x64, name);
+    case XR_COMPAT_SYSCALL_X86_X32:
+      // x32 numbers are in x64 table without XR_X32_MASK_BIT_SYSCALL.
+      return xr_calls_phash_lookup(&xr_syscall_phash_x32,
+                                   xr_syscall_table_x64, name);
     case XR_COMPAT_SYSCALL_X86_IA32: {
       int scno = xr_calls_convert_ia32_impl(name);
       if (scno != -1) {
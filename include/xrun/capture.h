@@ -0,0 +1,139 @@
+#ifndef XR_CAPTURE_H
+#define XR_CAPTURE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "xrun/tracer.h"
+#include "xrun/utils/hash.h"
+#include "xrun/utils/pool.h"
+
+// first bytes of a capture, records are in byte order of host.
+#define XR_CAPTURE_MAGIC "XRCAPT02"
+#define XR_CAPTURE_MAGIC_SIZE 8
+
+typedef struct xr_capture_s xr_capture_t;
+typedef struct xr_capture_header_s xr_capture_header_t;
+typedef struct xr_capture_record_s xr_capture_record_t;
+typedef struct xr_capture_task_s xr_capture_task_t;
+typedef struct xr_capture_trap_s xr_capture_trap_t;
+typedef struct xr_capture_memory_s xr_capture_memory_t;
+
+typedef enum xr_capture_kind_e xr_capture_kind_t;
+enum xr_capture_kind_e {
+  // a run starts, tasks of its first trap follow.
+  XR_CAPTURE_BEGIN = 0x1,
+  // a task is seen for the first time, before its first trap.
+  XR_CAPTURE_TASK,
+  // a trap returned by tracer, before checkers see it.
+  XR_CAPTURE_TRAP,
+  // tracee memory a checker read on the trap before.
+  XR_CAPTURE_MEMORY,
+  // a run ends, with its status.
+  XR_CAPTURE_END,
+};
+
+// op of tracer which read memory of XR_CAPTURE_MEMORY.
+typedef enum xr_capture_op_e xr_capture_op_t;
+enum xr_capture_op_e {
+  XR_CAPTURE_GET,
+  XR_CAPTURE_STRCPY,
+  // address is the fd path of task is resolved at.
+  XR_CAPTURE_TASK_PATH,
+};
+
+struct xr_capture_header_s {
+  char magic[XR_CAPTURE_MAGIC_SIZE];
+  // syscall_exit of tracer which captured runs
+  bool syscall_exit;
+};
+
+// every record starts with it, size bytes of payload follow.
+struct xr_capture_record_s {
+  unsigned int kind, size;
+};
+
+// payload of XR_CAPTURE_TASK, followed by pwd if it has no parent.
+struct xr_capture_task_s {
+  pid_t tid, pid;
+  // see xr_thread_t
+  pid_t parent;
+  bool share_files, share_fs;
+};
+
+// payload of XR_CAPTURE_TRAP, with thread state as tracer left it.
+struct xr_capture_trap_s {
+  pid_t tid;
+  int trap;
+  int syscall_status, compat;
+  unsigned long clone_flags;
+  union {
+    int exit_code;
+    int stop_signal;
+    xr_trace_trap_syscall_t syscall_info;
+  };
+};
+
+// payload of XR_CAPTURE_MEMORY, followed by bytes read if ok.
+struct xr_capture_memory_s {
+  pid_t tid;
+  int op;
+  unsigned long address;
+  bool ok;
+};
+
+// payload of XR_CAPTURE_END.
+typedef xr_tracer_code_t xr_capture_end_t;
+
+/*
+ * capture of trap streams of runs, which replay tracer feeds to checkers
+ * again. It wraps get, strcpy and task_path ops of tracer to record what
+ * checkers read, and tracks tids it has recorded tasks of.
+ */
+struct xr_capture_s {
+  FILE *file;
+  // ops of tracer which are wrapped
+  xr_tracer_op_get_f *get;
+  xr_tracer_op_strcpy_f *strcpy;
+  xr_tracer_op_task_path_f *task_path;
+  // tids whose tasks are recorded in current run, and tracer->nthread when
+  // tasks were recorded last time.
+  xr_hash_t tids;
+  xr_pool_t tid_pool;
+  int nthread;
+};
+
+/**
+ * Open file and capture runs of tracer into it from now on.
+ *
+ * @@capture
+ * @tracer tracer which is not tracing
+ * @path file to write, which is truncated
+ *
+ * @return false if file can not be opened.
+ */
+bool xr_capture_open(xr_capture_t *capture, xr_tracer_t *tracer,
+                     const char *path);
+
+// called by tracer once a run is spawned.
+void xr_capture_begin(xr_capture_t *capture, xr_tracer_t *tracer);
+
+// called by tracer once trap op returned a trap.
+void xr_capture_trap(xr_capture_t *capture, xr_tracer_t *tracer,
+                     xr_trace_trap_t *trap);
+
+// called by tracer once a run is over.
+void xr_capture_end(xr_capture_t *capture, xr_result_t *result);
+
+/**
+ * Stop capturing and restore ops of tracer.
+ *
+ * @@capture
+ * @@tracer
+ *
+ * @return false if any record could not be written.
+ */
+bool xr_capture_close(xr_capture_t *capture, xr_tracer_t *tracer);
+
+#endif
@@ -4,6 +4,9 @@
 #include "xrun/checker.h"
 #include "xrun/utils/utils.h"
 
+// time and memory of a process are sampled at most once in it, in ns.
+#define XR_RESOURCE_CHECKER_SAMPLE_INTERVAL 10000000ull
+
 bool xr_resource_checker_setup(xr_checker_t *checker, xr_option_t *option);
 
 bool xr_resource_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
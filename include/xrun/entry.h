@@ -49,6 +49,21 @@ static inline void xr_entry_delete(xr_entry_t *entry) {
   xr_path_delete(&entry->root);
 }
 
+/**
+ * change root and working directory of current process into entry.
+ *
+ * @entry entry to enter
+ * @return false if chroot or chdir failed.
+ */
+bool xr_entry_enter(xr_entry_t *entry);
+
+/**
+ * exec entry program in current process, return only on failure.
+ *
+ * @entry entry to exec
+ */
+void xr_entry_exec(xr_entry_t *entry);
+
 void xr_entry_execve(xr_entry_t *entry);
 
 #endif
@@ -0,0 +1,38 @@
+#ifndef XR_LANDLOCK_H
+#define XR_LANDLOCK_H
+
+#include <stdbool.h>
+
+#include "xrun/option.h"
+#include "xrun/utils/path.h"
+
+/**
+ * Landlock ABI version of running kernel.
+ *
+ * @return ABI version, or 0 if landlock is not supported.
+ */
+int xr_landlock_abi();
+
+/**
+ * Check whether landlock alone can enforce access lists of option, which
+ * holds only if landlock permits exactly the opens of every entry. Entries in
+ * XR_ACCESS_MODE_FLAG_MATCH mode, files, and entries which deny a flag
+ * landlock can not see are never exact, file checker has to check them.
+ *
+ * @@option
+ */
+bool xr_landlock_covers(xr_option_t *option);
+
+/**
+ * Translate files and directories of option into a landlock ruleset and
+ * restrict calling process with it. It should be called in tracee before exec.
+ * The ruleset never denies an open which access lists permit.
+ *
+ * @@option
+ * @workspace path of workspace, which is granted every right, or NULL
+ * @root root of tracee, paths in access lists are resolved under it.
+ */
+bool xr_landlock_restrict(xr_option_t *option, xr_path_t *workspace,
+                          xr_path_t *root);
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "xrun/calls.h"
 #include "xrun/utils/path.h"
+#include "xrun/utils/perf.h"
 #include "xrun/utils/time.h"
 
 #define XR_NPROC_UNLIMITED INT_MAX
@@ -30,6 +31,8 @@ struct xr_limit_s {
   xr_time_t time;
   int nfile;
   unsigned long long nread, nwrite;
+  // counted by perf_event counters, for all tracees in total only.
+  xr_perf_count_t perf;
 };
 
 #define _XR_LIMIT_UNLIMITED                                         \
@@ -37,12 +40,76 @@ struct xr_limit_s {
     .nthread = XR_NTHREAD_UNLIMITED, .memory = XR_MEMORY_UNLIMITED, \
     .time = _XR_TIME_UNLIMITED, .nfile = XR_NFILE_UNLIMITED,        \
     .nread = XR_IO_UNLIMITED, .nwrite = XR_IO_UNLIMITED,            \
+    .perf = {.task_clock = XR_PERF_UNLIMITED,                       \
+             .instructions = XR_PERF_UNLIMITED},                    \
   }
 
 static const xr_limit_t __xr_limit_unlimited = _XR_LIMIT_UNLIMITED;
 
 #define XR_LIMIT_UNLIMITED __xr_limit_unlimited
 
+// cpus a placement can name, same as CPU_SETSIZE of glibc.
+#define XR_PLACEMENT_MAXCPU 1024
+#define XR_CPUS_BITS (8 * sizeof(unsigned long))
+
+typedef struct xr_cpus_s xr_cpus_t;
+// set of cpus like cpu_set_t, which is only defined with _GNU_SOURCE.
+struct xr_cpus_s {
+  unsigned long bits[XR_PLACEMENT_MAXCPU / XR_CPUS_BITS];
+};
+
+static inline void xr_cpus_set(xr_cpus_t *cpus, int cpu) {
+  cpus->bits[cpu / XR_CPUS_BITS] |= 1ul << (cpu % XR_CPUS_BITS);
+}
+
+static inline bool xr_cpus_isset(const xr_cpus_t *cpus, int cpu) {
+  return (cpus->bits[cpu / XR_CPUS_BITS] >> (cpu % XR_CPUS_BITS)) & 1;
+}
+
+static inline bool xr_cpus_empty(const xr_cpus_t *cpus) {
+  for (size_t i = 0; i < XR_PLACEMENT_MAXCPU / XR_CPUS_BITS; ++i) {
+    if (cpus->bits[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+typedef enum xr_placement_mode_e xr_placement_mode_t;
+enum xr_placement_mode_e {
+  // scheduler places tracer and tracees anywhere
+  XR_PLACEMENT_NONE = 0x0,
+  // tracer and tracees share the core tracer runs on and its SMT siblings
+  XR_PLACEMENT_SIBLINGS,
+  // each run holds ncpu cpus of cpus, which no other run takes meanwhile
+  XR_PLACEMENT_EXCLUSIVE,
+};
+
+typedef struct xr_placement_s xr_placement_t;
+struct xr_placement_s {
+  xr_placement_mode_t mode;
+  // cpus exclusive runs are taken from in order, cpus tracer may run on if
+  // empty.
+  xr_cpus_t cpus;
+  // cpus of each exclusive run
+  int ncpu;
+  // tracer thread runs at SCHED_FIFO during runs, tracees do not inherit it.
+  bool fifo;
+  // tracees allocate memory from nodes of their cpus only.
+  bool numa;
+};
+
+typedef struct xr_noise_s xr_noise_t;
+// noise a run tolerates, a run beyond any of it is noisy.
+struct xr_noise_s {
+  // involuntary context switches and migrations of tracees
+  long nivcsw, nmigration;
+  // major page faults of tracees
+  long nmajflt;
+  // steal time of host in ns
+  unsigned long long steal_ns;
+};
+
 typedef struct xr_access_entry_s xr_access_entry_t;
 typedef struct xr_access_list_s xr_access_list_t;
 typedef enum xr_access_type_e xr_access_type_t;
@@ -81,9 +148,7 @@ static inline void xr_access_list_delete(xr_access_list_t *alist) {
   for (size_t i = 0; i < alist->nentry; ++i) {
     xr_path_delete(&alist->entries[i].path);
   }
-  if (alist->nentry != 0) {
-    free(alist->entries);
-  }
+  free(alist->entries);
 }
 
 void xr_access_list_append(xr_access_list_t *alist, const char *path,
@@ -105,6 +170,17 @@ struct xr_option_s {
   xr_limit_t limit, limit_per_process;
   xr_access_trigger_mode_t access_trigger;
   xr_access_list_t files, directories;
+  // enforce files and directories with landlock as well, if kernel supports.
+  // Once landlock covers them, tracers without exit traps, i.e. seccomp, do
+  // not see opens at all, so its denials are not reported.
+  bool landlock;
+  xr_placement_t placement;
+  // count tracees with perf_event counters, which perf limits imply.
+  bool perf;
+  // check time limits against time less cost of stops, which needs a
+  // calibrated tracer.
+  bool compensate;
+  xr_noise_t noise;
 };
 
 static inline void xr_option_init(xr_option_t *option) {
@@ -135,10 +211,19 @@ static inline void xr_option_init(xr_option_t *option) {
     XR_OPTION_TIME_DEFAULT(&(limit)->time);                            \
     XR_OPTION_DEFAULT_IF_ZERO((limit)->nread, XR_IO_UNLIMITED);        \
     XR_OPTION_DEFAULT_IF_ZERO((limit)->nwrite, XR_IO_UNLIMITED);       \
+    XR_OPTION_DEFAULT_IF_ZERO((limit)->perf.task_clock,                \
+                              XR_PERF_UNLIMITED);                      \
+    XR_OPTION_DEFAULT_IF_ZERO((limit)->perf.instructions,              \
+                              XR_PERF_UNLIMITED);                      \
   } while (0)
 
 static inline void xr_option_default(xr_option_t *option) {
   XR_OPTION_DEFAULT_IF_ZERO(option->nprocess, 1);
+  XR_OPTION_DEFAULT_IF_ZERO(option->placement.ncpu, 1);
+  XR_OPTION_DEFAULT_IF_ZERO(option->noise.nivcsw, LONG_MAX);
+  XR_OPTION_DEFAULT_IF_ZERO(option->noise.nmigration, LONG_MAX);
+  XR_OPTION_DEFAULT_IF_ZERO(option->noise.nmajflt, LONG_MAX);
+  XR_OPTION_DEFAULT_IF_ZERO(option->noise.steal_ns, ULLONG_MAX);
   XR_OPTION_LIMIT_DEFAULT(&option->limit);
   XR_OPTION_LIMIT_DEFAULT(&option->limit_per_process);
   option->access_trigger = XR_ACCESS_TRIGGER_MODE_IN;
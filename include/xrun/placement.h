@@ -0,0 +1,77 @@
+#ifndef XR_PLACEMENT_H
+#define XR_PLACEMENT_H
+
+#include <stdbool.h>
+
+#include "xrun/option.h"
+
+// nodes a memory policy can name.
+#define XR_PLACEMENT_MAXNODE 1024
+// byte i of lock file is locked while an exclusive run holds cpu i. Only
+// root may create entries in /run, so nobody else can plant a link there.
+#define XR_PLACEMENT_LOCK_DIR "/run/xrun"
+#define XR_PLACEMENT_LOCK XR_PLACEMENT_LOCK_DIR "/cpus.lock"
+
+typedef struct xr_placement_run_s xr_placement_run_t;
+
+/*
+ * placement of one run, it holds cpus of run, and affinity, scheduling policy
+ * and memory policy tracer thread had before run, which are restored after.
+ * Tracees inherit affinity and memory policy of tracer through fork.
+ */
+struct xr_placement_run_s {
+  xr_cpus_t cpus;
+  // fd of lock file, -1 if it is not opened yet.
+  int lock;
+  bool pinned, claimed, fifo, numa;
+
+  xr_cpus_t affinity;
+  int policy, priority;
+  int mempolicy;
+  unsigned long nodes[XR_PLACEMENT_MAXNODE / XR_CPUS_BITS];
+};
+
+static inline void xr_placement_run_init(xr_placement_run_t *run) {
+  run->lock = -1;
+  run->pinned = run->claimed = run->fifo = run->numa = false;
+}
+
+// whether runs are placed at all.
+static inline bool xr_placement_enabled(const xr_placement_t *placement) {
+  return placement->mode != XR_PLACEMENT_NONE || placement->fifo ||
+         placement->numa;
+}
+
+/**
+ * Parse a cpu list, like "0-3,8" in sysfs.
+ *
+ * @@cpus
+ * @list
+ *
+ * @return false if list is malformed or names a cpu beyond
+ * XR_PLACEMENT_MAXCPU.
+ */
+bool xr_cpus_parse(xr_cpus_t *cpus, const char *list);
+
+/**
+ * Place calling thread and tracees it forks from now on.
+ *
+ * @@run
+ * @@placement
+ *
+ * @return false if exclusive run finds too few free cpus, or a policy can not
+ * be set. Nothing is changed then.
+ */
+bool xr_placement_begin(xr_placement_run_t *run,
+                        const xr_placement_t *placement);
+
+/**
+ * Restore calling thread and release cpus of run.
+ *
+ * @@run
+ */
+void xr_placement_end(xr_placement_run_t *run);
+
+void xr_placement_run_delete(xr_placement_run_t *run);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef XR_PROBE_H
+#define XR_PROBE_H
+
+#include "config.h"
+
+/*
+ * USDT probes of provider xrun, which perf and bpftrace attach to a live
+ * xrun, e.g. `bpftrace -e 'usdt:./libxrun.so:xrun:trap { ... }'`. A probe is
+ * a nop in the hot path until something attaches to it, and its arguments
+ * are only kept in registers or on stack. Without sys/sdt.h probes expand to
+ * nothing.
+ *
+ * probes and their arguments:
+ *   spawn__begin    -
+ *   spawn__end      pid of first tracee, once spawn succeeded
+ *   trap            tid, kind of trap, syscall or exit code or signal,
+ *                   syscall_status of thread
+ *   check           checker id, tid, verdict
+ *   thread__create  tid, pid, tid of parent or 0
+ *   thread__exit    tid, pid, exit code
+ *   process__create pid
+ *   process__exit   pid, exit code
+ *   teardown__begin status of run so far
+ *   teardown__end   status of run, traps of run
+ */
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define XR_PROBE0(name) DTRACE_PROBE(xrun, name)
+#define XR_PROBE1(name, a) DTRACE_PROBE1(xrun, name, a)
+#define XR_PROBE2(name, a, b) DTRACE_PROBE2(xrun, name, a, b)
+#define XR_PROBE3(name, a, b, c) DTRACE_PROBE3(xrun, name, a, b, c)
+#define XR_PROBE4(name, a, b, c, d) DTRACE_PROBE4(xrun, name, a, b, c, d)
+#else
+#define XR_PROBE0(name)
+#define XR_PROBE1(name, a)
+#define XR_PROBE2(name, a, b)
+#define XR_PROBE3(name, a, b, c)
+#define XR_PROBE4(name, a, b, c, d)
+#endif
+
+#endif
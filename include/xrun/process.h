@@ -3,23 +3,38 @@
 
 #include "xrun/calls.h"
 #include "xrun/files.h"
+#include "xrun/probe.h"
 #include "xrun/utils/list.h"
+#include "xrun/utils/pool.h"
 #include "xrun/utils/time.h"
 
+// clone_flags of a thread out of clone.
+#define XR_THREAD_CLONE_UNKNOWN (~0ul)
+
 typedef struct xr_thread_s xr_thread_t;
 typedef struct xr_process_s xr_process_t;
+typedef struct xr_result_call_s xr_result_call_t;
 
+// fields used on every trap come first, they are in the first cache line.
 struct xr_process_s {
   int pid;
+  int compat;
+  int nthread;
+  xr_list_t threads;
+  xr_list_t processes;
 
   int nfile;
   int memory;
   xr_time_t time;
-
-  xr_list_t processes;
-  xr_list_t threads;
-  int nthread;
-  int compat;
+  // when time and memory were sampled by resource checker
+  unsigned long long sampled;
+  // moves of leader between cpus, sampled once it exits
+  long nmigration;
+  // cpu time of all threads in ns, sampled along with time, and cpu time
+  // first tracee spent in setup of tracer before its execve.
+  unsigned long long cpu_ns, cpu_setup;
+  // syscall and signal stops of all threads, see xr_tracer_t.nstop
+  unsigned long nstop;
 };
 
 struct xr_thread_s {
@@ -28,23 +43,35 @@ struct xr_thread_s {
     XR_THREAD_CALLIN = 0,
     XR_THREAD_CALLOUT = 1,
   } syscall_status;
+  xr_process_t *process;
+  xr_list_t threads;
+  // flags of clone, fork or vfork in progress, taken on its entry by
+  // tracer with xr_tracer_clone_flags. XR_THREAD_CLONE_UNKNOWN if they are
+  // not known.
+  unsigned long clone_flags;
+
+  // profile entry and entry stop of current syscall.
+  xr_result_call_t *call;
+  unsigned long long call_start;
 
   xr_fs_t fs;
   xr_file_set_t fset;
-
-  xr_process_t *process;
-  xr_list_t threads;
-  union {
-    xr_thread_t *from;
-    long to_call;
-  };
+  // tid of thread which created it, 0 if tracer has not seen that one, and
+  // whether files and fs are shared with it. Captures of runs record them.
+  int parent;
+  bool share_files, share_fs;
 };
 
+// tracers add every new thread here, the first one creates its process.
 static inline void xr_process_add_thread(xr_process_t *process,
                                          xr_thread_t *thread) {
+  if (process->nthread == 0) {
+    XR_PROBE1(process__create, process->pid);
+  }
   process->nthread++;
   xr_list_add(&process->threads, &thread->threads);
   thread->process = process;
+  XR_PROBE3(thread__create, thread->tid, process->pid, thread->parent);
 }
 
 static inline void xr_process_remove_thread(xr_process_t *process,
@@ -58,12 +85,25 @@ static inline void xr_process_remove_thread(xr_process_t *process,
   xr_list_del(&thread->threads);
 }
 
+static inline xr_thread_t *xr_process_first_thread(xr_process_t *process) {
+  if (process == NULL || xr_list_empty(&process->threads)) {
+    return NULL;
+  }
+  return xr_list_entry(process->threads.next, xr_thread_t, threads);
+}
+
 static inline void xr_process_init(xr_process_t *process) {
   xr_list_init(&process->processes);
   xr_list_init(&process->threads);
   process->compat = XR_COMPAT_SYSCALL_INVALID;
   process->nfile = 0;
   process->nthread = 0;
+  process->memory = 0;
+  process->time.sys_time = process->time.user_time = 0;
+  process->sampled = 0;
+  process->nmigration = 0;
+  process->cpu_ns = process->cpu_setup = 0;
+  process->nstop = 0;
 }
 static inline void xr_thread_init(xr_thread_t *thread) {
   xr_list_init(&thread->threads);
@@ -71,8 +111,42 @@ static inline void xr_thread_init(xr_thread_t *thread) {
   xr_fs_init(&thread->fs);
   thread->syscall_status = XR_THREAD_CALLIN;
   thread->tid = 0;
+  thread->clone_flags = XR_THREAD_CLONE_UNKNOWN;
+  thread->call = NULL;
+  thread->call_start = 0;
+  thread->parent = 0;
+  thread->share_files = thread->share_fs = false;
+}
+
+/**
+ * Set up files and fs of a new thread from the thread which created it.
+ *
+ * @thread new thread
+ * @from thread calling clone, fork or vfork
+ * @files true if files are shared with from, otherwise they are copied
+ * @fs true if fs is shared with from, otherwise it is copied
+ */
+static inline void xr_thread_inherit(xr_thread_t *thread, xr_thread_t *from,
+                                     bool files, bool fs) {
+  thread->parent = from->tid;
+  thread->share_files = files;
+  thread->share_fs = fs;
+  xr_file_set_share(&from->fset, &thread->fset);
+  if (!files) {
+    xr_file_set_own(&thread->fset);
+  }
+  xr_fs_share(&from->fs, &thread->fs);
+  if (!fs) {
+    xr_fs_own(&thread->fs);
+  }
 }
-void xr_process_delete(xr_process_t *process);
+/**
+ * Delete process and its threads, which are put back to pool.
+ *
+ * @@process
+ * @pool pool of threads
+ */
+void xr_process_delete(xr_process_t *process, xr_pool_t *pool);
 void xr_thread_delete(xr_thread_t *thread);
 
 #endif
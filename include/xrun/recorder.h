@@ -0,0 +1,79 @@
+#ifndef XR_RECORDER_H
+#define XR_RECORDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+// records a recorder keeps, a power of two.
+#define XR_RECORDER_NRECORD 256
+// arguments of syscall kept in a record
+#define XR_RECORD_NARG 3
+// checker of a record which passed all checkers
+#define XR_RECORD_PASSED -1
+
+typedef struct xr_record_s xr_record_t;
+typedef struct xr_recorder_s xr_recorder_t;
+
+/*
+ * a trap of tracer and what checkers made of it.
+ */
+struct xr_record_s {
+  // monotonic time of trap in ns
+  unsigned long long time;
+  pid_t tid;
+  // XR_TRACE_TRAP_* of trap, and abi of syscall.
+  unsigned char trap, compat;
+  // whether syscall stop is on exit.
+  bool out;
+  // id of checker which failed trap, or XR_RECORD_PASSED.
+  signed char checker;
+  // syscall number in table of compat, stop signal or exit code, by trap.
+  long nr;
+  long args[XR_RECORD_NARG];
+  long retval;
+};
+
+/*
+ * flight recorder of recent traps, a ring of records which tracer thread
+ * writes and overwrites without allocation or locking. Readers of other
+ * threads may copy records meanwhile, xr_recorder_last drops those which are
+ * overwritten under them.
+ */
+struct xr_recorder_s {
+  xr_record_t records[XR_RECORDER_NRECORD];
+  // records written so far, the next one goes to nrecord % NRECORD.
+  unsigned long nrecord;
+};
+
+static inline void xr_recorder_init(xr_recorder_t *recorder) {
+  recorder->nrecord = 0;
+}
+
+/**
+ * Slot of next record, which is published by xr_recorder_commit.
+ *
+ * @@recorder
+ */
+static inline xr_record_t *xr_recorder_next(xr_recorder_t *recorder) {
+  return &recorder->records[recorder->nrecord % XR_RECORDER_NRECORD];
+}
+
+static inline void xr_recorder_commit(xr_recorder_t *recorder) {
+  __atomic_store_n(&recorder->nrecord, recorder->nrecord + 1,
+                   __ATOMIC_RELEASE);
+}
+
+/**
+ * Copy last records, oldest first.
+ *
+ * @@recorder
+ * @records at least n records
+ * @n records wanted
+ *
+ * @return number of records copied, fewer than n if fewer were kept.
+ */
+size_t xr_recorder_last(const xr_recorder_t *recorder, xr_record_t *records,
+                        size_t n);
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef XR_RESULT_H
 #define XR_RESULT_H
 
+#include "xrun/calls.h"
 #include "xrun/utils/path.h"
+#include "xrun/utils/perf.h"
 #include "xrun/utils/string.h"
 #include "xrun/utils/time.h"
 
 typedef struct xr_result_s xr_result_t;
+typedef struct xr_result_call_s xr_result_call_t;
 typedef enum xr_tracer_code_e xr_tracer_code_t;
 
 enum xr_tracer_code_e {
@@ -35,35 +38,111 @@ enum xr_tracer_code_e {
   XR_RESULT_OK,
 };
 
+typedef enum xr_result_backend_e xr_result_backend_t;
+
+// who made the decision of XR_RESULT_PATHDENY
+enum xr_result_backend_e {
+  // checker on a tracer trap
+  XR_RESULT_BACKEND_TRACER = 0x0,
+  // kernel landlock ruleset
+  XR_RESULT_BACKEND_LANDLOCK,
+};
+
 typedef struct xr_tracer_process_result_s xr_tracer_process_result_t;
 struct xr_tracer_process_result_s {
   long memory;
+  // user and sys time in ms, which come in clock ticks from /proc
   xr_time_t time;
+  // cpu time of all threads from scheduler in ns, and in ms
+  unsigned long long cpu_ns;
+  xr_time_ms_t cpu_ms;
+  // stops of process, and time and cpu_ns less their cost, which is taken off
+  // sys time.
+  unsigned long nstop;
+  xr_time_t compensated_time;
+  unsigned long long compensated_cpu_ns;
   int nthread;
   int nfile;
   long long io_read, io_write;
   xr_tracer_process_result_t *next;
 };
 
+typedef struct xr_result_sched_s xr_result_sched_t;
+/*
+ * how a run was scheduled, counted from start of run to its end.
+ *
+ * For tracees, cpu time, switches and faults are deltas of RUSAGE_CHILDREN of
+ * the whole tracer process. They include any other child it reaps meanwhile,
+ * e.g. runs of other tracer threads. Migrations are read from schedstat of
+ * thread group leaders only, so moves of other threads are not counted.
+ */
+struct xr_result_sched_s {
+  // user and sys time in ns, at us resolution of rusage
+  unsigned long long user_ns, sys_ns;
+  // voluntary and involuntary context switches
+  long nvcsw, nivcsw;
+  // moves between cpus, of thread group leaders only for tracees
+  long nmigration;
+  // minor and major page faults
+  long nminflt, nmajflt;
+};
+
+// entries of profile, indexed by compat * XR_SYSCALL_MAX + syscall
+#define XR_RESULT_NPROFILE (XR_COMPAT_SYSCALL_MAX * XR_SYSCALL_MAX)
+
+/*
+ * profile of a syscall of an abi in a run, times are in ns.
+ */
+struct xr_result_call_s {
+  unsigned long count;
+  // from entry stop to exit stop, only if tracer traps on exit as well.
+  unsigned long long total, max;
+  // tracer spent on stops of syscall, from trap returned to step returned.
+  unsigned long long tracer;
+};
+
 struct xr_result_s {
   xr_tracer_code_t status;
   int nprocess;
+  // number of traps reported by tracer
+  unsigned long ntrap;
+  // traps of each syscall, counted only if caller provides XR_SYSCALL_MAX
+  // counters here after xr_result_init. They are owned by caller.
+  unsigned long *ntrap_calls;
+  // syscall profile, collected only if caller provides XR_RESULT_NPROFILE
+  // zeroed entries here after xr_result_init. They are owned by caller.
+  xr_result_call_t *profile;
   union {
     int ecall;
     struct {
       xr_path_t epath;
       long eflags;
+      xr_result_backend_t ebackend;
     };
   };
   int epid, etid;
   xr_tracer_process_result_t *exited_processes;
   xr_tracer_process_result_t *aborted_processes;
   xr_tracer_process_result_t error_process;
+  // scheduling of tracees, and of tracer thread during run
+  xr_result_sched_t sched, tracer_sched;
+  // counts of all tracees, XR_PERF_UNAVAILABLE unless they were counted.
+  xr_perf_count_t perf;
+  // cpu time of all tracees in ns, and that less cost of stops
+  unsigned long long cpu_ns, compensated_cpu_ns;
+  // steal time of host during run in ns, and whether run was beyond noise of
+  // option, which makes its timing doubtful.
+  unsigned long long steal_ns;
+  bool noisy;
+  // traps recorded in recorder of tracer during run, the last ones of which
+  // are still there.
+  unsigned long nrecord;
 };
 
 static inline void xr_result_init(xr_result_t *result) {
   memset(result, 0, sizeof(xr_result_t));
   result->status = XR_RESULT_UNKNOWN;
+  result->perf.task_clock = result->perf.instructions = XR_PERF_UNAVAILABLE;
 }
 
 static inline void xr_result_delete(xr_result_t *result) {
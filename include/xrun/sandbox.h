@@ -0,0 +1,131 @@
+#ifndef XR_SANDBOX_H
+#define XR_SANDBOX_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "xrun/utils/list.h"
+
+// sandboxes kept warm by default.
+#define XR_SANDBOX_DEFAULT_WARM 2
+#define XR_SANDBOX_HOSTNAME "xrun"
+
+typedef struct xr_sandbox_s xr_sandbox_t;
+typedef struct xr_sandbox_pool_s xr_sandbox_pool_t;
+
+// namespaces of a sandbox, in the order a tracee joins them.
+typedef enum xr_sandbox_ns_e xr_sandbox_ns_t;
+enum xr_sandbox_ns_e {
+  XR_SANDBOX_NS_USER,
+  XR_SANDBOX_NS_MNT,
+  XR_SANDBOX_NS_IPC,
+  XR_SANDBOX_NS_NET,
+  XR_SANDBOX_NS_UTS,
+  XR_SANDBOX_NS_PID,
+  XR_SANDBOX_NNS,
+};
+
+/*
+ * a set of namespaces held by a process, which is init of its pid namespace
+ * and reaps orphans of sandbox. Mount namespace has slave propagation, a
+ * /proc of its pid namespace and a /sys of its net namespace. A sandbox
+ * serves one run only, killing its init kills whatever is left in it.
+ */
+struct xr_sandbox_s {
+  pid_t init;
+  // fds of namespaces, -1 if sandbox does not have it
+  int ns[XR_SANDBOX_NNS];
+  xr_sandbox_pool_t *pool;
+  xr_list_t sandboxes;
+};
+
+/*
+ * sandboxes built ahead of runs. A keeper process, forked at init, clones
+ * inits of sandboxes, hence they are never children of tracer and its wait
+ * does not see them. A background thread asks keeper for sandboxes until
+ * nwarm of them are ready, and destroys used ones. Both run as SCHED_IDLE.
+ */
+struct xr_sandbox_pool_s {
+  // CLONE_NEW* flags of sandboxes
+  int flags;
+  size_t nwarm;
+  // active pid namespace of caller, which forks return to.
+  int pidns;
+  pid_t keeper;
+  int sock;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  // ready is signaled once a sandbox is ready or building fails, dirty once
+  // a sandbox is used or taken.
+  pthread_cond_t ready, dirty;
+  xr_list_t warm, used;
+  size_t nready, nwaiting;
+  bool failed, stop;
+};
+
+/**
+ * Namespaces of sandboxes by default: mount, pid, ipc, net and uts ones for
+ * root. Others get a user namespace instead of pid namespace, since joining a
+ * pid namespace needs CAP_SYS_ADMIN in user namespace of tracer.
+ */
+int xr_sandbox_default_flags();
+
+/**
+ * Fork keeper and start background thread, which builds nwarm sandboxes
+ * right away.
+ *
+ * @@pool
+ * @flags CLONE_NEW* flags of sandboxes, 0 for xr_sandbox_default_flags
+ * @nwarm sandboxes kept ready, 0 to build one only when it is taken
+ *
+ * @return false if keeper or thread can not be started.
+ */
+bool xr_sandbox_pool_init(xr_sandbox_pool_t *pool, int flags, size_t nwarm);
+
+/**
+ * Take a ready sandbox, wait for one if none is ready.
+ *
+ * @@pool
+ *
+ * @return NULL if building a sandbox failed.
+ */
+xr_sandbox_t *xr_sandbox_pool_take(xr_sandbox_pool_t *pool);
+
+/**
+ * Give back a sandbox after its run, background thread destroys it.
+ *
+ * @@pool
+ * @@sandbox
+ */
+void xr_sandbox_pool_put(xr_sandbox_pool_t *pool, xr_sandbox_t *sandbox);
+
+/**
+ * Stop background thread and keeper, then destroy all sandboxes. Sandboxes
+ * taken from pool should have been put back.
+ *
+ * @@pool
+ */
+void xr_sandbox_pool_delete(xr_sandbox_pool_t *pool);
+
+/**
+ * Make children forked by calling thread from now on start in pid namespace
+ * of sandbox. Caller should call xr_sandbox_fork_end right after fork.
+ *
+ * @@sandbox
+ */
+bool xr_sandbox_fork_begin(xr_sandbox_t *sandbox);
+
+bool xr_sandbox_fork_end(xr_sandbox_t *sandbox);
+
+/**
+ * Join namespaces of sandbox other than pid one. It should be called in a
+ * single threaded tracee before exec, root and pwd of entry are then resolved
+ * in mount namespace of sandbox.
+ *
+ * @@sandbox
+ */
+bool xr_sandbox_enter(xr_sandbox_t *sandbox);
+
+#endif
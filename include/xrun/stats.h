@@ -0,0 +1,115 @@
+#ifndef XR_STATS_H
+#define XR_STATS_H
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "config.h"
+#include "xrun/calls.h"
+#include "xrun/checker.h"
+#include "xrun/utils/time.h"
+
+/*
+ * latency of stages of the trap loop, collected only if xrun is configured
+ * with --enable-stats, which defines XR_STATS. Otherwise XR_STATS_BEGIN and
+ * XR_STATS_END expand to nothing and tracer does not read any clock.
+ */
+
+// bucket i counts spans in [2^i, 2^(i+1)) ns, the last one counts the rest.
+#define XR_STATS_NBUCKET 32
+
+typedef enum xr_stats_phase_e xr_stats_phase_t;
+enum xr_stats_phase_e {
+  // the whole trap op of tracer
+  XR_STATS_TRAP,
+  // waiting for next stop, wait3 or epoll_wait
+  XR_STATS_WAIT,
+  // fetching syscall number and arguments of a stop
+  XR_STATS_PEEK,
+  // reading or writing tracee memory by get, set or strcpy op
+  XR_STATS_MEMORY,
+  // all checkers of a stop, memory accesses of checkers are included
+  XR_STATS_CHECK,
+  // resuming tracee
+  XR_STATS_STEP,
+  // from the end of trap loop to all tracees reaped, once per trace
+  XR_STATS_TEARDOWN,
+  XR_STATS_NPHASE,
+};
+
+#define XR_STATS_NCHECKER (XR_CHECKER_IO + 1)
+
+typedef struct xr_stats_hist_s xr_stats_hist_t;
+struct xr_stats_hist_s {
+  unsigned long count;
+  unsigned long long total, max;
+  unsigned long buckets[XR_STATS_NBUCKET];
+};
+
+typedef struct xr_stats_s xr_stats_t;
+struct xr_stats_s {
+  xr_stats_hist_t phases[XR_STATS_NPHASE];
+  // indexed by checker id
+  xr_stats_hist_t checkers[XR_STATS_NCHECKER];
+  // all checkers of syscall stops, indexed by syscall number
+  xr_stats_hist_t calls[XR_SYSCALL_MAX];
+};
+
+static inline void xr_stats_init(xr_stats_t *stats) {
+  memset(stats, 0, sizeof(xr_stats_t));
+}
+
+static inline void xr_stats_hist_add(xr_stats_hist_t *hist,
+                                     unsigned long long ns) {
+  int bucket = ns == 0 ? 0 : 63 - __builtin_clzll(ns);
+  hist->buckets[bucket < XR_STATS_NBUCKET ? bucket : XR_STATS_NBUCKET - 1]++;
+  hist->count++;
+  hist->total += ns;
+  if (ns > hist->max) {
+    hist->max = ns;
+  }
+}
+
+/**
+ * Upper bound of the bucket where p of spans fall in.
+ *
+ * @@hist
+ * @p quantile in [0, 1]
+ *
+ * @return 0 if no span is recorded.
+ */
+static inline unsigned long long xr_stats_hist_quantile(
+  const xr_stats_hist_t *hist, double p) {
+  unsigned long rank = (unsigned long)(p * hist->count), seen = 0;
+  for (int i = 0; i < XR_STATS_NBUCKET; ++i) {
+    seen += hist->buckets[i];
+    if (seen > rank || (seen == hist->count && seen != 0)) {
+      unsigned long long bound = 2ull << i;
+      return bound < hist->max ? bound : hist->max;
+    }
+  }
+  return 0;
+}
+
+#ifdef XR_STATS
+
+#define XR_STATS_BEGIN(stats, start) \
+  unsigned long long start = (stats) != NULL ? xr_time_now_ns() : 0
+
+#define XR_STATS_END(stats, hist, start)                           \
+  do {                                                             \
+    if ((stats) != NULL) {                                         \
+      xr_stats_hist_add(&(stats)->hist, xr_time_now_ns() - start); \
+    }                                                              \
+  } while (0)
+
+#else /* XR_STATS */
+
+#define XR_STATS_BEGIN(stats, start)
+#define XR_STATS_END(stats, hist, start) \
+  do {                                   \
+  } while (0)
+
+#endif /* XR_STATS */
+
+#endif
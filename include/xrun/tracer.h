@@ -4,9 +4,14 @@
 #include <errno.h>
 #include <stdbool.h>
 
+#include "xrun/placement.h"
+#include "xrun/process.h"
+#include "xrun/recorder.h"
 #include "xrun/result.h"
 #include "xrun/utils/error.h"
 #include "xrun/utils/list.h"
+#include "xrun/utils/perf.h"
+#include "xrun/utils/pool.h"
 #include "xrun/utils/time.h"
 
 typedef struct xr_tracer_s xr_tracer_t;
@@ -19,6 +24,12 @@ typedef struct xr_process_s xr_process_t;
 typedef struct xr_thread_s xr_thread_t;
 typedef struct xr_checker_s xr_checker_t;
 typedef enum xr_checker_id_e xr_checker_id_t;
+typedef struct xr_stats_s xr_stats_t;
+typedef struct xr_sandbox_s xr_sandbox_t;
+typedef struct xr_sandbox_pool_s xr_sandbox_pool_t;
+typedef struct xr_workspace_s xr_workspace_t;
+typedef struct xr_workspace_pool_s xr_workspace_pool_t;
+typedef struct xr_capture_s xr_capture_t;
 
 typedef bool xr_tracer_op_spawn_f(xr_tracer_t *tracer, xr_entry_t *entry);
 
@@ -37,6 +48,11 @@ typedef bool xr_tracer_op_strcpy_f(xr_tracer_t *tracer, int pid, void *address,
 
 typedef void xr_tracer_op_kill_f(xr_tracer_t *tracer, int pid);
 
+typedef bool xr_tracer_op_sample_f(xr_tracer_t *tracer, xr_process_t *process);
+
+typedef bool xr_tracer_op_task_path_f(xr_tracer_t *tracer, int tid, int fd,
+                                      xr_path_t *path);
+
 typedef void xr_tracer_op_clean_f(xr_tracer_t *tracer);
 
 typedef void xr_tracer_op_delete_f(xr_tracer_t *tracer);
@@ -44,6 +60,9 @@ typedef void xr_tracer_op_delete_f(xr_tracer_t *tracer);
 typedef struct xr_trace_trap_syscall_s xr_trace_trap_syscall_t;
 struct xr_trace_trap_syscall_s {
   long syscall;
+  // syscall is in default abi, nr in the table of abi of tracee, which
+  // XR_CALLS_NAME takes along with that abi.
+  long nr;
 
   long args[7];
   long retval;
@@ -65,6 +84,9 @@ struct xr_trace_trap_s {
   };
 
   xr_thread_t *thread;
+  // made up by tracer rather than a stop of tracee, e.g. an overflow of perf
+  // counters or a deadline, which costs tracee nothing.
+  bool synthetic;
 };
 
 struct xr_tracer_s {
@@ -78,11 +100,17 @@ struct xr_tracer_s {
     xr_tracer_op_set_f *set;
     xr_tracer_op_strcpy_f *strcpy;
     xr_tracer_op_kill_f *kill;
+    // refresh time and memory of a live process
+    xr_tracer_op_sample_f *sample;
+    // resolve pwd or an opened directory of a live task
+    xr_tracer_op_task_path_f *task_path;
     xr_tracer_op_clean_f *clean;
     xr_tracer_op_delete_f *_delete;
   };
 
   void *tracer_data;
+  // whether syscalls trap on exit as well, or only on entry.
+  bool syscall_exit;
 
   xr_option_t *option;
   xr_checker_t *failed_checker;
@@ -91,21 +119,226 @@ struct xr_tracer_s {
   xr_list_t checkers;
   int nprocess;
   int nthread;
+  // process group of current run, which every tracee is spawned into, and
+  // terminal it has been given to as foreground group, or -1.
+  pid_t pgid;
+  int tty;
+  // pool of sandboxes owned by caller, NULL if tracees are not isolated, and
+  // sandbox of current run taken from it.
+  xr_sandbox_pool_t *sandboxes;
+  xr_sandbox_t *sandbox;
+  // pool of workspaces owned by caller, NULL if tracees run in pwd of entry,
+  // and workspace of current run, which replaces pwd of entry.
+  xr_workspace_pool_t *workspaces;
+  xr_workspace_t *workspace;
+  // cpus and scheduling of current run, as option->placement asks.
+  xr_placement_run_t placement;
+  // counters of current run, opened on its first tracee. Limited ones signal
+  // tracer thread rather than tracees, see xr_tracer_perf_trap.
+  xr_perf_t perf;
+  // tracee cpu time each stop costs in ns, 0 unless tracer is calibrated, and
+  // stops of current run, which are syscall and signal stops of tracees.
+  unsigned long long stop_ns;
+  unsigned long nstop;
+  // recent traps of all runs, always on.
+  xr_recorder_t recorder;
+  // capture of runs, NULL unless xr_capture_open succeeded.
+  xr_capture_t *capture;
+  // tasks are taken from and put back to pools, which live across traces.
+  xr_pool_t process_pool, thread_pool;
+
+  // latency of tracer stages, NULL unless xr_tracer_enable_stats succeeded.
+  xr_stats_t *stats;
 
   xr_error_t error;
 };
 
+bool xr_tracer_sample_proc(xr_tracer_t *tracer, xr_process_t *process);
+
+/**
+ * Resolve pwd or an opened directory of a task from /proc.
+ *
+ * @@tracer
+ * @tid task id
+ * @fd AT_FDCWD for pwd, or opened fd
+ * @path output path
+ */
+bool xr_tracer_task_path_proc(xr_tracer_t *tracer, int tid, int fd,
+                              xr_path_t *path);
+
 static inline void xr_tracer_init(xr_tracer_t *tracer, const char *name) {
   memset(tracer, 0, sizeof(xr_tracer_t));
   tracer->name = name;
+  tracer->sample = xr_tracer_sample_proc;
+  tracer->task_path = xr_tracer_task_path_proc;
   xr_error_init(&tracer->error);
+  tracer->tty = -1;
+  xr_placement_run_init(&tracer->placement);
+  xr_perf_init(&tracer->perf);
+  xr_recorder_init(&tracer->recorder);
   xr_list_init(&tracer->checkers);
   xr_list_init(&tracer->processes);
   xr_error_init(&tracer->error);
+  xr_pool_init(&tracer->process_pool, sizeof(xr_process_t));
+  xr_pool_init(&tracer->thread_pool, sizeof(xr_thread_t));
 }
 
+static inline xr_process_t *xr_tracer_new_process(xr_tracer_t *tracer) {
+  return (xr_process_t *)xr_pool_alloc(&tracer->process_pool);
+}
+
+static inline xr_thread_t *xr_tracer_new_thread(xr_tracer_t *tracer) {
+  return (xr_thread_t *)xr_pool_alloc(&tracer->thread_pool);
+}
+
+/**
+ * Delete process with its threads and put them back to pools of tracer.
+ *
+ * @@tracer
+ * @@process
+ */
+static inline void xr_tracer_free_process(xr_tracer_t *tracer,
+                                          xr_process_t *process) {
+  xr_process_delete(process, &tracer->thread_pool);
+  xr_pool_free(&tracer->process_pool, process);
+}
+
+/**
+ * Delete thread and put it back to pool of tracer.
+ *
+ * @@tracer
+ * @@thread
+ */
+static inline void xr_tracer_free_thread(xr_tracer_t *tracer,
+                                         xr_thread_t *thread) {
+  xr_thread_delete(thread);
+  xr_pool_free(&tracer->thread_pool, thread);
+}
+
+/**
+ * Take process group of spawned tracee as group of run, which is killed by
+ * one signal. If stdin of tracee is a terminal whose foreground group is the
+ * one of tracer, the run becomes foreground group until it is cleaned, so it
+ * is not stopped by SIGTTIN once it reads the terminal. Tracers call it
+ * after tracee joined its group, before it leaves execve.
+ *
+ * @@tracer
+ * @entry entry being spawned
+ * @pid pid of spawned tracee, which leads its group
+ */
+void xr_tracer_own_group(xr_tracer_t *tracer, xr_entry_t *entry, pid_t pid);
+
+/**
+ * Report an overflow of limited perf counters as a SIGXCPU stop of a tracee,
+ * as kernel reports RLIMIT_CPU. Overflows signal tracer thread, which
+ * interrupts its wait for traps, hence tracers call it before each wait and
+ * after a wait fails with EINTR. SIGXCPU is handled only while a run counts
+ * with limits, disposition of caller is restored after it.
+ *
+ * @@tracer
+ * @@trap
+ *
+ * @return true if counters overflowed since last call, trap is set then.
+ */
+bool xr_tracer_perf_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
 bool xr_tracer_add_checker(xr_tracer_t *tracer, xr_checker_id_t cid);
 
+/**
+ * Collect latency of tracer stages from now on, stats are kept across traces
+ * until tracer is deleted.
+ *
+ * @@tracer
+ *
+ * @return false if xrun is not configured with --enable-stats.
+ */
+bool xr_tracer_enable_stats(xr_tracer_t *tracer);
+
+/**
+ * Take cost of nstop stops off ns of cpu time.
+ *
+ * @@tracer
+ * @nstop stops of tracees which spent ns
+ * @ns cpu time of tracees
+ *
+ * @return ns less cost of stops, 0 at least.
+ */
+static inline unsigned long long xr_tracer_compensate_ns(
+  const xr_tracer_t *tracer, unsigned long nstop, unsigned long long ns) {
+  unsigned long long cost = nstop * tracer->stop_ns;
+  return ns > cost ? ns - cost : 0;
+}
+
+// stops cost tracees kernel time, which is sys time.
+static inline xr_time_t xr_tracer_compensate_time(const xr_tracer_t *tracer,
+                                                  unsigned long nstop,
+                                                  xr_time_t time) {
+  time.sys_time = xr_time_ms_from_ns(xr_tracer_compensate_ns(
+    tracer, nstop, time.sys_time * 1000000ull));
+  return time;
+}
+
+/**
+ * Measure tracee cpu time each stop costs into tracer->stop_ns. Entry is run
+ * natively and under tracer by turns, cost of a stop is then the extra cpu
+ * time of traced runs over their stops. Entry should be syscall heavy, and
+ * pass all checkers of tracer.
+ *
+ * @tracer tracer which has been setup
+ * @entry calibration tracee
+ *
+ * @return false if any run failed.
+ */
+bool xr_tracer_calibrate(xr_tracer_t *tracer, xr_entry_t *entry);
+
+/**
+ * Whether syscall creates a task.
+ *
+ * @syscall syscall number
+ */
+static inline bool xr_tracer_is_clone(int syscall) {
+  return
+#ifdef XR_SYSCALL_CLONE
+    syscall == XR_SYSCALL_CLONE ||
+#endif
+#ifdef XR_SYSCALL_FORK
+    syscall == XR_SYSCALL_FORK ||
+#endif
+#ifdef XR_SYSCALL_VFORK
+    syscall == XR_SYSCALL_VFORK ||
+#endif
+    false;
+}
+
+/**
+ * Whether syscall is clone3, which tracers fail with ENOSYS before checkers
+ * see it. Its flags are in tracee memory, where tracee can change them after
+ * they are checked, while libc falls back to clone, whose flags are in
+ * registers.
+ *
+ * @syscall syscall number
+ */
+static inline bool xr_tracer_is_clone3(int syscall) {
+#ifdef XR_SYSCALL_CLONE3
+  return syscall == XR_SYSCALL_CLONE3;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Take flags of clone, fork or vfork into thread->clone_flags on its entry
+ * trap, with exit signal in the lowest byte as clone does. Tracers call it on
+ * entry traps before checkers, hence fork checker and clone events use the
+ * same flags.
+ *
+ * @@tracer
+ * @trap entry trap of a syscall
+ *
+ * @return false if syscall of trap does not create a task.
+ */
+bool xr_tracer_take_clone_flags(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
 bool xr_tracer_trace(xr_tracer_t *tracer, xr_entry_t *entry,
                      xr_result_t *result);
 
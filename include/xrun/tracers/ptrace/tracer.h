@@ -31,6 +31,14 @@ void xr_ptrace_tracer_clean(xr_tracer_t *tracer);
 
 void xr_ptrace_tracer_delete(xr_tracer_t *tracer);
 
+/**
+ * init a tracer on ptrace, which stops tracees on entry and exit of every
+ * syscall. Calling process becomes a child subreaper for good, so tracees
+ * orphaned in a run are reaped by tracer rather than init.
+ *
+ * @tracer tracer to init
+ * @name name of tracer
+ */
 void xr_tracer_ptrace_init(xr_tracer_t *tracer, const char *name);
 
 #endif
@@ -0,0 +1,68 @@
+#ifndef _XR_REPLAY_TRACER
+#define _XR_REPLAY_TRACER
+
+#include <stdbool.h>
+
+#include "xrun/entry.h"
+#include "xrun/tracer.h"
+#include "xrun/utils/string.h"
+
+typedef struct xr_tracer_s xr_tracer_t;
+typedef struct xr_trace_trap_s xr_trace_trap_t;
+
+bool xr_replay_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry);
+
+bool xr_replay_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
+bool xr_replay_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
+bool xr_replay_tracer_get(xr_tracer_t *tracer, int pid, void *address,
+                          void *buffer, size_t size);
+
+bool xr_replay_tracer_set(xr_tracer_t *tracer, int pid, void *address,
+                          const void *buffer, size_t size);
+
+bool xr_replay_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                             xr_string_t *str);
+
+bool xr_replay_tracer_task_path(xr_tracer_t *tracer, int tid, int fd,
+                                xr_path_t *path);
+
+void xr_replay_tracer_kill(xr_tracer_t *tracer, pid_t pid);
+
+void xr_replay_tracer_clean(xr_tracer_t *tracer);
+
+void xr_replay_tracer_delete(xr_tracer_t *tracer);
+
+/**
+ * init a tracer which feeds runs of a capture to checkers again, instead of
+ * running tracees. Entry of a trace is ignored, each trace replays the next
+ * captured run, and wraps around after the last one. Time and memory of
+ * tracees are not captured, hence they are always 0.
+ *
+ * @tracer tracer to init
+ * @name name of tracer
+ */
+void xr_tracer_replay_init(xr_tracer_t *tracer, const char *name);
+
+/**
+ * Load runs to replay, it should be called before tracer is setup.
+ *
+ * @tracer tracer inited by xr_tracer_replay_init
+ * @path capture written by xr_capture_open
+ *
+ * @return false if capture can not be read, or it has no run.
+ */
+bool xr_tracer_replay_load(xr_tracer_t *tracer, const char *path);
+
+/**
+ * Status which the run replayed last had when it was captured.
+ *
+ * @@tracer
+ *
+ * @return XR_RESULT_UNKNOWN if no run is replayed yet, or the captured one
+ * did not end.
+ */
+xr_tracer_code_t xr_tracer_replay_expect(xr_tracer_t *tracer);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _XR_SECCOMP_TRACER
+#define _XR_SECCOMP_TRACER
+
+#include <stdbool.h>
+
+#include "xrun/entry.h"
+#include "xrun/tracer.h"
+#include "xrun/utils/string.h"
+
+typedef struct xr_tracer_s xr_tracer_t;
+typedef struct xr_trace_trap_s xr_trace_trap_t;
+
+bool xr_seccomp_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry);
+
+bool xr_seccomp_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
+bool xr_seccomp_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap);
+
+bool xr_seccomp_tracer_get(xr_tracer_t *tracer, int pid, void *address,
+                           void *buffer, size_t size);
+
+bool xr_seccomp_tracer_set(xr_tracer_t *tracer, int pid, void *address,
+                           const void *buffer, size_t size);
+
+bool xr_seccomp_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                              xr_string_t *str);
+
+void xr_seccomp_tracer_kill(xr_tracer_t *tracer, pid_t pid);
+
+void xr_seccomp_tracer_clean(xr_tracer_t *tracer);
+
+void xr_seccomp_tracer_delete(xr_tracer_t *tracer);
+
+/**
+ * init a tracer on seccomp user notification. Only syscalls which are
+ * forbidden or watched by checkers trap, and they trap on entry only.
+ * Permitted syscalls are continued with SECCOMP_USER_NOTIF_FLAG_CONTINUE,
+ * and kernel reads their args from tracee memory again, so checks on memory
+ * like paths are advisory: another thread may change them in between. Only
+ * numbers in registers, like flags of clone(2), are checked for sure.
+ *
+ * Calling process becomes a child subreaper for good, so tracees orphaned
+ * in a run are reaped by tracer rather than init.
+ *
+ * @tracer tracer to init
+ * @name name of tracer
+ */
+void xr_tracer_seccomp_init(xr_tracer_t *tracer, const char *name);
+
+#endif
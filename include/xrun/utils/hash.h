@@ -0,0 +1,156 @@
+#ifndef XR_HASH_H
+#define XR_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xrun/utils/list.h"
+
+// buckets allocated on first insertion, always a power of 2.
+#define XR_HASH_DEFAULT_BUCKET 64
+
+typedef struct xr_hash_node_s xr_hash_node_t;
+typedef struct xr_hash_s xr_hash_t;
+
+/*
+ * node embedded in an entry of hash, like xr_list_t. Use xr_hash_entry to get
+ * the entry back from its node.
+ */
+struct xr_hash_node_s {
+  int key;
+  xr_hash_node_t *next;
+};
+
+/*
+ * chained hash table keyed by int, e.g. pid or tid. Entries are owned by
+ * caller, hash only links their nodes. Table doubles once it holds more
+ * entries than buckets, and never shrinks until deleted.
+ */
+struct xr_hash_s {
+  xr_hash_node_t **buckets;
+  size_t nbucket, size;
+};
+
+#define xr_hash_entry(node, type, member) xr_list_entry(node, type, member)
+
+// fibonacci hashing spreads sequential keys such as tids over buckets.
+static inline size_t xr_hash_bucket(const xr_hash_t *hash, int key) {
+  return ((unsigned)key * 2654435769u) & (hash->nbucket - 1);
+}
+
+static inline void xr_hash_init(xr_hash_t *hash) {
+  hash->buckets = NULL;
+  hash->nbucket = hash->size = 0;
+}
+
+static inline bool xr_hash_grow(xr_hash_t *hash, size_t nbucket) {
+  xr_hash_node_t **buckets = calloc(nbucket, sizeof(xr_hash_node_t *));
+  if (buckets == NULL) {
+    return false;
+  }
+  xr_hash_t grown = {.buckets = buckets, .nbucket = nbucket};
+  for (size_t i = 0; i < hash->nbucket; ++i) {
+    xr_hash_node_t *node = hash->buckets[i], *next;
+    for (; node != NULL; node = next) {
+      next = node->next;
+      size_t bucket = xr_hash_bucket(&grown, node->key);
+      node->next = buckets[bucket];
+      buckets[bucket] = node;
+    }
+  }
+  free(hash->buckets);
+  hash->buckets = buckets;
+  hash->nbucket = nbucket;
+  return true;
+}
+
+/**
+ * Find entry by key.
+ *
+ * @@hash
+ * @key key of entry
+ *
+ * @return node of entry, or NULL if no entry has key.
+ */
+static inline xr_hash_node_t *xr_hash_find(const xr_hash_t *hash, int key) {
+  if (hash->size == 0) {
+    return NULL;
+  }
+  xr_hash_node_t *node = hash->buckets[xr_hash_bucket(hash, key)];
+  while (node != NULL && node->key != key) {
+    node = node->next;
+  }
+  return node;
+}
+
+/**
+ * Link node into hash, node->key should be set and not be in hash yet.
+ *
+ * @@hash
+ * @node node of entry
+ *
+ * @return false if buckets can not be allocated.
+ */
+static inline bool xr_hash_insert(xr_hash_t *hash, xr_hash_node_t *node) {
+  if (hash->size >= hash->nbucket &&
+      xr_hash_grow(hash, hash->nbucket ? hash->nbucket * 2
+                                       : XR_HASH_DEFAULT_BUCKET) == false) {
+    return false;
+  }
+  size_t bucket = xr_hash_bucket(hash, node->key);
+  node->next = hash->buckets[bucket];
+  hash->buckets[bucket] = node;
+  hash->size++;
+  return true;
+}
+
+/**
+ * Unlink entry by key.
+ *
+ * @@hash
+ * @key key of entry
+ *
+ * @return node of removed entry, or NULL if no entry has key.
+ */
+static inline xr_hash_node_t *xr_hash_remove(xr_hash_t *hash, int key) {
+  if (hash->size == 0) {
+    return NULL;
+  }
+  xr_hash_node_t **link = &hash->buckets[xr_hash_bucket(hash, key)];
+  while (*link != NULL && (*link)->key != key) {
+    link = &(*link)->next;
+  }
+  xr_hash_node_t *node = *link;
+  if (node != NULL) {
+    *link = node->next;
+    hash->size--;
+  }
+  return node;
+}
+
+/**
+ * Unlink all entries, buckets are kept for reuse.
+ *
+ * @@hash
+ */
+static inline void xr_hash_clear(xr_hash_t *hash) {
+  if (hash->buckets != NULL) {
+    memset(hash->buckets, 0, hash->nbucket * sizeof(xr_hash_node_t *));
+  }
+  hash->size = 0;
+}
+
+static inline void xr_hash_delete(xr_hash_t *hash) {
+  free(hash->buckets);
+  xr_hash_init(hash);
+}
+
+// node may be unlinked or freed in body, but hash must not be modified else.
+#define _xr_hash_for_each_safe(hash, i, cur, temp)                \
+  for (i = 0; i < (hash)->nbucket; ++i)                           \
+    for (cur = (hash)->buckets[i], temp = cur ? cur->next : NULL; \
+         cur != NULL; cur = temp, temp = cur ? cur->next : NULL)
+
+#endif
@@ -46,68 +46,68 @@ static inline bool xr_path_contains(xr_path_t *parent, xr_path_t *child) {
   return child->string[parent->length] == '/';
 }
 
-#define __xr_path_is_parent_dir(path, anchor) \
-  ((path)->string[anchor + 1] == '.' && (path)->string[anchor + 2] == '.')
-
 /*
- * A stupid implementation of finding absolute path. Result is stored in path.
+ * Normalize path in place: drop "." and empty levels, fold ".." into its
+ * parent and clamp ".." at root for absolute paths. A relative path keeps the
+ * leading ".." levels that can not be folded. Levels are located with memchr,
+ * and every byte is copied at most once, so it runs in a single pass.
  *
  * @@path
  */
 static inline void xr_path_abs(xr_path_t *path) {
-  size_t abs_end = 0, prev_slash = 0;
-  for (size_t i = 0; i < path->length; ++i) {
-    if (path->string[i] == '/') {
-      prev_slash = i;
-      if (prev_slash == 1 && path->string[0] == '.') {
-        // path is ./xxxx
-        abs_end = 0;
-      } else {
-        // path is /xxx or xxx/xxx
-        abs_end = prev_slash + 1;
-      }
+  if (path->length == 0) {
+    return;
+  }
+  char *const base = path->string;
+  const char *cur = base, *const end = base + path->length;
+  const bool absolute = base[0] == '/';
+  // out is the end of normalized levels, levels before floor can not be
+  // folded anymore, which are root or leading ".." of a relative path.
+  char *out = base + absolute, *floor = out;
+  while (cur < end) {
+    while (cur < end && *cur == '/') {
+      cur++;
+    }
+    if (cur == end) {
       break;
     }
-  }
-  for (size_t i = prev_slash; i <= path->length; ++i) {
-    const size_t level_length = i - prev_slash;
-    if (path->string[i] != '/' && path->string[i] != 0) {
-      continue;
-    } else if ((level_length == 2 && path->string[prev_slash + 1] == '.') ||
-               level_length == 1) {
-      // multiple slash or ./ should be skipped.
-      prev_slash = i;
-      continue;
-    } else if ((level_length == 3 &&
-                __xr_path_is_parent_dir(path, prev_slash)) &&
-               (abs_end != 0 || abs_end != 1 ||
-                strncmp(path->string + abs_end - 2, "..", 2))) {
-      // current level is ../ and can go to parent.
-      //
-      // at top (abs_end == 0), at root (abs_end == 1) and at relative parent
-      // (../) can not go to parent.
-      for (size_t j = abs_end - 1; j >= 0; --j) {
-        if (j <= 1) {
-          abs_end = 0;
-        }
-        if (path->string[j - 1] == '/') {
-          abs_end = j;
-          break;
-        }
+    const char *next = (const char *)memchr(cur, '/', end - cur);
+    if (next == NULL) {
+      next = end;
+    }
+    const size_t level_length = next - cur;
+    const bool parent = level_length == 2 && cur[0] == '.' && cur[1] == '.';
+    if (level_length == 1 && cur[0] == '.') {
+      // "." keeps current level.
+    } else if (parent && absolute && out == floor) {
+      // ".." of root is root itself.
+    } else if (parent && out != floor) {
+      // fold the last level, along with the slash in front of it.
+      while (out != floor && *(out - 1) != '/') {
+        out--;
+      }
+      if (out != floor) {
+        out--;
       }
     } else {
-      // keep current level and copy it.
-      if (abs_end != prev_slash + 1) {
-        for (size_t j = 0; j < level_length; ++j) {
-          path->string[abs_end + j] = path->string[prev_slash + j + 1];
-        }
+      if (out != base + absolute) {
+        *out++ = '/';
+      }
+      memmove(out, cur, level_length);
+      out += level_length;
+      if (parent) {
+        // ".." at top of a relative path.
+        floor = out;
       }
-      abs_end += level_length;
     }
-    prev_slash = i;
+    cur = next;
+  }
+  if (out == base) {
+    // relative path which is folded to nothing.
+    *out++ = '.';
   }
-  path->string[abs_end] = 0;
-  path->length = abs_end - 1;
+  *out = 0;
+  path->length = out - base;
 }
 
 #endif
@@ -0,0 +1,77 @@
+#ifndef XR_PERF_H
+#define XR_PERF_H
+
+#include <limits.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+// a limit of counts which is never reached.
+#define XR_PERF_UNLIMITED ULLONG_MAX
+// count of a counter which is not opened.
+#define XR_PERF_UNAVAILABLE ULLONG_MAX
+
+typedef struct xr_perf_count_s xr_perf_count_t;
+typedef struct xr_perf_s xr_perf_t;
+
+/*
+ * counts of a run, which are limits of counters as well.
+ */
+struct xr_perf_count_s {
+  // ns tasks ran on cpus, in user and kernel mode
+  unsigned long long task_clock;
+  // instructions tasks retired in user mode, which needs a PMU
+  unsigned long long instructions;
+};
+
+/*
+ * perf_event counters of a task and its descendants. Counters are inherited
+ * by tasks it forks after they are opened, and counts of inherited counters
+ * are summed up into the counter of the task.
+ */
+struct xr_perf_s {
+  // fds of counters, -1 if counter is not opened
+  int task_clock, instructions;
+};
+
+static inline void xr_perf_init(xr_perf_t *perf) {
+  perf->task_clock = perf->instructions = -1;
+}
+
+static inline bool xr_perf_opened(const xr_perf_t *perf) {
+  return perf->task_clock != -1;
+}
+
+/**
+ * Open counters of task pid, which should not have forked yet. Task clock is
+ * always opened, instructions if a PMU is available or it is limited.
+ *
+ * A limited counter sends signal to thread owner once a task exceeds the
+ * limit, with POLL_IN as si_code. Counts of tasks overflow one by one, hence a
+ * run of many tasks may exceed the limit in total before any of them does,
+ * xr_perf_exceeded tells that.
+ *
+ * @@perf
+ * @pid task to count
+ * @limit limits of counters, XR_PERF_UNLIMITED for none
+ * @owner thread signaled once a limit is exceeded
+ * @signal signal sent to owner
+ *
+ * @return false if task clock, or limited instructions can not be opened.
+ */
+bool xr_perf_open(xr_perf_t *perf, pid_t pid, const xr_perf_count_t *limit,
+                  pid_t owner, int signal);
+
+/**
+ * Read counts of task and its descendants, both alive and exited.
+ *
+ * @@perf
+ * @count XR_PERF_UNAVAILABLE for counters which are not opened.
+ */
+void xr_perf_read(xr_perf_t *perf, xr_perf_count_t *count);
+
+bool xr_perf_exceeded(const xr_perf_count_t *count,
+                      const xr_perf_count_t *limit);
+
+void xr_perf_close(xr_perf_t *perf);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef XR_POOL_H
+#define XR_POOL_H
+
+#include <stdlib.h>
+
+// objects are aligned to cache line, hence no two objects share a line.
+#define XR_POOL_ALIGN 64
+// objects allocated at once when pool runs out of free objects.
+#define XR_POOL_SLAB 32
+
+typedef struct xr_pool_s xr_pool_t;
+
+/*
+ * free list of fixed size objects, which are carved from slabs. Objects are
+ * never returned to system until pool is deleted, hence a tracer reused for
+ * many runs stops allocating once its pools are large enough.
+ */
+struct xr_pool_s {
+  // size of objects rounded up to XR_POOL_ALIGN
+  size_t size;
+  // free objects and slabs, linked by their first pointer
+  void *free, *slabs;
+  // slabs allocated so far
+  size_t nslab;
+};
+
+static inline void xr_pool_init(xr_pool_t *pool, size_t size) {
+  pool->size = (size + XR_POOL_ALIGN - 1) & ~(size_t)(XR_POOL_ALIGN - 1);
+  pool->free = pool->slabs = NULL;
+  pool->nslab = 0;
+}
+
+static inline void xr_pool_grow(xr_pool_t *pool) {
+  void *slab = NULL;
+  // slab header takes a whole line to keep objects aligned.
+  if (posix_memalign(&slab, XR_POOL_ALIGN,
+                     XR_POOL_ALIGN + pool->size * XR_POOL_SLAB) != 0) {
+    return;
+  }
+  *(void **)slab = pool->slabs;
+  pool->slabs = slab;
+  pool->nslab++;
+  char *object = (char *)slab + XR_POOL_ALIGN;
+  for (int i = 0; i < XR_POOL_SLAB; ++i, object += pool->size) {
+    *(void **)object = pool->free;
+    pool->free = object;
+  }
+}
+
+/**
+ * Take an object from pool, whose content is undefined.
+ *
+ * @@pool
+ *
+ * @return NULL if pool is empty and a new slab can not be allocated.
+ */
+static inline void *xr_pool_alloc(xr_pool_t *pool) {
+  if (pool->free == NULL) {
+    xr_pool_grow(pool);
+    if (pool->free == NULL) {
+      return NULL;
+    }
+  }
+  void *object = pool->free;
+  pool->free = *(void **)object;
+  return object;
+}
+
+/**
+ * Put object back to pool it was taken from.
+ *
+ * @@pool
+ * @object object from xr_pool_alloc, NULL is ignored
+ */
+static inline void xr_pool_free(xr_pool_t *pool, void *object) {
+  if (object == NULL) {
+    return;
+  }
+  *(void **)object = pool->free;
+  pool->free = object;
+}
+
+/**
+ * Release all slabs, objects taken from pool are invalid afterwards.
+ *
+ * @@pool
+ */
+static inline void xr_pool_delete(xr_pool_t *pool) {
+  while (pool->slabs != NULL) {
+    void *slab = pool->slabs;
+    pool->slabs = *(void **)slab;
+    free(slab);
+  }
+  pool->free = NULL;
+  pool->nslab = 0;
+}
+
+#endif
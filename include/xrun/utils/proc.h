@@ -0,0 +1,90 @@
+#ifndef XR_PROC_H
+#define XR_PROC_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "xrun/utils/time.h"
+
+/**
+ * Sample cpu time and peak resident memory of a thread group from /proc,
+ * as wait4 reports them for an exited child. Time of reaped children is not
+ * included, they are sampled as processes of their own. Time is counted in
+ * clock ticks, which is good for checks during a run, final usage is taken
+ * from wait4 on exit.
+ *
+ * @pid pid of thread group leader
+ * @time user and sys time in ms
+ * @memory peak resident memory in KB, kept if it is not available
+ *
+ * @return false if process is gone or /proc is not mounted.
+ */
+bool xr_proc_sample(pid_t pid, xr_time_t *time, int *memory);
+
+/**
+ * Sample cpu time of a thread group in ns, which scheduler accounts for all
+ * of its threads, exited ones included. It falls back to the sum of
+ * /proc/pid/task/tid/schedstat of live threads if cpu clock of pid can not be
+ * read.
+ *
+ * @pid pid of thread group leader, which may be a zombie
+ * @ns kept if it is not available
+ *
+ * @return false if process is gone.
+ */
+bool xr_proc_cpu_ns(pid_t pid, unsigned long long *ns);
+
+/**
+ * Sample how many times a task moved between cpus, from /proc/tid/sched.
+ *
+ * @tid a thread, or leader of a thread group
+ * @nmigration kept if it is not available, e.g. without CONFIG_SCHED_DEBUG
+ *
+ * @return false if task is gone or its sched file is missing.
+ */
+bool xr_proc_nmigration(pid_t tid, long *nmigration);
+
+/**
+ * Read the syscall a task is blocked in, from /proc/tid/syscall.
+ *
+ * @tid task id
+ * @nr number of syscall, or -1 if task is blocked outside of a syscall
+ *
+ * @return false if task is gone or running, which tells nothing.
+ */
+bool xr_proc_syscall(pid_t tid, long *nr);
+
+/**
+ * Read which task traces a task, from TracerPid of /proc/tid/status. It is
+ * kept for a zombie until its tracer reaps it.
+ *
+ * @tid task id
+ * @tracer tid of tracer, 0 if task is not traced
+ *
+ * @return false if task is gone.
+ */
+bool xr_proc_tracer(pid_t tid, pid_t *tracer);
+
+/**
+ * List children forked by a task, oldest first, from
+ * /proc/tid/task/tid/children, which needs CONFIG_PROC_CHILDREN.
+ *
+ * @tid task id
+ * @pids output, grown by realloc as needed
+ * @capacity capacity of pids
+ *
+ * @return number of children, or -1 if task is gone.
+ */
+int xr_proc_children(pid_t tid, pid_t **pids, int *capacity);
+
+/**
+ * Sample time hypervisor ran other guests on cpus of host, summed up over
+ * all cpus, from /proc/stat.
+ *
+ * @ns steal time in ns, of tick resolution
+ *
+ * @return false if /proc is not mounted.
+ */
+bool xr_proc_steal_ns(unsigned long long *ns);
+
+#endif
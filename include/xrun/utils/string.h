@@ -131,10 +131,10 @@ static inline void xr_string_vformat(xr_string_t *str, const char *format,
   }
   va_list retry;
   va_copy(retry, args);
-  int wrote = vsnprintf(str->string, str->capacity - 1, format, args);
+  int wrote = vsnprintf(str->string, str->capacity, format, args);
   if (wrote >= str->capacity) {
     xr_string_grow(str, wrote + 1);
-    vsnprintf(str->string, str->capacity - 1, format, retry);
+    vsnprintf(str->string, str->capacity, format, retry);
   }
   str->length = wrote;
   str->string[str->length] = 0;
@@ -2,6 +2,7 @@
 #define XR_TIME_H
 
 #include <sys/time.h>
+#include <time.h>
 
 typedef unsigned long xr_time_ms_t;
 
@@ -16,6 +17,16 @@ static inline xr_time_ms_t xr_time_ms_from_timeval(struct timeval timeval) {
   return timeval.tv_sec * 1000 + timeval.tv_usec / 1000;
 }
 
+static inline xr_time_ms_t xr_time_ms_from_ns(unsigned long long ns) {
+  return ns / 1000000;
+}
+
+static inline unsigned long long xr_time_now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
 static inline xr_time_t xr_time_from_timeval(struct timeval sys_time,
                                              struct timeval user_time) {
   xr_time_t time = {
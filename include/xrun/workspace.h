@@ -0,0 +1,114 @@
+#ifndef XR_WORKSPACE_H
+#define XR_WORKSPACE_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "xrun/utils/list.h"
+#include "xrun/utils/path.h"
+
+// workspaces kept warm by default.
+#define XR_WORKSPACE_DEFAULT_WARM 2
+
+typedef struct xr_workspace_s xr_workspace_t;
+typedef struct xr_workspace_pool_s xr_workspace_pool_t;
+
+/*
+ * a working directory of one run. It is a tmpfs mounted at base/id, or an
+ * overlay of lower dir mounted at base/id/merged, whose upper and work dirs
+ * live in the tmpfs. Size of tmpfs is the quota of workspace either way.
+ */
+struct xr_workspace_s {
+  unsigned id;
+  // mount of tmpfs, and pwd of tracees
+  xr_path_t mount, path;
+  xr_workspace_pool_t *pool;
+  xr_list_t workspaces;
+};
+
+/*
+ * workspaces mounted ahead of runs. A used workspace is reset by a background
+ * thread, which unmounts it, hence the kernel drops what tracees wrote there,
+ * and mounts an empty tmpfs in its place. The thread runs as SCHED_IDLE.
+ *
+ * base is bind mounted on itself with shared propagation, so sandboxes built
+ * after pool init see workspaces mounted later.
+ */
+struct xr_workspace_pool_s {
+  xr_path_t base, lower;
+  // bytes of each workspace, 0 for default size of tmpfs
+  size_t quota;
+  // owner of workspaces, which is caller as tracees run as it.
+  uid_t uid;
+  gid_t gid;
+  size_t nwarm;
+  unsigned nworkspace;
+
+  pthread_t thread;
+  pthread_mutex_t lock;
+  // ready is signaled once a workspace is ready or mounting fails, dirty once
+  // a workspace is used or taken.
+  pthread_cond_t ready, dirty;
+  xr_list_t warm, used;
+  size_t nready, nwaiting;
+  bool failed, stop;
+};
+
+/**
+ * Mount base on itself and start background thread, which mounts nwarm
+ * workspaces right away. It needs CAP_SYS_ADMIN.
+ *
+ * @@pool
+ * @base directory of workspaces, created if missing. It should be at the same
+ *       path under root of entries.
+ * @lower lower dir of overlay workspaces, NULL for plain tmpfs ones
+ * @quota bytes of each workspace, 0 for default size of tmpfs
+ * @nwarm workspaces kept ready, 0 to mount one only when it is taken
+ *
+ * @return false if base can not be mounted or thread can not be started.
+ */
+bool xr_workspace_pool_init(xr_workspace_pool_t *pool, const char *base,
+                            const char *lower, size_t quota, size_t nwarm);
+
+/**
+ * Take an empty workspace, wait for one if none is ready.
+ *
+ * @@pool
+ *
+ * @return NULL if mounting a workspace failed.
+ */
+xr_workspace_t *xr_workspace_pool_take(xr_workspace_pool_t *pool);
+
+/**
+ * Give back a workspace after its run, background thread resets it.
+ *
+ * @@pool
+ * @@workspace
+ */
+void xr_workspace_pool_put(xr_workspace_pool_t *pool,
+                           xr_workspace_t *workspace);
+
+/**
+ * Stop background thread, then unmount all workspaces and base. Workspaces
+ * taken from pool should have been put back.
+ *
+ * @@pool
+ */
+void xr_workspace_pool_delete(xr_workspace_pool_t *pool);
+
+/**
+ * Check whether path is workspace or under it. Tracees may open anything
+ * there with any flags, whatever access lists of option say.
+ *
+ * @@workspace
+ * @@path
+ */
+static inline bool xr_workspace_contains(xr_workspace_t *workspace,
+                                         xr_path_t *path) {
+  return xr_string_equal(&workspace->path, path) ||
+         xr_path_contains(&workspace->path, path);
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef XRN_BENCH_H
+#define XRN_BENCH_H
+
+#include <stdbool.h>
+
+#include "xrun/entry.h"
+#include "xrun/result.h"
+#include "xrun/tracer.h"
+#include "xrun/utils/string.h"
+
+#define XRN_BENCH_DEFAULT_RUN 10
+#define XRN_REPEAT_STABLE_MAX 200
+
+typedef struct xrn_repeat_s xrn_repeat_t;
+struct xrn_repeat_s {
+  // measured runs, and runs before them which are not measured.
+  long nrun, warmup;
+  // keep running until coefficient of variation of cpu time drops below it,
+  // at most XRN_REPEAT_STABLE_MAX runs. 0 to disable.
+  double stable;
+  // XR_RESULT_NPROFILE entries for syscall profile of each measured run,
+  // NULL to disable.
+  xr_result_call_t *profile;
+};
+
+/**
+ * Report of a traced run of xrn_repeat.
+ *
+ * @tracer tracer of run, which has error if traced is false
+ * @result result of run
+ * @traced return value of xr_tracer_trace
+ * @ctx context passed to xrn_repeat
+ */
+typedef void xrn_repeat_report_f(xr_tracer_t *tracer, xr_result_t *result,
+                                 bool traced, void *ctx);
+
+/**
+ * Run entry natively and under tracer by turns, then print wall time, cpu
+ * time, peak rss and traps of each syscall with ratios of traced to native
+ * and their 95% confidence intervals.
+ *
+ * @tracer tracer which has been setup
+ * @entry entry to run
+ * @repeat runs of each mode, stable is ignored
+ * @error error message if a run failed
+ *
+ * @return false if any run failed.
+ */
+bool xrn_bench(xr_tracer_t *tracer, xr_entry_t *entry,
+               const xrn_repeat_t *repeat, xr_string_t *error);
+
+/**
+ * Run entry under tracer repeatedly, then print min, median, p90, p99, mean
+ * and stddev of wall time, cpu time and peak rss, and runs which are outliers
+ * by MAD.
+ *
+ * @tracer tracer which has been setup
+ * @entry entry to run
+ * @@repeat
+ * @report called after each measured run
+ * @ctx context of report
+ */
+void xrn_repeat(xr_tracer_t *tracer, xr_entry_t *entry,
+                const xrn_repeat_t *repeat, xrn_repeat_report_f *report,
+                void *ctx);
+
+#endif
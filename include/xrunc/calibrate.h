@@ -0,0 +1,35 @@
+#ifndef XRN_CALIBRATE_H
+#define XRN_CALIBRATE_H
+
+#include <stdbool.h>
+
+#include "xrun/tracer.h"
+#include "xrun/utils/string.h"
+
+// argv[1] which makes xrun run as calibration tracee.
+#define XRN_CALIBRATION_TRACEE "calibration-tracee"
+// openat and close pairs calibration tracee calls.
+#define XRN_CALIBRATION_NCALL 2000
+
+/**
+ * Body of calibration tracee, which is xrun itself. It calls cheap syscalls
+ * only, hence nearly all of its cpu time beyond a native run is cost of
+ * stops.
+ *
+ * @return exit code of tracee.
+ */
+int xrn_calibration_tracee();
+
+/**
+ * Calibrate stop cost of tracer with calibration tracee, under a tracer of
+ * the same kind and placement, which allows everything tracee does.
+ *
+ * @tracer tracer which has been setup, its stop_ns is set
+ * @seccomp whether tracer is the seccomp one
+ * @error error message if calibration failed
+ *
+ * @return false if any calibration run failed.
+ */
+bool xrn_calibrate(xr_tracer_t *tracer, bool seccomp, xr_string_t *error);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef XRN_STATS_H
+#define XRN_STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct xrn_stats_s xrn_stats_t;
+
+/*
+ * summary of samples of one metric, e.g. wall time of runs.
+ */
+struct xrn_stats_s {
+  size_t n;
+  double mean, stddev, min, max;
+  double median, p90, p99;
+  // median and mean absolute deviation from median
+  double mad, meanad;
+};
+
+/**
+ * Summarize samples.
+ *
+ * @stats summary to fill
+ * @samples samples of a metric
+ * @n number of samples
+ */
+void xrn_stats_compute(xrn_stats_t *stats, const double *samples, size_t n);
+
+/**
+ * Coefficient of variation of samples.
+ *
+ * @@stats
+ *
+ * @return stddev / mean, or 0 if mean is 0.
+ */
+double xrn_stats_cv(const xrn_stats_t *stats);
+
+/**
+ * Examine sample with modified z-score of Iglewicz and Hoaglin, which is
+ * based on median and MAD and hence is not skewed by the outliers.
+ *
+ * @@stats
+ * @sample sample to examine
+ *
+ * @return true if modified z-score of sample is greater than 3.5.
+ */
+bool xrn_stats_outlier(const xrn_stats_t *stats, double sample);
+
+/**
+ * Two sided 95% critical value of student t distribution.
+ *
+ * @df degrees of freedom
+ */
+double xrn_stats_t95(size_t df);
+
+/**
+ * Half width of 95% confidence interval of mean.
+ *
+ * @@stats
+ */
+double xrn_stats_ci95(const xrn_stats_t *stats);
+
+/**
+ * 95% confidence interval of ratio of means num / den, by delta method on
+ * two independent samples.
+ *
+ * @num summary of numerator
+ * @den summary of denominator
+ * @lo lower bound of ratio
+ * @hi upper bound of ratio
+ *
+ * @return ratio of means, or 0 if mean of den is 0.
+ */
+double xrn_stats_ratio_ci95(const xrn_stats_t *num, const xrn_stats_t *den,
+                            double *lo, double *hi);
+
+#endif
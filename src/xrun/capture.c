@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "xrun/capture.h"
+#include "xrun/process.h"
+
+// a tid whose task is recorded.
+struct xr_capture_tid_s {
+  xr_hash_node_t node;
+};
+typedef struct xr_capture_tid_s xr_capture_tid_t;
+
+static inline void xr_capture_write(xr_capture_t *capture,
+                                    xr_capture_kind_t kind, const void *payload,
+                                    size_t size, const void *tail,
+                                    size_t ntail) {
+  xr_capture_record_t record = {.kind = kind, .size = size + ntail};
+  fwrite(&record, sizeof(record), 1, capture->file);
+  if (size != 0) {
+    fwrite(payload, size, 1, capture->file);
+  }
+  if (ntail != 0) {
+    fwrite(tail, ntail, 1, capture->file);
+  }
+}
+
+static inline void xr_capture_memory(xr_capture_t *capture, int tid,
+                                     xr_capture_op_t op, unsigned long address,
+                                     bool ok, const void *buffer,
+                                     size_t size) {
+  xr_capture_memory_t memory;
+  memset(&memory, 0, sizeof(memory));
+  memory.tid = tid;
+  memory.op = op;
+  memory.address = address;
+  memory.ok = ok;
+  xr_capture_write(capture, XR_CAPTURE_MEMORY, &memory, sizeof(memory), buffer,
+                   ok ? size : 0);
+}
+
+static bool xr_capture_get(xr_tracer_t *tracer, int pid, void *address,
+                           void *buffer, size_t size) {
+  xr_capture_t *capture = tracer->capture;
+  bool ok = capture->get(tracer, pid, address, buffer, size);
+  xr_capture_memory(capture, pid, XR_CAPTURE_GET, (unsigned long)address, ok,
+                    buffer, size);
+  return ok;
+}
+
+static bool xr_capture_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                              xr_string_t *str) {
+  xr_capture_t *capture = tracer->capture;
+  bool ok = capture->strcpy(tracer, pid, address, str);
+  xr_capture_memory(capture, pid, XR_CAPTURE_STRCPY, (unsigned long)address,
+                    ok, str->string, str->length);
+  return ok;
+}
+
+static bool xr_capture_task_path(xr_tracer_t *tracer, int tid, int fd,
+                                 xr_path_t *path) {
+  xr_capture_t *capture = tracer->capture;
+  bool ok = capture->task_path(tracer, tid, fd, path);
+  xr_capture_memory(capture, tid, XR_CAPTURE_TASK_PATH, fd, ok, path->string,
+                    path->length);
+  return ok;
+}
+
+bool xr_capture_open(xr_capture_t *capture, xr_tracer_t *tracer,
+                     const char *path) {
+  capture->file = fopen(path, "we");
+  if (capture->file == NULL) {
+    return false;
+  }
+  xr_capture_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, XR_CAPTURE_MAGIC, XR_CAPTURE_MAGIC_SIZE);
+  header.syscall_exit = tracer->syscall_exit;
+  fwrite(&header, sizeof(header), 1, capture->file);
+  xr_hash_init(&capture->tids);
+  xr_pool_init(&capture->tid_pool, sizeof(xr_capture_tid_t));
+  capture->nthread = 0;
+  capture->get = tracer->get;
+  capture->strcpy = tracer->strcpy;
+  capture->task_path = tracer->task_path;
+  tracer->get = xr_capture_get;
+  tracer->strcpy = xr_capture_strcpy;
+  tracer->task_path = xr_capture_task_path;
+  tracer->capture = capture;
+  return true;
+}
+
+// return false if task is recorded already, or its parent is not yet.
+static bool xr_capture_task(xr_capture_t *capture, xr_thread_t *thread,
+                            bool orphan) {
+  if (xr_hash_find(&capture->tids, thread->tid) != NULL) {
+    return false;
+  }
+  if (orphan == false && thread->parent != 0 &&
+      xr_hash_find(&capture->tids, thread->parent) == NULL) {
+    return false;
+  }
+  xr_capture_tid_t *tid = xr_pool_alloc(&capture->tid_pool);
+  tid->node.key = thread->tid;
+  xr_hash_insert(&capture->tids, &tid->node);
+  xr_capture_task_t task;
+  memset(&task, 0, sizeof(task));
+  task.tid = thread->tid;
+  task.pid = thread->process->pid;
+  // a task whose parent has exited is replayed as a new one.
+  if (orphan == false) {
+    task.parent = thread->parent;
+  }
+  task.share_files = thread->share_files;
+  task.share_fs = thread->share_fs;
+  xr_path_t *pwd = xr_fs_pwd(&thread->fs);
+  xr_capture_write(capture, XR_CAPTURE_TASK, &task, sizeof(task), pwd->string,
+                   task.parent == 0 ? pwd->length : 0);
+  return true;
+}
+
+static bool xr_capture_pass(xr_capture_t *capture, xr_tracer_t *tracer,
+                            bool orphan) {
+  bool recorded = false;
+  xr_process_t *process;
+  xr_thread_t *thread;
+  _xr_list_for_each_entry(&tracer->processes, process, xr_process_t,
+                          processes) {
+    _xr_list_for_each_entry(&process->threads, thread, xr_thread_t, threads) {
+      recorded |= xr_capture_task(capture, thread, orphan);
+    }
+  }
+  return recorded;
+}
+
+// tasks are recorded once tracer has created them, new tasks make nthread of
+// tracer grow. Newer processes come first in tracer->processes, while replay
+// creates a task from its parent, hence parents are recorded first, and tasks
+// whose parent has exited come last.
+static void xr_capture_tasks(xr_capture_t *capture, xr_tracer_t *tracer) {
+  if (capture->nthread == tracer->nthread) {
+    return;
+  }
+  capture->nthread = tracer->nthread;
+  while (xr_capture_pass(capture, tracer, false)) {
+  }
+  xr_capture_pass(capture, tracer, true);
+}
+
+static void xr_capture_clear(xr_capture_t *capture) {
+  size_t i;
+  xr_hash_node_t *cur, *temp;
+  _xr_hash_for_each_safe(&capture->tids, i, cur, temp) {
+    xr_pool_free(&capture->tid_pool,
+                 xr_hash_entry(cur, xr_capture_tid_t, node));
+  }
+  xr_hash_clear(&capture->tids);
+  capture->nthread = 0;
+}
+
+void xr_capture_begin(xr_capture_t *capture, xr_tracer_t *tracer) {
+  xr_capture_clear(capture);
+  xr_capture_write(capture, XR_CAPTURE_BEGIN, NULL, 0, NULL, 0);
+  xr_capture_tasks(capture, tracer);
+}
+
+void xr_capture_trap(xr_capture_t *capture, xr_tracer_t *tracer,
+                     xr_trace_trap_t *trap) {
+  xr_capture_tasks(capture, tracer);
+  xr_thread_t *thread = trap->thread;
+  xr_capture_trap_t record;
+  memset(&record, 0, sizeof(record));
+  record.tid = thread->tid;
+  record.trap = trap->trap;
+  record.syscall_status = thread->syscall_status;
+  record.compat = thread->process->compat;
+  record.clone_flags = thread->clone_flags;
+  if (trap->trap == XR_TRACE_TRAP_SYSCALL) {
+    record.syscall_info = trap->syscall_info;
+  } else {
+    record.exit_code = trap->exit_code;
+  }
+  xr_capture_write(capture, XR_CAPTURE_TRAP, &record, sizeof(record), NULL, 0);
+  // an exited tid may be taken by a new task.
+  if (trap->trap == XR_TRACE_TRAP_EXIT ||
+      trap->trap == XR_TRACE_TRAP_SIGEXIT) {
+    xr_hash_node_t *node = xr_hash_remove(&capture->tids, thread->tid);
+    if (node != NULL) {
+      xr_pool_free(&capture->tid_pool,
+                   xr_hash_entry(node, xr_capture_tid_t, node));
+    }
+  }
+}
+
+void xr_capture_end(xr_capture_t *capture, xr_result_t *result) {
+  xr_capture_end_t status = result->status;
+  xr_capture_write(capture, XR_CAPTURE_END, &status, sizeof(status), NULL, 0);
+}
+
+bool xr_capture_close(xr_capture_t *capture, xr_tracer_t *tracer) {
+  tracer->get = capture->get;
+  tracer->strcpy = capture->strcpy;
+  tracer->task_path = capture->task_path;
+  tracer->capture = NULL;
+  xr_capture_clear(capture);
+  xr_hash_delete(&capture->tids);
+  xr_pool_delete(&capture->tid_pool);
+  bool ok = ferror(capture->file) == 0;
+  return fclose(capture->file) == 0 && ok;
+}
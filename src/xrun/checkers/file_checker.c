@@ -1,17 +1,27 @@
+#include <errno.h>
 #include <fcntl.h>
 
 #include "xrun/calls.h"
 #include "xrun/checkers/file_checker.h"
 #include "xrun/files.h"
+#include "xrun/landlock.h"
 #include "xrun/option.h"
 #include "xrun/process.h"
 #include "xrun/tracer.h"
+#include "xrun/workspace.h"
 
 typedef struct xr_file_checker_data_s {
   xr_access_trigger_mode_t trigger;
   xr_path_t *epath;
   long flags;
   xr_access_list_t *files, *directories;
+  // workspace of current run, NULL if there is none.
+  xr_workspace_t *workspace;
+  // access lists are enforced by landlock, only its denials are inspected.
+  bool landlock;
+  xr_result_backend_t backend;
+  // path of checks which do not record opened files.
+  xr_path_t trap_path;
 } xr_file_checker_data_t;
 
 static inline xr_file_checker_data_t *xr_file_checker_data(
@@ -37,6 +47,8 @@ bool xr_file_checker_setup(xr_checker_t *checker, xr_option_t *option) {
   data->trigger = option->access_trigger;
   data->files = &option->files;
   data->directories = &option->directories;
+  data->landlock = option->landlock && xr_landlock_abi() > 0 &&
+                   xr_landlock_covers(option);
 
   return true;
 }
@@ -44,11 +56,14 @@ bool xr_file_checker_setup(xr_checker_t *checker, xr_option_t *option) {
 static inline bool __do_file_access_check(xr_checker_t *checker,
                                           xr_path_t *path, long flags) {
   xr_file_checker_data_t *data = xr_file_checker_data(checker);
-  bool result = xr_access_list_check(data->files, path, flags) ||
-                xr_access_list_check(data->directories, path, flags);
+  bool result =
+    xr_access_list_check(data->files, path, flags) ||
+    xr_access_list_check(data->directories, path, flags) ||
+    (data->workspace != NULL && xr_workspace_contains(data->workspace, path));
   if (result == false) {
-    xr_file_checker_data(checker)->epath = path;
-    xr_file_checker_data(checker)->flags = flags;
+    data->epath = path;
+    data->flags = flags;
+    data->backend = XR_RESULT_BACKEND_TRACER;
   }
   return result;
 }
@@ -157,11 +172,102 @@ static inline void __do_process_unshare(xr_thread_t *thread, int flag) {
 #define XR_OPEN_PATH_ARG(syscall) (syscall == XR_SYSCALL_OPENAT ? 1 : 0)
 #define XR_OPEN_FLAG_ARG(syscall) (syscall == XR_SYSCALL_OPENAT ? 2 : 1)
 
+/**
+ * Resolve a relative path of an open against dirfd at of the live task by
+ * task_path op of tracer. Paths are normalized in place.
+ */
+static inline void __do_task_path_abs(xr_tracer_t *tracer,
+                                      xr_thread_t *thread, int at,
+                                      xr_path_t *path) {
+  if (xr_path_is_relative(path)) {
+    xr_path_t abs_path;
+    xr_string_zero(&abs_path);
+    // an unresolved relative path is never permitted by access lists.
+    if (tracer->task_path(tracer, thread->tid, at, &abs_path)) {
+      xr_path_join(&abs_path, path);
+      xr_string_swap(&abs_path, path);
+    }
+    xr_path_delete(&abs_path);
+  }
+  xr_path_abs(path);
+}
+
+/**
+ * Inspect an open denied with EACCES while landlock enforcing access lists.
+ * Files are not tracked in landlock mode, so a relative path is resolved
+ * against the live task, which still holds its dirfd at the exit trap.
+ *
+ * @return false if access lists deny the path, which means landlock did.
+ */
+static inline bool __do_landlock_deny_check(xr_checker_t *checker,
+                                            xr_tracer_t *tracer,
+                                            xr_thread_t *thread, int call,
+                                            long *call_args) {
+  xr_file_checker_data_t *data = xr_file_checker_data(checker);
+  xr_path_t *path = &data->trap_path;
+  if (tracer->strcpy(tracer, thread->tid,
+                     (void *)call_args[XR_OPEN_PATH_ARG(call)],
+                     path) == false) {
+    return true;
+  }
+  __do_task_path_abs(tracer, thread,
+                     call == XR_SYSCALL_OPENAT ? (int32_t)call_args[0]
+                                               : AT_FDCWD,
+                     path);
+  if (__do_file_access_check(checker, path,
+                             call == XR_SYSCALL_CREAT
+                               ? XR_CREATE_FLAGS
+                               : call_args[XR_OPEN_FLAG_ARG(call)])) {
+    // access lists permit it, EACCES comes from somewhere else.
+    return true;
+  }
+  data->backend = XR_RESULT_BACKEND_LANDLOCK;
+  return false;
+}
+
+/**
+ * Check paths for tracer without exit trap. Files can not be recorded without
+ * return value, so relative paths are resolved against the live task by
+ * task_path op of tracer.
+ *
+ * @return false if access lists deny the path.
+ */
+static inline bool __do_entry_file_check(xr_checker_t *checker,
+                                         xr_tracer_t *tracer,
+                                         xr_thread_t *thread, int call,
+                                         long *call_args) {
+  int at = AT_FDCWD, path_arg = 0;
+  long flags = O_RDONLY;
+  if (XR_NEW_FILE(call)) {
+    path_arg = XR_OPEN_PATH_ARG(call);
+    flags = (call == XR_SYSCALL_CREAT ? XR_CREATE_FLAGS
+                                      : call_args[XR_OPEN_FLAG_ARG(call)]);
+    if (call == XR_SYSCALL_OPENAT) {
+      at = (int32_t)call_args[0];
+    }
+#ifdef XR_SYSCALL_CHDIR
+  } else if (call != XR_SYSCALL_CHDIR) {
+#else
+  } else {
+#endif
+    return true;
+  }
+
+  xr_path_t *path = &xr_file_checker_data(checker)->trap_path;
+  if (tracer->strcpy(tracer, thread->tid, (void *)call_args[path_arg],
+                     path) == false) {
+    return true;
+  }
+  __do_task_path_abs(tracer, thread, at, path);
+  return __do_file_access_check(checker, path, flags);
+}
+
 bool xr_file_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
                            xr_trace_trap_t *trap) {
   if (trap->trap != XR_TRACE_TRAP_SYSCALL) {
     return true;
   }
+  xr_file_checker_data(checker)->workspace = tracer->workspace;
 
   int call = trap->syscall_info.syscall;
   long *call_args = trap->syscall_info.args;
@@ -196,6 +302,18 @@ bool xr_file_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
         break;
     }
   }
+  if (xr_file_checker_data(checker)->landlock) {
+    if (XR_NEW_FILE(call) && thread->syscall_status == XR_THREAD_CALLOUT &&
+        retval == -EACCES) {
+      return __do_landlock_deny_check(checker, tracer, thread, call,
+                                      call_args);
+    }
+    return true;
+  }
+  if (tracer->syscall_exit == false) {
+    return thread->syscall_status != XR_THREAD_CALLIN ||
+           __do_entry_file_check(checker, tracer, thread, call, call_args);
+  }
   // handle new file syscall.
   if (XR_FILE_CHECK_ENABLE(xr_file_checker_data(checker)->trigger,
                            thread->syscall_status, retval) &&
@@ -238,9 +356,11 @@ void xr_file_checker_result(xr_checker_t *checker, xr_tracer_t *tracer,
   xr_file_checker_data_t *data = xr_file_checker_data(checker);
   xr_string_copy(&result->epath, data->epath);
   result->eflags = data->flags;
+  result->ebackend = data->backend;
 }
 
 void xr_file_checker_delete(xr_checker_t *checker) {
+  xr_path_delete(&xr_file_checker_data(checker)->trap_path);
   free(checker->checker_data);
   return;
 }
@@ -1,24 +1,12 @@
 #define _GNU_SOURCE
 #include <sched.h>
 
-#define CLONE_FLAG_ARGS(call) 0
-
 #include "xrun/calls.h"
 #include "xrun/checkers/fork_checker.h"
 #include "xrun/option.h"
 #include "xrun/process.h"
 #include "xrun/tracer.h"
 
-#ifndef XR_SYSCALL_VFORK
-#define XR_SYSCALL_VFORK -1
-#endif
-#ifndef XR_SYSCALL_FORK
-#define XR_SYSCALL_FORK -1
-#endif
-#ifndef XR_SYSCALL_CLONE
-#define XR_SYSCALL_CLONE -1
-#endif
-
 struct xr_fork_checker_data_s {
   xr_tracer_code_t code;
   size_t nprocess, nthread, total_thread;
@@ -45,86 +33,43 @@ bool xr_fork_checker_setup(xr_checker_t *checker, xr_option_t *option) {
   return true;
 }
 
-bool xr_fork_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
-                           xr_trace_trap_t *trap) {
-  if (trap->trap != XR_TRACE_TRAP_SYSCALL) {
-    return true;
-  }
-
-  int retval = trap->syscall_info.retval;
-  int syscall = trap->syscall_info.syscall;
-  bool fork = false, clone_files = false, clone_fs = false;
-
-  if (trap->thread->syscall_status == XR_THREAD_CALLIN) {
-    if (syscall == XR_SYSCALL_CLONE &&
-        (trap->syscall_info.args[CLONE_FLAG_ARGS(syscall)] & CLONE_UNTRACED)) {
-      xr_fork_checker_data(checker)->code = XR_RESULT_CLONEDENY;
-      return false;
-    }
-    return true;
+/**
+ * Check limits before a task is created. Tracers create new tasks on their
+ * clone events or first traps, there is no chance to check them after clone
+ * returned.
+ *
+ * @return false if the new task would run out of limits.
+ */
+static inline bool __do_clone_entry_check(xr_checker_t *checker,
+                                          xr_tracer_t *tracer,
+                                          xr_trace_trap_t *trap) {
+  xr_fork_checker_data_t *data = xr_fork_checker_data(checker);
+  // CLONE_THREAD make new task be in the same thread group of caller task
+  bool fork = ((trap->thread->clone_flags & CLONE_THREAD) == 0);
+  if ((fork && tracer->nprocess + 1 > data->nprocess) ||
+      tracer->nthread + 1 > data->total_thread ||
+      (!fork && trap->thread->process->nthread + 1 > data->nthread)) {
+    data->code = XR_RESULT_TASKOUT;
+    return false;
   }
+  return true;
+}
 
-  if ((syscall != XR_SYSCALL_CLONE && syscall != XR_SYSCALL_FORK &&
-       syscall != XR_SYSCALL_VFORK) ||
-      retval != 0) {
-    // not a clone, fork, vfork syscall
-    // or, caller syscall return.
-    // checking
+bool xr_fork_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
+                           xr_trace_trap_t *trap) {
+  if (trap->trap != XR_TRACE_TRAP_SYSCALL ||
+      trap->thread->syscall_status != XR_THREAD_CALLIN ||
+      xr_tracer_is_clone(trap->syscall_info.syscall) == false ||
+      trap->thread->clone_flags == XR_THREAD_CLONE_UNKNOWN) {
     return true;
-  } else if (syscall == XR_SYSCALL_CLONE) {
-    int clone_flags = trap->syscall_info.args[CLONE_FLAG_ARGS(syscall)];
-    if (clone_flags & CLONE_UNTRACED) {
-      // clone with CLONE_UNTRACED is not allow
-      xr_fork_checker_data(checker)->code = XR_RESULT_CLONEDENY;
-      return false;
-    }
-    // CLONE_THREAD make new task be in the same thread group of caller task
-    fork = ((clone_flags & CLONE_THREAD) == 0);
-    clone_files = ((clone_flags & CLONE_FILES) != 0);
-    clone_fs = ((clone_flags & CLONE_FS) != 0);
-  } else {
-    // fork and vfork make new process
-    fork = true;
-  }
-
-  xr_thread_t *thread = trap->thread;
-  xr_thread_t *caller = trap->thread->from;
-
-  // clone files
-  xr_file_set_share(&caller->fset, &thread->fset);
-  if (!clone_files) {
-    // copy files
-    xr_file_set_own(&thread->fset);
-  }
-
-  xr_fs_share(&caller->fs, &thread->fs);
-  if (!clone_fs) {
-    // copy fs
-    xr_fs_own(&thread->fs);
-  }
-
-  tracer->nthread++;
-
-  // thread will return from fork or clone, so should be XR_THREAD_CALLIN
-  if (fork) {
-    // fork will create new thread group
-    xr_process_remove_thread(thread->process, thread, true);
-    thread->process = _XR_NEW(xr_process_t);
-    xr_process_init(thread->process);
-    thread->process->pid = thread->tid;
-    xr_list_add(&tracer->processes, &thread->process->processes);
-    xr_process_add_thread(thread->process, thread);
-    tracer->nprocess++;
   }
 
-  if (tracer->nprocess > xr_fork_checker_data(checker)->nprocess ||
-      tracer->nthread > xr_fork_checker_data(checker)->total_thread ||
-      thread->process->nthread > xr_fork_checker_data(checker)->nthread) {
-    xr_fork_checker_data(checker)->code = XR_RESULT_TASKOUT;
+  if (trap->thread->clone_flags & CLONE_UNTRACED) {
+    // clone with CLONE_UNTRACED is not allow
+    xr_fork_checker_data(checker)->code = XR_RESULT_CLONEDENY;
     return false;
   }
-
-  return true;
+  return __do_clone_entry_check(checker, tracer, trap);
 }
 
 void xr_fork_checker_result(xr_checker_t *checker, xr_tracer_t *tracer,
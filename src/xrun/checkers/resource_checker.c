@@ -1,3 +1,4 @@
+#include <errno.h>
 #include <signal.h>
 
 #include "xrun/calls.h"
@@ -9,6 +10,7 @@
 struct xr_resource_checker_data_s {
   xr_tracer_code_t code;
   xr_limit_t *limit, *process_limit;
+  bool compensate;
 };
 typedef struct xr_resource_checker_data_s xr_resource_checker_data_t;
 
@@ -30,12 +32,53 @@ bool xr_resource_checker_setup(xr_checker_t *checker, xr_option_t *option) {
   xr_resource_checker_data_t *data = xr_resource_checker_data(checker);
   data->process_limit = &option->limit_per_process;
   data->limit = &option->limit;
+  data->compensate = option->compensate;
+  return true;
+}
+
+/**
+ * Sample process of trap if it is not sampled for a while, or it is stopped
+ * by a signal which may come from a resource limit.
+ *
+ * @@tracer
+ * @@trap
+ *
+ * @return true if process is sampled.
+ */
+static inline bool xr_resource_checker_sample(xr_tracer_t *tracer,
+                                              xr_trace_trap_t *trap) {
+  xr_process_t *process = trap->thread->process;
+  unsigned long long now = xr_time_now_ns();
+  if (trap->trap != XR_TRACE_TRAP_SIGNAL &&
+      now - process->sampled < XR_RESOURCE_CHECKER_SAMPLE_INTERVAL) {
+    return false;
+  }
+  // a process killed by now keeps its last sample.
+  _XR_CALLP(tracer, sample, process);
+  errno = 0;
+  process->sampled = now;
   return true;
 }
 
 bool xr_resource_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
                                xr_trace_trap_t *trap) {
   xr_resource_checker_data_t *data = xr_resource_checker_data(checker);
+  // perf counters of tracees overflow one by one, their total is checked
+  // along with samples.
+  if (trap->trap != XR_TRACE_TRAP_EXIT &&
+      xr_resource_checker_sample(tracer, trap) &&
+      xr_perf_opened(&tracer->perf)) {
+    xr_perf_count_t count;
+    xr_perf_read(&tracer->perf, &count);
+    if (data->compensate && count.task_clock != XR_PERF_UNAVAILABLE) {
+      count.task_clock =
+        xr_tracer_compensate_ns(tracer, tracer->nstop, count.task_clock);
+    }
+    if (xr_perf_exceeded(&count, &data->limit->perf)) {
+      data->code = XR_RESULT_TIMEOUT;
+      return false;
+    }
+  }
   if (trap->trap == XR_TRACE_TRAP_SIGNAL) {
     switch (trap->stop_signal) {
       case SIGSEGV:
@@ -59,8 +102,12 @@ bool xr_resource_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
       data->code = XR_RESULT_MEMOUT;
       return false;
     }
-    if (process->time.sys_time > data->limit->time.sys_time ||
-        process->time.user_time > data->limit->time.user_time) {
+    xr_time_t time = process->time;
+    if (data->compensate) {
+      time = xr_tracer_compensate_time(tracer, process->nstop, time);
+    }
+    if (time.sys_time > data->limit->time.sys_time ||
+        time.user_time > data->limit->time.user_time) {
       data->code = XR_RESULT_TIMEOUT;
       return false;
     }
@@ -25,7 +25,7 @@ bool xr_syscall_checker_check(xr_checker_t *checker, xr_tracer_t *tracer,
                               xr_trace_trap_t *trap) {
   xr_syscall_checker_data_t *data = xr_syscall_checker_data(checker);
   if (trap->trap != XR_TRACE_TRAP_SYSCALL ||
-      trap->thread->syscall_status != XR_THREAD_CALLOUT) {
+      trap->thread->syscall_status != XR_THREAD_CALLIN) {
     return true;
   }
 
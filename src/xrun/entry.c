@@ -4,22 +4,32 @@
 
 #include "xrun/entry.h"
 
-void xr_entry_execve(xr_entry_t *entry) {
+bool xr_entry_enter(xr_entry_t *entry) {
   xr_path_abs(&entry->root);
   if (entry->root.length != 0 &&
       xr_string_equal(&entry->root, &xr_path_slash) == false) {
     if (chroot(entry->root.string) == -1) {
-      return;
+      return false;
     }
   }
   if (entry->pwd.length != 0) {
     if (chdir(entry->pwd.string) == -1) {
-      return;
+      return false;
     }
   }
+  return true;
+}
+
+void xr_entry_exec(xr_entry_t *entry) {
   if (entry->environs == NULL) {
     execvp(entry->path.string, entry->argv);
   } else {
     execvpe(entry->path.string, entry->argv, entry->environs);
   }
 }
+
+void xr_entry_execve(xr_entry_t *entry) {
+  if (xr_entry_enter(entry)) {
+    xr_entry_exec(entry);
+  }
+}
@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/landlock.h>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "xrun/landlock.h"
+
+#ifdef __NR_landlock_create_ruleset
+
+#define XR_LANDLOCK_ACCESS_READ \
+  (LANDLOCK_ACCESS_FS_READ_FILE | LANDLOCK_ACCESS_FS_READ_DIR)
+#define XR_LANDLOCK_ACCESS_WRITE LANDLOCK_ACCESS_FS_WRITE_FILE
+#define XR_LANDLOCK_ACCESS_CREATE LANDLOCK_ACCESS_FS_MAKE_REG
+
+// execve is not checked by file checker either, so execute is not handled.
+#define XR_LANDLOCK_ACCESS_HANDLED \
+  (XR_LANDLOCK_ACCESS_READ | XR_LANDLOCK_ACCESS_WRITE | \
+   XR_LANDLOCK_ACCESS_CREATE)
+
+// rights only make sense for directory.
+#define XR_LANDLOCK_ACCESS_DIR \
+  (LANDLOCK_ACCESS_FS_READ_DIR | XR_LANDLOCK_ACCESS_CREATE)
+
+int xr_landlock_abi() {
+  long abi = syscall(__NR_landlock_create_ruleset, NULL, 0,
+                     LANDLOCK_CREATE_RULESET_VERSION);
+  // errno is left to caller if landlock is not supported
+  return abi < 0 ? 0 : abi;
+}
+
+// open flags landlock can not see, an entry without any of them denies opens
+// which landlock would permit. O_CREAT is only seen when a file is created.
+#define XR_LANDLOCK_FLAGS_BLIND                                             \
+  (O_APPEND | O_ASYNC | O_CLOEXEC | O_DIRECT | O_DIRECTORY | O_DSYNC |     \
+   O_EXCL | O_LARGEFILE | O_NOATIME | O_NOCTTY | O_NOFOLLOW | O_NONBLOCK | \
+   O_PATH | O_SYNC | O_TMPFILE | O_TRUNC | O_CREAT)
+
+/**
+ * Check whether landlock permits exactly the opens which entry permits. An
+ * entry in contains mode permits flags which are a subset of its flags, so
+ * O_RDWR does not permit O_WRONLY and O_WRONLY permits O_RDONLY, which
+ * landlock rights can not tell. Creating a file is granted by its parent
+ * directory rather than an inode of the file, so only directories are exact.
+ */
+static inline bool xr_landlock_exact(xr_access_list_t *alist,
+                                     xr_access_entry_t *entry) {
+  long accmode = entry->flags & O_ACCMODE;
+  return entry->mode == XR_ACCESS_MODE_FLAG_CONTAINS &&
+         (entry->flags & XR_LANDLOCK_FLAGS_BLIND) == XR_LANDLOCK_FLAGS_BLIND &&
+         (accmode == O_RDONLY || accmode == (O_WRONLY | O_RDWR)) &&
+         alist->type == XR_ACCESS_TYPE_DIR;
+}
+
+bool xr_landlock_covers(xr_option_t *option) {
+  xr_access_list_t *alists[] = {&option->files, &option->directories};
+  for (int i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < alists[i]->nentry; ++j) {
+      if (xr_landlock_exact(alists[i], &alists[i]->entries[j]) == false) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Rights of entry, which never deny an open the entry permits. Rights of an
+ * entry which is not exact may permit more, file checker denies the rest.
+ */
+static inline __u64 xr_landlock_access(xr_access_entry_t *entry, int fd) {
+  __u64 access = XR_LANDLOCK_ACCESS_READ;
+  if (entry->flags & (O_WRONLY | O_RDWR)) {
+    access |= XR_LANDLOCK_ACCESS_WRITE;
+  }
+  if (entry->flags & O_CREAT) {
+    access |= XR_LANDLOCK_ACCESS_CREATE;
+  }
+  // a directory entry may name a regular file as well.
+  struct stat st;
+  if (fstat(fd, &st) == -1 || S_ISDIR(st.st_mode) == false) {
+    access &= ~XR_LANDLOCK_ACCESS_DIR;
+  }
+  return access;
+}
+
+static inline bool xr_landlock_add_list(int ruleset, xr_access_list_t *alist,
+                                        xr_path_t *root) {
+  xr_path_t path;
+  xr_string_zero(&path);
+  for (size_t i = 0; i < alist->nentry; ++i) {
+    xr_access_entry_t *entry = &alist->entries[i];
+    path.length = 0;
+    if (root->length != 0 &&
+        xr_string_equal(root, &xr_path_slash) == false) {
+      xr_string_concat(&path, root);
+    }
+    xr_string_concat(&path, &entry->path);
+    int fd = open(path.string, O_PATH | O_CLOEXEC);
+    if (fd == -1 && (entry->flags & O_CREAT) && errno == ENOENT) {
+      // a file to be created is granted by its parent, so are its siblings,
+      // which file checker still denies since the entry is not exact.
+      xr_path_t parent;
+      xr_string_zero(&parent);
+      xr_string_copy(&parent, &path);
+      xr_string_concat_raw(&parent, "/..", 3);
+      xr_path_abs(&parent);
+      fd = open(parent.string, O_PATH | O_CLOEXEC);
+      xr_path_delete(&parent);
+    }
+    if (fd == -1) {
+      // missing entry grants nothing, file checker still reports it.
+      continue;
+    }
+    struct landlock_path_beneath_attr attr = {
+      .allowed_access = xr_landlock_access(entry, fd),
+      .parent_fd = fd,
+    };
+    long ret = syscall(__NR_landlock_add_rule, ruleset,
+                       LANDLOCK_RULE_PATH_BENEATH, &attr, 0);
+    close(fd);
+    if (ret != 0) {
+      xr_path_delete(&path);
+      return false;
+    }
+  }
+  xr_path_delete(&path);
+  return true;
+}
+
+// workspace is granted every handled right, as file checker permits.
+static inline bool xr_landlock_add_workspace(int ruleset, xr_path_t *workspace,
+                                             xr_path_t *root) {
+  xr_path_t path;
+  xr_string_zero(&path);
+  if (root->length != 0 && xr_string_equal(root, &xr_path_slash) == false) {
+    xr_string_concat(&path, root);
+  }
+  xr_string_concat(&path, workspace);
+  int fd = open(path.string, O_PATH | O_CLOEXEC | O_DIRECTORY);
+  xr_path_delete(&path);
+  if (fd == -1) {
+    return false;
+  }
+  struct landlock_path_beneath_attr attr = {
+    .allowed_access = XR_LANDLOCK_ACCESS_HANDLED,
+    .parent_fd = fd,
+  };
+  long ret = syscall(__NR_landlock_add_rule, ruleset,
+                     LANDLOCK_RULE_PATH_BENEATH, &attr, 0);
+  close(fd);
+  return ret == 0;
+}
+
+bool xr_landlock_restrict(xr_option_t *option, xr_path_t *workspace,
+                          xr_path_t *root) {
+  struct landlock_ruleset_attr attr = {
+    .handled_access_fs = XR_LANDLOCK_ACCESS_HANDLED,
+  };
+  int ruleset =
+    syscall(__NR_landlock_create_ruleset, &attr, sizeof(attr), 0);
+  if (ruleset == -1) {
+    return false;
+  }
+  bool ok = xr_landlock_add_list(ruleset, &option->files, root) &&
+            xr_landlock_add_list(ruleset, &option->directories, root) &&
+            (workspace == NULL ||
+             xr_landlock_add_workspace(ruleset, workspace, root)) &&
+            prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0 &&
+            syscall(__NR_landlock_restrict_self, ruleset, 0) == 0;
+  close(ruleset);
+  return ok;
+}
+
+#else /* __NR_landlock_create_ruleset */
+
+int xr_landlock_abi() {
+  return 0;
+}
+
+bool xr_landlock_covers(xr_option_t *option) {
+  return false;
+}
+
+bool xr_landlock_restrict(xr_option_t *option, xr_path_t *workspace,
+                          xr_path_t *root) {
+  return false;
+}
+
+#endif /* __NR_landlock_create_ruleset */
@@ -0,0 +1,309 @@
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "xrun/placement.h"
+
+#define XR_PLACEMENT_SYSFS_CPU "/sys/devices/system/cpu/cpu%d"
+
+bool xr_cpus_parse(xr_cpus_t *cpus, const char *list) {
+  memset(cpus, 0, sizeof(xr_cpus_t));
+  const char *cur = list;
+  while (*cur != '\0' && *cur != '\n') {
+    char *end;
+    long first = strtol(cur, &end, 10), last = first;
+    if (end == cur) {
+      return false;
+    }
+    if (*end == '-') {
+      cur = end + 1;
+      last = strtol(cur, &end, 10);
+      if (end == cur) {
+        return false;
+      }
+    }
+    if (first < 0 || last < first || last >= XR_PLACEMENT_MAXCPU) {
+      return false;
+    }
+    for (long cpu = first; cpu <= last; ++cpu) {
+      xr_cpus_set(cpus, cpu);
+    }
+    cur = end;
+    if (*cur == ',') {
+      cur++;
+    } else if (*cur != '\0' && *cur != '\n') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline bool xr_placement_get_affinity(xr_cpus_t *cpus) {
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(cpu_set_t), &set) == -1) {
+    return false;
+  }
+  memset(cpus, 0, sizeof(xr_cpus_t));
+  for (int cpu = 0; cpu < XR_PLACEMENT_MAXCPU && cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set)) {
+      xr_cpus_set(cpus, cpu);
+    }
+  }
+  return true;
+}
+
+static inline bool xr_placement_set_affinity(const xr_cpus_t *cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu = 0; cpu < XR_PLACEMENT_MAXCPU && cpu < CPU_SETSIZE; ++cpu) {
+    if (xr_cpus_isset(cpus, cpu)) {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return sched_setaffinity(0, sizeof(cpu_set_t), &set) == 0;
+}
+
+// cpu and its SMT siblings which tracer may run on.
+static void xr_placement_siblings(xr_placement_run_t *run, int cpu) {
+  char path[128], list[256];
+  snprintf(path, sizeof(path),
+           XR_PLACEMENT_SYSFS_CPU "/topology/thread_siblings_list", cpu);
+  FILE *file = fopen(path, "re");
+  xr_cpus_t siblings;
+  memset(&siblings, 0, sizeof(xr_cpus_t));
+  if (file != NULL) {
+    if (fgets(list, sizeof(list), file) == NULL ||
+        xr_cpus_parse(&siblings, list) == false) {
+      memset(&siblings, 0, sizeof(xr_cpus_t));
+    }
+    fclose(file);
+  }
+  memset(&run->cpus, 0, sizeof(xr_cpus_t));
+  xr_cpus_set(&run->cpus, cpu);
+  for (size_t i = 0; i < XR_PLACEMENT_MAXCPU / XR_CPUS_BITS; ++i) {
+    run->cpus.bits[i] |= siblings.bits[i] & run->affinity.bits[i];
+  }
+}
+
+static inline bool xr_placement_lock(int fd, int cpu, short type) {
+  struct flock lock = {
+    .l_type = type, .l_whence = SEEK_SET, .l_start = cpu, .l_len = 1};
+  return fcntl(fd, F_OFD_SETLK, &lock) == 0;
+}
+
+static void xr_placement_release(xr_placement_run_t *run) {
+  for (int cpu = 0; cpu < XR_PLACEMENT_MAXCPU; ++cpu) {
+    if (xr_cpus_isset(&run->cpus, cpu)) {
+      xr_placement_lock(run->lock, cpu, F_UNLCK);
+    }
+  }
+  run->claimed = false;
+}
+
+/*
+ * lock file is shared by runs of every user who can write it. It is created
+ * with 0666 less umask and never chmod, and it is only trusted as a regular
+ * file owned by root or by caller.
+ */
+static bool xr_placement_open_lock(xr_placement_run_t *run) {
+  if (mkdir(XR_PLACEMENT_LOCK_DIR, 0755) == -1 && errno != EEXIST) {
+    return false;
+  }
+  int fd = open(XR_PLACEMENT_LOCK,
+                O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW | O_NOCTTY, 0666);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == -1) {
+    close(fd);
+    return false;
+  }
+  if (S_ISREG(st.st_mode) == false ||
+      (st.st_uid != 0 && st.st_uid != geteuid())) {
+    close(fd);
+    errno = EPERM;
+    return false;
+  }
+  run->lock = fd;
+  return true;
+}
+
+/*
+ * open file description locks are held by the fd of tracer, hence runs of
+ * other threads and processes do not take the same cpus, and the kernel
+ * releases them if tracer dies.
+ */
+static bool xr_placement_claim(xr_placement_run_t *run,
+                               const xr_placement_t *placement) {
+  if (run->lock == -1 && xr_placement_open_lock(run) == false) {
+    return false;
+  }
+  const xr_cpus_t *from = xr_cpus_empty(&placement->cpus)
+                            ? &run->affinity
+                            : &placement->cpus;
+  memset(&run->cpus, 0, sizeof(xr_cpus_t));
+  int ncpu = 0;
+  for (int cpu = 0; cpu < XR_PLACEMENT_MAXCPU && ncpu < placement->ncpu;
+       ++cpu) {
+    if (xr_cpus_isset(from, cpu) &&
+        xr_placement_lock(run->lock, cpu, F_WRLCK)) {
+      xr_cpus_set(&run->cpus, cpu);
+      ncpu++;
+    }
+  }
+  run->claimed = true;
+  if (ncpu < placement->ncpu) {
+    xr_placement_release(run);
+    errno = EBUSY;
+    return false;
+  }
+  return true;
+}
+
+// node of cpu is named by a nodeN entry in its sysfs dir, -1 without NUMA.
+static int xr_placement_node(int cpu) {
+  char path[64];
+  snprintf(path, sizeof(path), XR_PLACEMENT_SYSFS_CPU, cpu);
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    return -1;
+  }
+  int node = -1;
+  struct dirent *entry;
+  while (node == -1 && (entry = readdir(dir)) != NULL) {
+    char *end;
+    if (strncmp(entry->d_name, "node", 4) == 0) {
+      long id = strtol(entry->d_name + 4, &end, 10);
+      if (end != entry->d_name + 4 && *end == '\0' && id >= 0 &&
+          id < XR_PLACEMENT_MAXNODE) {
+        node = id;
+      }
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+// kernel takes maxnode as count of bits plus one.
+static bool xr_placement_bind(xr_placement_run_t *run) {
+  if (syscall(SYS_get_mempolicy, &run->mempolicy, run->nodes,
+              XR_PLACEMENT_MAXNODE + 1, NULL, 0) == -1) {
+    return false;
+  }
+  unsigned long nodes[XR_PLACEMENT_MAXNODE / XR_CPUS_BITS];
+  memset(nodes, 0, sizeof(nodes));
+  bool found = false;
+  for (int cpu = 0; cpu < XR_PLACEMENT_MAXCPU; ++cpu) {
+    int node = xr_cpus_isset(&run->cpus, cpu) ? xr_placement_node(cpu) : -1;
+    if (node != -1) {
+      nodes[node / XR_CPUS_BITS] |= 1ul << (node % XR_CPUS_BITS);
+      found = true;
+    }
+  }
+  // a kernel without NUMA has nothing to bind.
+  if (found == false) {
+    return true;
+  }
+  if (syscall(SYS_set_mempolicy, MPOL_BIND, nodes, XR_PLACEMENT_MAXNODE + 1) ==
+      -1) {
+    return false;
+  }
+  run->numa = true;
+  return true;
+}
+
+bool xr_placement_begin(xr_placement_run_t *run,
+                        const xr_placement_t *placement) {
+  if (xr_placement_get_affinity(&run->affinity) == false) {
+    return false;
+  }
+  int cpu = sched_getcpu();
+  if (cpu == -1) {
+    return false;
+  }
+  switch (placement->mode) {
+    case XR_PLACEMENT_SIBLINGS:
+      xr_placement_siblings(run, cpu);
+      break;
+    case XR_PLACEMENT_EXCLUSIVE:
+      if (xr_placement_claim(run, placement) == false) {
+        return false;
+      }
+      break;
+    default:
+      memset(&run->cpus, 0, sizeof(xr_cpus_t));
+      xr_cpus_set(&run->cpus, cpu);
+      break;
+  }
+  if (placement->mode != XR_PLACEMENT_NONE) {
+    if (xr_placement_set_affinity(&run->cpus) == false) {
+      goto xr_placement_begin_failed;
+    }
+    run->pinned = true;
+  }
+  if (placement->fifo) {
+    struct sched_param param;
+    if ((run->policy = sched_getscheduler(0)) == -1 ||
+        sched_getparam(0, &param) == -1) {
+      goto xr_placement_begin_failed;
+    }
+    run->priority = param.sched_priority;
+    // tracees fork with policy of tracer before run, not SCHED_FIFO.
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+    if (sched_setscheduler(0, SCHED_FIFO | SCHED_RESET_ON_FORK, &param) ==
+        -1) {
+      goto xr_placement_begin_failed;
+    }
+    run->fifo = true;
+  }
+  if (placement->numa && xr_placement_bind(run) == false) {
+    goto xr_placement_begin_failed;
+  }
+  return true;
+
+xr_placement_begin_failed:;
+  int error = errno;
+  xr_placement_end(run);
+  errno = error;
+  return false;
+}
+
+void xr_placement_end(xr_placement_run_t *run) {
+  if (run->numa) {
+    syscall(SYS_set_mempolicy, run->mempolicy,
+            run->mempolicy == MPOL_DEFAULT ? NULL : run->nodes,
+            run->mempolicy == MPOL_DEFAULT ? 0 : XR_PLACEMENT_MAXNODE + 1);
+    run->numa = false;
+  }
+  if (run->fifo) {
+    struct sched_param param = {.sched_priority = run->priority};
+    sched_setscheduler(0, run->policy, &param);
+    run->fifo = false;
+  }
+  if (run->pinned) {
+    xr_placement_set_affinity(&run->affinity);
+    run->pinned = false;
+  }
+  if (run->claimed) {
+    xr_placement_release(run);
+  }
+}
+
+void xr_placement_run_delete(xr_placement_run_t *run) {
+  xr_placement_end(run);
+  if (run->lock != -1) {
+    close(run->lock);
+    run->lock = -1;
+  }
+}
@@ -0,0 +1,34 @@
+#include <string.h>
+
+#include "xrun/recorder.h"
+
+size_t xr_recorder_last(const xr_recorder_t *recorder, xr_record_t *records,
+                        size_t n) {
+  unsigned long end = __atomic_load_n(&recorder->nrecord, __ATOMIC_ACQUIRE);
+  if (n > XR_RECORDER_NRECORD) {
+    n = XR_RECORDER_NRECORD;
+  }
+  if (n > end) {
+    n = end;
+  }
+  unsigned long begin = end - n;
+  for (unsigned long i = begin; i < end; ++i) {
+    memcpy(&records[i - begin], &recorder->records[i % XR_RECORDER_NRECORD],
+           sizeof(xr_record_t));
+  }
+  // writer may have lapped the oldest records while they were copied, and
+  // the slot being written is one ahead of nrecord.
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  unsigned long now = __atomic_load_n(&recorder->nrecord, __ATOMIC_RELAXED);
+  unsigned long valid = now + 1 - begin > XR_RECORDER_NRECORD
+                          ? now + 1 - XR_RECORDER_NRECORD
+                          : begin;
+  if (valid >= end) {
+    return 0;
+  }
+  if (valid > begin) {
+    memmove(records, &records[valid - begin],
+            (end - valid) * sizeof(xr_record_t));
+  }
+  return end - valid;
+}
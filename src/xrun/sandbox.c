@@ -0,0 +1,408 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xrun/sandbox.h"
+#include "xrun/utils/utils.h"
+
+// stack of clone in keeper, init of sandbox only runs a few syscalls on it.
+#define XR_SANDBOX_STACK (64 * 1024)
+
+static const char *const xr_sandbox_ns_names[XR_SANDBOX_NNS] = {
+  [XR_SANDBOX_NS_USER] = "user", [XR_SANDBOX_NS_MNT] = "mnt",
+  [XR_SANDBOX_NS_IPC] = "ipc",   [XR_SANDBOX_NS_NET] = "net",
+  [XR_SANDBOX_NS_UTS] = "uts",   [XR_SANDBOX_NS_PID] = "pid",
+};
+
+static const int xr_sandbox_ns_flags[XR_SANDBOX_NNS] = {
+  [XR_SANDBOX_NS_USER] = CLONE_NEWUSER, [XR_SANDBOX_NS_MNT] = CLONE_NEWNS,
+  [XR_SANDBOX_NS_IPC] = CLONE_NEWIPC,   [XR_SANDBOX_NS_NET] = CLONE_NEWNET,
+  [XR_SANDBOX_NS_UTS] = CLONE_NEWUTS,   [XR_SANDBOX_NS_PID] = CLONE_NEWPID,
+};
+
+int xr_sandbox_default_flags() {
+  return CLONE_NEWNS | CLONE_NEWIPC | CLONE_NEWNET | CLONE_NEWUTS |
+         (geteuid() == 0 ? CLONE_NEWPID : CLONE_NEWUSER);
+}
+
+/*
+ * keeper is forked from a process which may run other threads, it only runs
+ * async-signal-safe code on what is prepared here before fork.
+ */
+struct xr_sandbox_keeper_s {
+  int sock, flags;
+  char *stack;
+  // id maps of user namespace of sandboxes.
+  char uid_map[32], gid_map[32];
+};
+
+struct xr_sandbox_init_s {
+  int flags;
+  // keeper writes to sync once id maps are written, init writes to ready
+  // once sandbox is prepared.
+  int sync[2], ready[2];
+};
+
+static void xr_sandbox_init_sigchld(int sig) {}
+
+static int xr_sandbox_init_main(void *arg) {
+  struct xr_sandbox_init_s *init = arg;
+  char byte = 0;
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+  close(init->sync[1]);
+  close(init->ready[0]);
+  if (read(init->sync[0], &byte, sizeof(byte)) != sizeof(byte)) {
+    _exit(1);
+  }
+  // mounts of sandbox never propagate back to tracer, while mounts under
+  // shared ones of tracer, e.g. workspaces, still show up in sandbox.
+  if (mount(NULL, "/", NULL, MS_REC | MS_SLAVE, NULL) == -1) {
+    _exit(1);
+  }
+  if ((init->flags & CLONE_NEWPID) &&
+      mount("proc", "/proc", "proc", MS_NOSUID | MS_NODEV | MS_NOEXEC,
+            NULL) == -1) {
+    _exit(1);
+  }
+  // sysfs shows devices of net namespace it is mounted in.
+  if ((init->flags & CLONE_NEWNET) &&
+      mount("sysfs", "/sys", "sysfs", MS_NOSUID | MS_NODEV | MS_NOEXEC,
+            NULL) == -1) {
+    _exit(1);
+  }
+  if ((init->flags & CLONE_NEWUTS) &&
+      sethostname(XR_SANDBOX_HOSTNAME, strlen(XR_SANDBOX_HOSTNAME)) == -1) {
+    _exit(1);
+  }
+  // init ignores signals without handler, SIGCHLD then would not wake it.
+  sigset_t mask, old;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  sigprocmask(SIG_BLOCK, &mask, &old);
+  signal(SIGCHLD, xr_sandbox_init_sigchld);
+  if (write(init->ready[1], &byte, sizeof(byte)) != sizeof(byte)) {
+    _exit(1);
+  }
+  close(init->ready[1]);
+  // orphans in sandbox are reparented to init, reap them until killed.
+  for (;;) {
+    while (waitpid(-1, NULL, WNOHANG | __WALL) > 0) {
+    }
+    sigsuspend(&old);
+  }
+  return 0;
+}
+
+/**
+ * Format /proc/<pid>/<name> into path without stdio, which is not
+ * async-signal-safe.
+ *
+ * @path output path of 64 bytes
+ * @pid pid
+ * @name file name under /proc/<pid>, shorter than 32 bytes
+ */
+static inline void xr_sandbox_proc_path(char *path, pid_t pid,
+                                        const char *name) {
+  char digits[16];
+  int ndigit = 0;
+  do {
+    digits[ndigit++] = '0' + pid % 10;
+    pid /= 10;
+  } while (pid > 0);
+  char *end = stpcpy(path, "/proc/");
+  while (ndigit > 0) {
+    *end++ = digits[--ndigit];
+  }
+  *end++ = '/';
+  strcpy(end, name);
+}
+
+static inline bool xr_sandbox_write_file(pid_t pid, const char *name,
+                                         const char *content) {
+  char path[64];
+  xr_sandbox_proc_path(path, pid, name);
+  int fd = open(path, O_WRONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return false;
+  }
+  size_t length = strlen(content);
+  bool written = write(fd, content, length) == (ssize_t)length;
+  close(fd);
+  return written;
+}
+
+// map root of user namespace of sandbox to user of tracer.
+static inline bool xr_sandbox_map_ids(struct xr_sandbox_keeper_s *keeper,
+                                      pid_t pid) {
+  return xr_sandbox_write_file(pid, "uid_map", keeper->uid_map) &&
+         xr_sandbox_write_file(pid, "setgroups", "deny") &&
+         xr_sandbox_write_file(pid, "gid_map", keeper->gid_map);
+}
+
+static pid_t xr_sandbox_keeper_clone(struct xr_sandbox_keeper_s *keeper) {
+  int flags = keeper->flags;
+  struct xr_sandbox_init_s init = {.flags = flags};
+  if (pipe2(init.sync, O_CLOEXEC) == -1) {
+    return -1;
+  }
+  if (pipe2(init.ready, O_CLOEXEC) == -1) {
+    close(init.sync[0]);
+    close(init.sync[1]);
+    return -1;
+  }
+  pid_t pid = clone(xr_sandbox_init_main, keeper->stack + XR_SANDBOX_STACK,
+                    flags | SIGCHLD, &init);
+  close(init.sync[0]);
+  close(init.ready[1]);
+  char byte = 0;
+  if (pid != -1 &&
+      (((flags & CLONE_NEWUSER) && xr_sandbox_map_ids(keeper, pid) == false) ||
+       write(init.sync[1], &byte, sizeof(byte)) != sizeof(byte) ||
+       read(init.ready[0], &byte, sizeof(byte)) != sizeof(byte))) {
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, __WALL);
+    pid = -1;
+  }
+  close(init.sync[1]);
+  close(init.ready[0]);
+  return pid;
+}
+
+// building and destroying sandboxes only runs when cpu is idle, hence they
+// never delay spawn of a run.
+static inline void xr_sandbox_idle() {
+  struct sched_param param = {.sched_priority = 0};
+  sched_setscheduler(0, SCHED_IDLE, &param);
+}
+
+/**
+ * Keeper serves requests from background thread of pool: each pid_t read
+ * from sock asks for a sandbox, and pid of its init or -1 is written back.
+ * Inits are killed by pool, and reaped here.
+ *
+ * @keeper socket to pool, flags, stack and id maps prepared before fork
+ */
+static void xr_sandbox_keeper_main(struct xr_sandbox_keeper_s *keeper) {
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+  xr_sandbox_idle();
+  // keeper is out of process group of tracer and of any run.
+  setpgid(0, 0);
+  pid_t pid;
+  while (read(keeper->sock, &pid, sizeof(pid)) == sizeof(pid)) {
+    while (waitpid(-1, NULL, WNOHANG | __WALL) > 0) {
+    }
+    pid = xr_sandbox_keeper_clone(keeper);
+    if (write(keeper->sock, &pid, sizeof(pid)) != sizeof(pid)) {
+      break;
+    }
+  }
+  // pool has killed all inits before closing sock.
+  while (waitpid(-1, NULL, __WALL) > 0) {
+  }
+  _exit(0);
+}
+
+static void xr_sandbox_destroy(xr_sandbox_t *sandbox) {
+  for (int i = 0; i < XR_SANDBOX_NNS; ++i) {
+    if (sandbox->ns[i] != -1) {
+      close(sandbox->ns[i]);
+    }
+  }
+  // pid namespace dies with its init, keeper reaps init.
+  kill(sandbox->init, SIGKILL);
+  free(sandbox);
+}
+
+static xr_sandbox_t *xr_sandbox_build(xr_sandbox_pool_t *pool) {
+  pid_t init = -1;
+  if (write(pool->sock, &init, sizeof(init)) != sizeof(init) ||
+      read(pool->sock, &init, sizeof(init)) != sizeof(init) || init == -1) {
+    return NULL;
+  }
+  xr_sandbox_t *sandbox = _XR_NEW(xr_sandbox_t);
+  sandbox->init = init;
+  sandbox->pool = pool;
+  for (int i = 0; i < XR_SANDBOX_NNS; ++i) {
+    sandbox->ns[i] = -1;
+  }
+  char path[64];
+  for (int i = 0; i < XR_SANDBOX_NNS; ++i) {
+    if ((pool->flags & xr_sandbox_ns_flags[i]) == 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "/proc/%d/ns/%s", init,
+             xr_sandbox_ns_names[i]);
+    sandbox->ns[i] = open(path, O_RDONLY | O_CLOEXEC);
+    if (sandbox->ns[i] == -1) {
+      xr_sandbox_destroy(sandbox);
+      return NULL;
+    }
+  }
+  return sandbox;
+}
+
+static void *xr_sandbox_pool_main(void *arg) {
+  xr_sandbox_pool_t *pool = arg;
+  xr_sandbox_idle();
+  pthread_mutex_lock(&pool->lock);
+  while (pool->stop == false) {
+    // ready sandboxes come first, used ones are destroyed when idle.
+    if (pool->failed == false &&
+        pool->nready < pool->nwarm + pool->nwaiting) {
+      pthread_mutex_unlock(&pool->lock);
+      xr_sandbox_t *sandbox = xr_sandbox_build(pool);
+      pthread_mutex_lock(&pool->lock);
+      if (sandbox == NULL) {
+        pool->failed = true;
+      } else {
+        xr_list_add(&pool->warm, &sandbox->sandboxes);
+        pool->nready++;
+      }
+      pthread_cond_broadcast(&pool->ready);
+    } else if (xr_list_empty(&pool->used) == false) {
+      xr_list_t *used = pool->used.next;
+      xr_list_del(used);
+      pthread_mutex_unlock(&pool->lock);
+      xr_sandbox_destroy(xr_list_entry(used, xr_sandbox_t, sandboxes));
+      pthread_mutex_lock(&pool->lock);
+    } else {
+      pthread_cond_wait(&pool->dirty, &pool->lock);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+bool xr_sandbox_pool_init(xr_sandbox_pool_t *pool, int flags, size_t nwarm) {
+  memset(pool, 0, sizeof(xr_sandbox_pool_t));
+  pool->flags = flags ? flags : xr_sandbox_default_flags();
+  pool->nwarm = nwarm;
+  xr_list_init(&pool->warm);
+  xr_list_init(&pool->used);
+  pool->pidns = open("/proc/self/ns/pid", O_RDONLY | O_CLOEXEC);
+  if (pool->pidns == -1) {
+    return false;
+  }
+  int sock[2];
+  struct xr_sandbox_keeper_s keeper = {.flags = pool->flags};
+  keeper.stack = malloc(XR_SANDBOX_STACK);
+  snprintf(keeper.uid_map, sizeof(keeper.uid_map), "0 %d 1\n", (int)getuid());
+  snprintf(keeper.gid_map, sizeof(keeper.gid_map), "0 %d 1\n", (int)getgid());
+  if (keeper.stack == NULL ||
+      socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sock) == -1) {
+    free(keeper.stack);
+    close(pool->pidns);
+    return false;
+  }
+  pool->keeper = fork();
+  if (pool->keeper == 0) {
+    close(sock[0]);
+    keeper.sock = sock[1];
+    xr_sandbox_keeper_main(&keeper);
+  }
+  // keeper has a copy of stack of its own.
+  free(keeper.stack);
+  close(sock[1]);
+  pool->sock = sock[0];
+  // set by both sides, so no run spawned meanwhile finds keeper in its group.
+  if (pool->keeper != -1) {
+    setpgid(pool->keeper, pool->keeper);
+  }
+  if (pool->keeper == -1) {
+    close(pool->sock);
+    close(pool->pidns);
+    return false;
+  }
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->ready, NULL);
+  pthread_cond_init(&pool->dirty, NULL);
+  if (pthread_create(&pool->thread, NULL, xr_sandbox_pool_main, pool) != 0) {
+    close(pool->sock);
+    waitpid(pool->keeper, NULL, __WALL);
+    close(pool->pidns);
+    return false;
+  }
+  return true;
+}
+
+xr_sandbox_t *xr_sandbox_pool_take(xr_sandbox_pool_t *pool) {
+  xr_sandbox_t *sandbox = NULL;
+  pthread_mutex_lock(&pool->lock);
+  while (pool->nready == 0 && pool->failed == false) {
+    pool->nwaiting++;
+    pthread_cond_signal(&pool->dirty);
+    pthread_cond_wait(&pool->ready, &pool->lock);
+    pool->nwaiting--;
+  }
+  if (pool->nready != 0) {
+    xr_list_t *warm = pool->warm.next;
+    xr_list_del(warm);
+    pool->nready--;
+    sandbox = xr_list_entry(warm, xr_sandbox_t, sandboxes);
+    // background thread builds a sandbox in place of it.
+    pthread_cond_signal(&pool->dirty);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return sandbox;
+}
+
+void xr_sandbox_pool_put(xr_sandbox_pool_t *pool, xr_sandbox_t *sandbox) {
+  pthread_mutex_lock(&pool->lock);
+  xr_list_add(&pool->used, &sandbox->sandboxes);
+  pthread_cond_signal(&pool->dirty);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void xr_sandbox_pool_delete(xr_sandbox_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_signal(&pool->dirty);
+  pthread_mutex_unlock(&pool->lock);
+  pthread_join(pool->thread, NULL);
+  xr_list_t *lists[] = {&pool->warm, &pool->used};
+  for (int i = 0; i < 2; ++i) {
+    xr_list_t *cur, *temp;
+    _xr_list_for_each_safe(lists[i], cur, temp) {
+      xr_list_del(cur);
+      xr_sandbox_destroy(xr_list_entry(cur, xr_sandbox_t, sandboxes));
+    }
+  }
+  // keeper exits on end of file, inits left die with it.
+  close(pool->sock);
+  waitpid(pool->keeper, NULL, __WALL);
+  close(pool->pidns);
+  pthread_cond_destroy(&pool->dirty);
+  pthread_cond_destroy(&pool->ready);
+  pthread_mutex_destroy(&pool->lock);
+}
+
+bool xr_sandbox_fork_begin(xr_sandbox_t *sandbox) {
+  int ns = sandbox->ns[XR_SANDBOX_NS_PID];
+  return ns == -1 || setns(ns, CLONE_NEWPID) == 0;
+}
+
+bool xr_sandbox_fork_end(xr_sandbox_t *sandbox) {
+  return sandbox->ns[XR_SANDBOX_NS_PID] == -1 ||
+         setns(sandbox->pool->pidns, CLONE_NEWPID) == 0;
+}
+
+bool xr_sandbox_enter(xr_sandbox_t *sandbox) {
+  // user namespace goes first, which grants joining the others.
+  for (int i = 0; i < XR_SANDBOX_NS_PID; ++i) {
+    if (sandbox->ns[i] != -1 &&
+        setns(sandbox->ns[i], xr_sandbox_ns_flags[i]) == -1) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -1,13 +1,34 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
+#include "xrun/capture.h"
 #include "xrun/checker.h"
 #include "xrun/checkers.h"
+#include "xrun/entry.h"
 #include "xrun/option.h"
+#include "xrun/placement.h"
+#include "xrun/probe.h"
 #include "xrun/process.h"
 #include "xrun/result.h"
+#include "xrun/sandbox.h"
+#include "xrun/stats.h"
 #include "xrun/tracer.h"
+#include "xrun/utils/proc.h"
 #include "xrun/utils/utils.h"
+#include "xrun/workspace.h"
 
 #define _XR_TRACER_TRACE_ERROR(ok, tracer, ...) \
   do {                                          \
@@ -15,10 +36,21 @@
     _XR_TRACER_ERROR(tracer, __VA_ARGS__);      \
   } while (0)
 
-static inline void xr_collect_process(xr_process_t *process,
+static inline void xr_collect_process(const xr_tracer_t *tracer,
+                                      xr_process_t *process,
                                       xr_tracer_process_result_t *presult) {
   presult->nthread = process->nthread;
   presult->memory = process->memory;
+  presult->time = process->time;
+  presult->cpu_ns = process->cpu_ns > process->cpu_setup
+                      ? process->cpu_ns - process->cpu_setup
+                      : 0;
+  presult->cpu_ms = xr_time_ms_from_ns(presult->cpu_ns);
+  presult->nstop = process->nstop;
+  presult->compensated_time =
+    xr_tracer_compensate_time(tracer, process->nstop, process->time);
+  presult->compensated_cpu_ns =
+    xr_tracer_compensate_ns(tracer, process->nstop, presult->cpu_ns);
   presult->nfile = process->nfile;
   presult->io_read = presult->io_write = 0;
   xr_thread_t *thread;
@@ -34,11 +66,54 @@ static inline void xr_collect_process(xr_process_t *process,
   }
 }
 
+/**
+ * Account a syscall stop in profile of result.
+ *
+ * @@result
+ * @trap syscall trap
+ * @now time when trap returned
+ *
+ * @return profile entry of syscall, or NULL if profile is not collected.
+ */
+static inline xr_result_call_t *xr_result_profile(xr_result_t *result,
+                                                  xr_trace_trap_t *trap,
+                                                  unsigned long long now) {
+  xr_thread_t *thread = trap->thread;
+  if (thread->syscall_status == XR_THREAD_CALLOUT) {
+    xr_result_call_t *call = thread->call;
+    // exit stop of a syscall whose entry was not seen, e.g. clone in child.
+    if (call != NULL) {
+      unsigned long long latency = now - thread->call_start;
+      call->total += latency;
+      if (latency > call->max) {
+        call->max = latency;
+      }
+    }
+    thread->call = NULL;
+    return call;
+  }
+  long syscall = trap->syscall_info.syscall;
+  int compat = thread->process->compat;
+  if (syscall < 0 || syscall >= XR_SYSCALL_MAX ||
+      compat <= XR_COMPAT_SYSCALL_INVALID || compat >= XR_COMPAT_SYSCALL_MAX) {
+    return NULL;
+  }
+  xr_result_call_t *call = &result->profile[compat * XR_SYSCALL_MAX + syscall];
+  call->count++;
+  // seccomp never reports the exit stop, it is then always an entry stop.
+  thread->call = call;
+  thread->call_start = now;
+  return call;
+}
+
 #define XR_RESULT_PROCESS_EXIT_ABORT -1
-static inline void xr_result_process(xr_result_t *result, xr_process_t *process,
+static inline void xr_result_process(const xr_tracer_t *tracer,
+                                     xr_result_t *result, xr_process_t *process,
                                      int exit_code) {
   xr_tracer_process_result_t *presult = _XR_NEW(xr_tracer_process_result_t);
-  xr_collect_process(process, presult);
+  xr_collect_process(tracer, process, presult);
+  result->cpu_ns += presult->cpu_ns;
+  result->compensated_cpu_ns += presult->compensated_cpu_ns;
   if (exit_code == XR_RESULT_PROCESS_EXIT_ABORT) {
     presult->next = result->aborted_processes;
     result->aborted_processes = presult;
@@ -46,58 +121,311 @@ static inline void xr_result_process(xr_result_t *result, xr_process_t *process,
     presult->next = result->exited_processes;
     result->exited_processes = presult;
   }
+  result->sched.nmigration += process->nmigration;
   return;
 }
 
+static inline unsigned long long xr_tracer_timeval_ns(struct timeval tv) {
+  return tv.tv_sec * 1000000000ull + tv.tv_usec * 1000ull;
+}
+
+/*
+ * cpu time, context switches and page faults of tracees come from rusage of
+ * reaped children, those of tracer from rusage of its thread. Tracer samples
+ * them before and after run.
+ */
+static inline void xr_tracer_sched_sample(xr_result_sched_t *tracees,
+                                          xr_result_sched_t *tracer) {
+  struct rusage ru;
+  getrusage(RUSAGE_CHILDREN, &ru);
+  tracees->user_ns = xr_tracer_timeval_ns(ru.ru_utime);
+  tracees->sys_ns = xr_tracer_timeval_ns(ru.ru_stime);
+  tracees->nvcsw = ru.ru_nvcsw;
+  tracees->nivcsw = ru.ru_nivcsw;
+  tracees->nminflt = ru.ru_minflt;
+  tracees->nmajflt = ru.ru_majflt;
+  tracees->nmigration = 0;
+  getrusage(RUSAGE_THREAD, &ru);
+  tracer->user_ns = xr_tracer_timeval_ns(ru.ru_utime);
+  tracer->sys_ns = xr_tracer_timeval_ns(ru.ru_stime);
+  tracer->nvcsw = ru.ru_nvcsw;
+  tracer->nivcsw = ru.ru_nivcsw;
+  tracer->nminflt = ru.ru_minflt;
+  tracer->nmajflt = ru.ru_majflt;
+  tracer->nmigration = 0;
+  xr_proc_nmigration(syscall(__NR_gettid), &tracer->nmigration);
+}
+
+static inline void xr_tracer_sched_account(xr_result_sched_t *sched,
+                                           const xr_result_sched_t *start,
+                                           const xr_result_sched_t *end) {
+  sched->user_ns = end->user_ns - start->user_ns;
+  sched->sys_ns = end->sys_ns - start->sys_ns;
+  sched->nvcsw = end->nvcsw - start->nvcsw;
+  sched->nivcsw = end->nivcsw - start->nivcsw;
+  sched->nminflt = end->nminflt - start->nminflt;
+  sched->nmajflt = end->nmajflt - start->nmajflt;
+  sched->nmigration += end->nmigration - start->nmigration;
+}
+
+static inline void xr_tracer_record(xr_tracer_t *tracer,
+                                    xr_trace_trap_t *trap, bool checked) {
+  xr_record_t *record = xr_recorder_next(&tracer->recorder);
+  record->time = xr_time_now_ns();
+  record->tid = trap->thread->tid;
+  record->trap = trap->trap;
+  record->compat = trap->thread->process->compat;
+  record->out = trap->thread->syscall_status == XR_THREAD_CALLOUT;
+  record->checker =
+    checked ? XR_RECORD_PASSED : tracer->failed_checker->checker_id;
+  memset(record->args, 0, sizeof(record->args));
+  record->retval = 0;
+  switch (trap->trap) {
+    case XR_TRACE_TRAP_SYSCALL:
+      record->nr = trap->syscall_info.nr;
+      memcpy(record->args, trap->syscall_info.args, sizeof(record->args));
+      record->retval = trap->syscall_info.retval;
+      break;
+    case XR_TRACE_TRAP_SIGNAL:
+      record->nr = trap->stop_signal;
+      break;
+    default:
+      record->nr = trap->exit_code;
+      break;
+  }
+  xr_recorder_commit(&tracer->recorder);
+}
+
+static inline bool xr_tracer_noisy(const xr_noise_t *noise,
+                                   const xr_result_t *result) {
+  return result->sched.nivcsw > noise->nivcsw ||
+         result->sched.nmigration > noise->nmigration ||
+         result->sched.nmajflt > noise->nmajflt ||
+         result->steal_ns > noise->steal_ns;
+}
+
+static inline bool xr_tracer_perf_enabled(const xr_option_t *option) {
+  return option->perf || option->limit.perf.task_clock != XR_PERF_UNLIMITED ||
+         option->limit.perf.instructions != XR_PERF_UNLIMITED;
+}
+
+// set once limited counters of the run traced by this thread overflow.
+static __thread volatile sig_atomic_t xr_tracer_overflowed;
+// runs counting with limits in any thread, and disposition of SIGXCPU
+// before the first of them.
+static pthread_mutex_t xr_tracer_overflow_lock = PTHREAD_MUTEX_INITIALIZER;
+static int xr_tracer_overflow_nrun;
+static struct sigaction xr_tracer_overflow_saved;
+
+// SIGXCPU of RLIMIT_CPU comes from kernel rather than a counter.
+static void xr_tracer_overflow(int signal, siginfo_t *info, void *context) {
+  if (info->si_code == POLL_IN || info->si_code == POLL_HUP) {
+    xr_tracer_overflowed = 1;
+  }
+}
+
+/**
+ * Handle SIGXCPU while a run counts with limits. Handler is shared by runs
+ * of all threads, the first run installs it and the last one restores the
+ * disposition of caller. Without SA_RESTART, wait of tracer fails with EINTR.
+ *
+ * @handle true when a run begins counting, false when its counters are closed
+ */
+static void xr_tracer_overflow_handle(bool handle) {
+  pthread_mutex_lock(&xr_tracer_overflow_lock);
+  if (handle && xr_tracer_overflow_nrun++ == 0) {
+    struct sigaction action = {
+      .sa_sigaction = xr_tracer_overflow,
+      .sa_flags = SA_SIGINFO,
+    };
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGXCPU, &action, &xr_tracer_overflow_saved);
+  } else if (handle == false && --xr_tracer_overflow_nrun == 0) {
+    sigaction(SIGXCPU, &xr_tracer_overflow_saved, NULL);
+  }
+  pthread_mutex_unlock(&xr_tracer_overflow_lock);
+}
+
+bool xr_tracer_perf_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  if (xr_tracer_overflowed == 0) {
+    return false;
+  }
+  xr_tracer_overflowed = 0;
+  xr_process_t *process;
+  _xr_list_for_each_entry(&tracer->processes, process, xr_process_t,
+                          processes) {
+    xr_thread_t *thread = xr_process_first_thread(process);
+    if (thread != NULL) {
+      trap->trap = XR_TRACE_TRAP_SIGNAL;
+      trap->thread = thread;
+      trap->stop_signal = SIGXCPU;
+      trap->synthetic = true;
+      return true;
+    }
+  }
+  return false;
+}
+
 bool xr_tracer_trace(xr_tracer_t *tracer, xr_entry_t *entry,
                      xr_result_t *result) {
   bool ok = true;
   xr_trace_trap_t trap = {.trap = XR_TRACE_TRAP_NONE};
+  // whether this run holds handler of SIGXCPU.
+  bool overflow = false;
   result->status = XR_RESULT_UNKNOWN;
-  if (tracer->spwan(tracer, entry) == false) {
+  tracer->nstop = 0;
+  unsigned long nrecord = tracer->recorder.nrecord;
+  xr_result_sched_t tracees_start, tracer_start, tracees_end, tracer_end;
+  xr_tracer_sched_sample(&tracees_start, &tracer_start);
+  unsigned long long steal_start = 0, steal_end = 0;
+  xr_proc_steal_ns(&steal_start);
+  const xr_placement_t *placement = &tracer->option->placement;
+  if (xr_placement_enabled(placement) &&
+      xr_placement_begin(&tracer->placement, placement) == false) {
+    _XR_TRACER_TRACE_ERROR(ok, tracer, "place run failed.");
+  }
+  // entry of this run, whose pwd is the workspace if there is one.
+  xr_entry_t run = *entry;
+  if (ok && tracer->workspaces != NULL) {
+    tracer->workspace = xr_workspace_pool_take(tracer->workspaces);
+    if (tracer->workspace == NULL) {
+      _XR_TRACER_TRACE_ERROR(ok, tracer, "take workspace failed.");
+    } else {
+      run.pwd = tracer->workspace->path;
+    }
+  }
+  if (ok && tracer->sandboxes != NULL) {
+    tracer->sandbox = xr_sandbox_pool_take(tracer->sandboxes);
+    if (tracer->sandbox == NULL) {
+      _XR_TRACER_TRACE_ERROR(ok, tracer, "take sandbox failed.");
+    } else if (xr_sandbox_fork_begin(tracer->sandbox) == false) {
+      _XR_TRACER_TRACE_ERROR(ok, tracer, "join pid namespace failed.");
+    }
+  }
+  if (ok) {
+    XR_PROBE0(spawn__begin);
+  }
+  if (ok && tracer->spwan(tracer, &run) == false) {
     _XR_TRACER_TRACE_ERROR(ok, tracer, "tracer spwan error.");
-  } else {
+  }
+  // later forks of tracer, if any, stay in its own pid namespace.
+  if (tracer->sandbox != NULL &&
+      xr_sandbox_fork_end(tracer->sandbox) == false) {
+    _XR_TRACER_TRACE_ERROR(ok, tracer, "leave pid namespace failed.");
+  }
+  if (ok && tracer->capture != NULL) {
+    xr_capture_begin(tracer->capture, tracer);
+  }
+  // first tracee is trapped before its execve, and has not forked yet.
+  if (ok) {
+    xr_process_t *first =
+      xr_list_entry(tracer->processes.next, xr_process_t, processes);
+    xr_proc_cpu_ns(first->pid, &first->cpu_setup);
+    XR_PROBE1(spawn__end, first->pid);
+  }
+  if (ok && xr_tracer_perf_enabled(tracer->option)) {
+    xr_process_t *first =
+      xr_list_entry(tracer->processes.next, xr_process_t, processes);
+    const xr_perf_count_t *limit = &tracer->option->limit.perf;
+    overflow = limit->task_clock != XR_PERF_UNLIMITED ||
+               limit->instructions != XR_PERF_UNLIMITED;
+    if (overflow) {
+      xr_tracer_overflow_handle(true);
+    }
+    xr_tracer_overflowed = 0;
+    if (xr_perf_open(&tracer->perf, first->pid, limit, syscall(__NR_gettid),
+                     SIGXCPU) == false) {
+      _XR_TRACER_TRACE_ERROR(ok, tracer, "open perf counters failed.");
+    }
+  }
+  if (ok) {
     while (ok && xr_list_empty(&tracer->processes) == false) {
+      XR_STATS_BEGIN(tracer->stats, trap_start);
+      trap.synthetic = false;
       if (tracer->trap(tracer, &trap) == false) {
         _XR_TRACER_TRACE_ERROR(ok, tracer, "tracer trap failed.");
         break;
       }
-      if (xr_tracer_check(tracer, result, &trap) == false) {
+      XR_STATS_END(tracer->stats, phases[XR_STATS_TRAP], trap_start);
+      XR_PROBE4(trap, trap.thread->tid, trap.trap,
+                trap.trap == XR_TRACE_TRAP_SYSCALL ? trap.syscall_info.syscall
+                                                   : trap.exit_code,
+                trap.thread->syscall_status);
+      if (tracer->capture != NULL) {
+        xr_capture_trap(tracer->capture, tracer, &trap);
+      }
+      unsigned long long trapped = 0;
+      xr_result_call_t *call = NULL;
+      if (result->profile != NULL && trap.trap == XR_TRACE_TRAP_SYSCALL) {
+        trapped = xr_time_now_ns();
+        call = xr_result_profile(result, &trap, trapped);
+      }
+      result->ntrap++;
+      // only stops cost tracee cpu time, exits and synthetic traps do not.
+      if (trap.trap == XR_TRACE_TRAP_SYSCALL ||
+          (trap.trap == XR_TRACE_TRAP_SIGNAL && trap.synthetic == false)) {
+        trap.thread->process->nstop++;
+        tracer->nstop++;
+      }
+      if (result->ntrap_calls != NULL && trap.trap == XR_TRACE_TRAP_SYSCALL &&
+          trap.syscall_info.syscall >= 0 &&
+          trap.syscall_info.syscall < XR_SYSCALL_MAX) {
+        result->ntrap_calls[trap.syscall_info.syscall]++;
+      }
+      XR_STATS_BEGIN(tracer->stats, check_start);
+      bool checked = xr_tracer_check(tracer, result, &trap);
+      XR_STATS_END(tracer->stats, phases[XR_STATS_CHECK], check_start);
+      xr_tracer_record(tracer, &trap, checked);
+      if (trap.trap == XR_TRACE_TRAP_SYSCALL &&
+          trap.syscall_info.syscall >= 0 &&
+          trap.syscall_info.syscall < XR_SYSCALL_MAX) {
+        XR_STATS_END(tracer->stats, calls[trap.syscall_info.syscall],
+                     check_start);
+      }
+      if (checked == false) {
         ok = false;
-        xr_collect_process(trap.thread->process, &result->error_process);
+        _XR_CALLP(tracer, sample, trap.thread->process);
+        xr_collect_process(tracer, trap.thread->process,
+                           &result->error_process);
         break;
       }
 
       if (trap.trap == XR_TRACE_TRAP_EXIT) {
         xr_process_t *trap_process = trap.thread->process;
         xr_process_remove_thread(trap_process, trap.thread, false);
+        XR_PROBE3(thread__exit, trap.thread->tid, trap_process->pid,
+                  trap.exit_code);
         if (xr_list_empty(&trap_process->threads)) {
-          xr_result_process(result, trap_process, trap.exit_code);
+          XR_PROBE2(process__exit, trap_process->pid, trap.exit_code);
+          xr_result_process(tracer, result, trap_process, trap.exit_code);
           xr_list_del(&trap_process->processes);
-          xr_process_delete(trap_process);
-          free(trap_process);
+          xr_tracer_free_process(tracer, trap_process);
         }
-        xr_thread_delete(trap.thread);
-        free(trap.thread);
+        xr_tracer_free_thread(tracer, trap.thread);
         // a exited thread/process do not step again.
         continue;
       }
+      XR_STATS_BEGIN(tracer->stats, step_start);
       if (tracer->step(tracer, &trap) == false) {
         _XR_TRACER_TRACE_ERROR(ok, tracer, "tracer step failed.");
       }
+      XR_STATS_END(tracer->stats, phases[XR_STATS_STEP], step_start);
+      if (call != NULL) {
+        call->tracer += xr_time_now_ns() - trapped;
+      }
     }
   }
+  XR_STATS_BEGIN(tracer->stats, teardown_start);
+  XR_PROBE1(teardown__begin, result->status);
   if (!ok) {
-    xr_list_t *cur_process, *tmp_process;
-    _xr_list_for_each_safe(&tracer->processes, cur_process, tmp_process) {
-      xr_process_t *process =
-        xr_list_entry(cur_process, xr_process_t, processes);
-      xr_thread_t *thread;
-      _xr_list_for_each_entry(&process->threads, thread, xr_thread_t, threads) {
-        _XR_CALLP(tracer, kill, thread->tid);
-      }
-      _XR_CALLP(tracer, kill, process->pid);
-      xr_result_process(result, process, XR_RESULT_PROCESS_EXIT_ABORT);
+    // tracees are killed by xr_tracer_clean, after their usage is sampled.
+    xr_process_t *process;
+    _xr_list_for_each_entry(&tracer->processes, process, xr_process_t,
+                            processes) {
+      _XR_CALLP(tracer, sample, process);
+      xr_proc_nmigration(process->pid, &process->nmigration);
+      xr_result_process(tracer, result, process,
+                        XR_RESULT_PROCESS_EXIT_ABORT);
     }
     if (result->status == XR_RESULT_UNKNOWN) {
       result->status = XR_RESULT_TRACERERR;
@@ -106,7 +434,40 @@ bool xr_tracer_trace(xr_tracer_t *tracer, xr_entry_t *entry,
     result->status = XR_RESULT_OK;
   }
   result->nprocess = tracer->nprocess;
+  result->nrecord = tracer->recorder.nrecord - nrecord;
   xr_tracer_clean(tracer);
+  xr_tracer_sched_sample(&tracees_end, &tracer_end);
+  if (xr_proc_steal_ns(&steal_end)) {
+    result->steal_ns = steal_end - steal_start;
+  }
+  // all tracees are reaped, their counts are final.
+  if (xr_perf_opened(&tracer->perf)) {
+    xr_perf_read(&tracer->perf, &result->perf);
+    xr_perf_close(&tracer->perf);
+    xr_perf_count_t count = result->perf;
+    if (tracer->option->compensate &&
+        count.task_clock != XR_PERF_UNAVAILABLE) {
+      count.task_clock =
+        xr_tracer_compensate_ns(tracer, tracer->nstop, count.task_clock);
+    }
+    if (result->status == XR_RESULT_OK &&
+        xr_perf_exceeded(&count, &tracer->option->limit.perf)) {
+      result->status = XR_RESULT_TIMEOUT;
+    }
+  }
+  // counters are closed, none of them signals any more.
+  if (overflow) {
+    xr_perf_close(&tracer->perf);
+    xr_tracer_overflow_handle(false);
+  }
+  xr_tracer_sched_account(&result->sched, &tracees_start, &tracees_end);
+  xr_tracer_sched_account(&result->tracer_sched, &tracer_start, &tracer_end);
+  result->noisy = xr_tracer_noisy(&tracer->option->noise, result);
+  if (tracer->capture != NULL) {
+    xr_capture_end(tracer->capture, result);
+  }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_TEARDOWN], teardown_start);
+  XR_PROBE2(teardown__end, result->status, result->ntrap);
   return result->status != XR_RESULT_UNKNOWN &&
          result->status != XR_RESULT_TRACERERR;
 }
@@ -129,7 +490,12 @@ bool xr_tracer_check(xr_tracer_t *tracer, xr_result_t *result,
   xr_checker_t *checker;
   _xr_list_for_each_entry(&(tracer->checkers), checker, xr_checker_t,
                           checkers) {
-    if (_XR_CALLP(checker, check, tracer, trap) == false) {
+    XR_STATS_BEGIN(tracer->stats, start);
+    bool checked = _XR_CALLP(checker, check, tracer, trap);
+    XR_STATS_END(tracer->stats, checkers[checker->checker_id], start);
+    XR_PROBE3(check, checker->checker_id, trap->thread->tid, checked);
+    if (checked == false) {
+      tracer->failed_checker = checker;
       _XR_CALLP(checker, result, tracer, result);
       result->epid = trap->thread->process->pid;
       result->etid = trap->thread->tid;
@@ -139,20 +505,68 @@ bool xr_tracer_check(xr_tracer_t *tracer, xr_result_t *result,
   return true;
 }
 
+void xr_tracer_own_group(xr_tracer_t *tracer, xr_entry_t *entry, pid_t pid) {
+  tracer->pgid = pid;
+  int fd = entry->stdio[0];
+  if (isatty(fd) && tcgetpgrp(fd) == getpgrp() && tcsetpgrp(fd, pid) == 0) {
+    tracer->tty = fd;
+  }
+  // isatty sets errno if stdin is not a terminal.
+  errno = 0;
+}
+
+/**
+ * Take terminal back from group of run. Tracer is a background group by
+ * now, which is stopped by SIGTTOU unless it blocks the signal.
+ *
+ * @@tracer
+ */
+static inline void xr_tracer_disown_group(xr_tracer_t *tracer) {
+  if (tracer->tty == -1) {
+    return;
+  }
+  sigset_t ttou, mask;
+  sigemptyset(&ttou);
+  sigaddset(&ttou, SIGTTOU);
+  sigprocmask(SIG_BLOCK, &ttou, &mask);
+  tcsetpgrp(tracer->tty, getpgrp());
+  sigprocmask(SIG_SETMASK, &mask, NULL);
+  tracer->tty = -1;
+}
+
 void xr_tracer_clean(xr_tracer_t *tracer) {
   xr_list_t *cur, *temp;
   xr_process_t *process;
 
+  // one signal kills the whole run, tasks forked meanwhile are in the group
+  // as well.
+  if (tracer->pgid > 0) {
+    kill(-tracer->pgid, SIGKILL);
+  }
   // free tracer process list and delete tracer process
   _xr_list_for_each_safe(&(tracer->processes), cur, temp) {
     xr_list_del(cur);
     process = xr_list_entry(cur, xr_process_t, processes);
+    // process may have left group of run by setpgid or setsid.
     tracer->kill(tracer, process->pid);
-    xr_process_delete(process);
-    free(process);
+    xr_tracer_free_process(tracer, process);
   }
 
+  // tracer reaps tracees in its clean op.
   _XR_CALLP(tracer, clean);
+  // killing init of sandbox kills tasks left in its pid namespace.
+  if (tracer->sandbox != NULL) {
+    xr_sandbox_pool_put(tracer->sandboxes, tracer->sandbox);
+    tracer->sandbox = NULL;
+  }
+  // workspace is reset by pool, after all tracees are reaped.
+  if (tracer->workspace != NULL) {
+    xr_workspace_pool_put(tracer->workspaces, tracer->workspace);
+    tracer->workspace = NULL;
+  }
+  xr_placement_end(&tracer->placement);
+  xr_tracer_disown_group(tracer);
+  tracer->pgid = 0;
   tracer->nprocess = 0;
   tracer->nthread = 0;
   tracer->failed_checker = NULL;
@@ -171,6 +585,62 @@ void xr_tracer_delete(xr_tracer_t *tracer) {
   // clean up all process
   xr_tracer_clean(tracer);
   _XR_CALLP(tracer, _delete);
+  xr_placement_run_delete(&tracer->placement);
+  xr_perf_close(&tracer->perf);
+  free(tracer->stats);
+  tracer->stats = NULL;
+  xr_pool_delete(&tracer->process_pool);
+  xr_pool_delete(&tracer->thread_pool);
+}
+
+bool xr_tracer_sample_proc(xr_tracer_t *tracer, xr_process_t *process) {
+  bool sampled = xr_proc_cpu_ns(process->pid, &process->cpu_ns);
+  return xr_proc_sample(process->pid, &process->time, &process->memory) &&
+         sampled;
+}
+
+bool xr_tracer_task_path_proc(xr_tracer_t *tracer, int tid, int fd,
+                              xr_path_t *path) {
+  char link[64];
+  if (fd == AT_FDCWD) {
+    snprintf(link, sizeof(link), "/proc/%d/cwd", tid);
+  } else {
+    snprintf(link, sizeof(link), "/proc/%d/fd/%d", tid, fd);
+  }
+  xr_string_grow(path, XR_PATH_MAX);
+  ssize_t length = readlink(link, path->string, path->capacity - 1);
+  if (length == -1) {
+    return false;
+  }
+  path->length = length;
+  path->string[length] = 0;
+  return true;
+}
+
+bool xr_tracer_take_clone_flags(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  long *args = trap->syscall_info.args;
+  unsigned long flags = XR_THREAD_CLONE_UNKNOWN;
+  switch (trap->syscall_info.syscall) {
+#ifdef XR_SYSCALL_CLONE
+    case XR_SYSCALL_CLONE:
+      flags = args[0];
+      break;
+#endif
+#ifdef XR_SYSCALL_FORK
+    case XR_SYSCALL_FORK:
+      flags = SIGCHLD;
+      break;
+#endif
+#ifdef XR_SYSCALL_VFORK
+    case XR_SYSCALL_VFORK:
+      flags = CLONE_VM | CLONE_VFORK | SIGCHLD;
+      break;
+#endif
+    default:
+      return false;
+  }
+  trap->thread->clone_flags = flags;
+  return true;
 }
 
 bool xr_tracer_error(xr_tracer_t *tracer, const char *msg, ...) {
@@ -195,3 +665,85 @@ bool xr_tracer_add_checker(xr_tracer_t *tracer, xr_checker_id_t cid) {
   xr_list_add(&tracer->checkers, &checker->checkers);
   return true;
 }
+
+bool xr_tracer_enable_stats(xr_tracer_t *tracer) {
+#ifdef XR_STATS
+  if (tracer->stats == NULL) {
+    tracer->stats = _XR_NEW(xr_stats_t);
+    xr_stats_init(tracer->stats);
+  }
+  return true;
+#else
+  return _XR_TRACER_ERROR(tracer, "xrun is configured without --enable-stats.");
+#endif
+}
+
+#define XR_TRACER_CALIBRATE_RUNS 3
+
+/*
+ * cpu time of entry run natively in ns. Child stops itself before execve, as
+ * first tracee is trapped, and its cpu time by then is left out.
+ */
+static bool xr_tracer_calibrate_native(xr_entry_t *entry,
+                                       unsigned long long *ns) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    raise(SIGSTOP);
+    xr_entry_execve(entry);
+    _exit(127);
+  } else if (pid == -1) {
+    return false;
+  }
+  int status;
+  unsigned long long setup = 0;
+  bool ok = waitpid(pid, &status, WUNTRACED) == pid && WIFSTOPPED(status) &&
+            xr_proc_cpu_ns(pid, &setup);
+  kill(pid, SIGCONT);
+  // cpu clock of a zombie is still readable, until it is reaped.
+  siginfo_t info;
+  ok = waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == 0 &&
+       xr_proc_cpu_ns(pid, ns) && ok;
+  ok = waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+       WEXITSTATUS(status) == 0 && ok;
+  *ns = *ns > setup ? *ns - setup : 0;
+  return ok;
+}
+
+static bool xr_tracer_calibrate_traced(xr_tracer_t *tracer, xr_entry_t *entry,
+                                       unsigned long long *ns,
+                                       unsigned long *nstop) {
+  xr_result_t result;
+  xr_result_init(&result);
+  bool ok = xr_tracer_trace(tracer, entry, &result) &&
+            result.status == XR_RESULT_OK;
+  *ns = result.cpu_ns;
+  *nstop = tracer->nstop;
+  xr_result_delete(&result);
+  return ok;
+}
+
+bool xr_tracer_calibrate(xr_tracer_t *tracer, xr_entry_t *entry) {
+  unsigned long long native = ULLONG_MAX, traced = ULLONG_MAX, ns;
+  unsigned long nstop = 0, n;
+  tracer->stop_ns = 0;
+  // runs take turns, and the fastest one of each kind is least disturbed.
+  for (int i = 0; i < XR_TRACER_CALIBRATE_RUNS; ++i) {
+    if (xr_tracer_calibrate_native(entry, &ns) == false) {
+      return _XR_TRACER_ERROR(tracer, "native calibration run failed.");
+    }
+    if (ns < native) {
+      native = ns;
+    }
+    if (xr_tracer_calibrate_traced(tracer, entry, &ns, &n) == false) {
+      return _XR_TRACER_ERROR(tracer, "traced calibration run failed.");
+    }
+    if (ns < traced) {
+      traced = ns;
+      nstop = n;
+    }
+  }
+  if (nstop != 0 && traced > native) {
+    tracer->stop_ns = (traced - native) / nstop;
+  }
+  return true;
+}
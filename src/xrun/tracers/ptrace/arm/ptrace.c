@@ -17,6 +17,10 @@
 #define XR_ARM_r0 0
 #define XR_ARM_ORIG_r0 17
 
+#ifndef PTRACE_SET_SYSCALL
+#define PTRACE_SET_SYSCALL 23
+#endif
+
 // oabi syscall: swi NR + 0x900000
 // instruction: 0xef NR(24bit) + 0x900000
 // eabi syscall: swi 0x0
@@ -67,6 +71,8 @@ static inline bool xr_ptrace_tracer_peek_syscall_arm(
     syscall_info->syscall =
       xr_syscall_arm_private_convert(syscall_info->syscall);
   }
+  // both abis are named by the table of eabi.
+  syscall_info->nr = syscall_info->syscall;
 
   for (int i = 1; i <= 6; ++i) {
     syscall_info->args[i] = regs.uregs[i];
@@ -92,4 +98,12 @@ bool xr_ptrace_tracer_poke_syscall(int pid, long arg, int index, int compat) {
   return ptrace(PTRACE_POKEUSER, pid, index * sizeof(long), arg) == 0;
 }
 
+bool xr_ptrace_tracer_poke_scno(int pid, long scno) {
+  return ptrace(PTRACE_SET_SYSCALL, pid, NULL, scno) == 0;
+}
+
+bool xr_ptrace_tracer_poke_retval(int pid, long retval) {
+  return ptrace(PTRACE_POKEUSER, pid, XR_ARM_r0 * sizeof(long), retval) == 0;
+}
+
 #endif
@@ -3,22 +3,33 @@
 #include <stdbool.h>
 #include <stdlib.h>
 
+#include <errno.h>
 #include <fcntl.h>
+#include <sched.h>
 #include <signal.h>
 #include <sys/prctl.h>
 #include <sys/ptrace.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/wait.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "xrun/calls.h"
 #include "xrun/entry.h"
+#include "xrun/landlock.h"
 #include "xrun/option.h"
 #include "xrun/process.h"
+#include "xrun/sandbox.h"
+#include "xrun/stats.h"
 #include "xrun/tracer.h"
 #include "xrun/tracers/ptrace/tracer.h"
+#include "xrun/utils/hash.h"
+#include "xrun/utils/proc.h"
 #include "xrun/utils/utils.h"
+#include "xrun/workspace.h"
 
 /*
  * the implementation is in arch/ptrace_*.c depending on XR_ARCH_* marco.
@@ -30,37 +41,68 @@ extern bool xr_ptrace_tracer_peek_syscall(int pid,
 extern bool xr_ptrace_tracer_poke_syscall(int pid, long args, int index,
                                           int compat);
 
+/*
+ * set syscall number on entry, where -1 skips syscall, and return value on
+ * exit.
+ */
+extern bool xr_ptrace_tracer_poke_scno(int pid, long scno);
+
+extern bool xr_ptrace_tracer_poke_retval(int pid, long retval);
+
 extern int xr_ptrace_tracer_syscall_compat(int pid);
 
 extern int xr_ptrace_tracer_elf_compat(xr_path_t *elf);
 
-#define XR_TRACER_PTRACE_PENDING_CLONE_DEFAULT 4
+// tracees out of group of run are polled at this interval in ns until they
+// are reaped.
+#define XR_PTRACE_DRAIN_INTERVAL 1000000
+
+// children and tracees of other threads of caller are not waited for.
+#define XR_PTRACE_WAIT (__WALL | __WNOTHREAD)
 
-struct xr_tracer_ptrace_pending_clone_s;
-typedef struct xr_tracer_ptrace_pending_clone_s
-  xr_tracer_ptrace_pending_clone_t;
-struct xr_tracer_ptrace_pending_clone_s {
-  pid_t pid;
+#define XR_PTRACE_CLONE_THREAD \
+  (CLONE_VM | CLONE_FS | CLONE_FILES | CLONE_SIGHAND | CLONE_THREAD)
+
+struct xr_tracer_ptrace_task_s;
+typedef struct xr_tracer_ptrace_task_s xr_tracer_ptrace_task_t;
+/*
+ * a traced task indexed by its tid. The first stop of a new task and the
+ * clone event of its parent come in any order, whichever comes first leaves
+ * a task here for the other one:
+ * 1. the event creates thread of task, whose first stop is swallowed.
+ * 2. the first stop leaves its status with a NULL thread, task is resumed or
+ *    its exit is reported once the event creates thread.
+ */
+struct xr_tracer_ptrace_task_s {
+  xr_hash_node_t node;
+  xr_thread_t *thread;
   int status;
-  struct rusage ru;
-  xr_tracer_ptrace_pending_clone_t *next;
+  // first stop of task has been seen
+  bool started;
+  // task is in a clone3 which is skipped, see xr_tracer_is_clone3.
+  bool skipped;
 };
 
 struct xr_tracer_ptrace_data_s;
 typedef struct xr_tracer_ptrace_data_s xr_tracer_ptrace_data_t;
 struct xr_tracer_ptrace_data_s {
-  xr_tracer_ptrace_pending_clone_t *pending;
+  // tasks keyed by tid, taken from task_pool
+  xr_hash_t tasks;
+  xr_pool_t task_pool;
+  // tasks in a skipped clone3, whose exit stops are swallowed.
+  int nskipped;
 };
 
 static inline void xr_tracer_ptrace_data_delete(xr_tracer_t *tracer,
                                                 xr_tracer_ptrace_data_t *data) {
-  xr_tracer_ptrace_pending_clone_t *pending;
-  while (data->pending) {
-    pending = data->pending;
-    data->pending = pending->next;
-    tracer->kill(tracer, pending->pid);
-    free(pending);
+  size_t i;
+  xr_hash_node_t *cur, *temp;
+  _xr_hash_for_each_safe(&data->tasks, i, cur, temp) {
+    xr_pool_free(&data->task_pool,
+                 xr_hash_entry(cur, xr_tracer_ptrace_task_t, node));
   }
+  xr_hash_clear(&data->tasks);
+  data->nskipped = 0;
 }
 
 static inline xr_tracer_ptrace_data_t *xr_tracer_ptrace_data(
@@ -68,6 +110,104 @@ static inline xr_tracer_ptrace_data_t *xr_tracer_ptrace_data(
   return (xr_tracer_ptrace_data_t *)tracer->tracer_data;
 }
 
+/**
+ * Find a traced task.
+ *
+ * @@tracer
+ * @tid tid of task
+ *
+ * @return NULL if task has not been seen yet.
+ */
+static inline xr_tracer_ptrace_task_t *xr_ptrace_tracer_find_task(
+  xr_tracer_t *tracer, pid_t tid) {
+  xr_hash_node_t *node = xr_hash_find(&xr_tracer_ptrace_data(tracer)->tasks,
+                                      tid);
+  return node ? xr_hash_entry(node, xr_tracer_ptrace_task_t, node) : NULL;
+}
+
+/**
+ * Index a new task by its tid.
+ *
+ * @@tracer
+ * @tid tid of task
+ * @thread thread of task, NULL if task stops before its clone event
+ * @status first stop of task, only meaningful if thread is NULL
+ *
+ * @return NULL if out of memory.
+ */
+static inline xr_tracer_ptrace_task_t *xr_ptrace_tracer_add_task(
+  xr_tracer_t *tracer, pid_t tid, xr_thread_t *thread, int status) {
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  xr_tracer_ptrace_task_t *task = xr_pool_alloc(&data->task_pool);
+  if (task == NULL) {
+    return NULL;
+  }
+  task->node.key = tid;
+  task->thread = thread;
+  task->status = status;
+  task->started = thread == NULL;
+  task->skipped = false;
+  if (xr_hash_insert(&data->tasks, &task->node) == false) {
+    xr_pool_free(&data->task_pool, task);
+    return NULL;
+  }
+  return task;
+}
+
+static inline void xr_ptrace_tracer_drop_task(xr_tracer_t *tracer, pid_t tid) {
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  xr_hash_node_t *node = xr_hash_remove(&data->tasks, tid);
+  if (node != NULL) {
+    xr_tracer_ptrace_task_t *task =
+      xr_hash_entry(node, xr_tracer_ptrace_task_t, node);
+    data->nskipped -= task->skipped;
+    xr_pool_free(&data->task_pool, task);
+  }
+}
+
+/**
+ * Skip clone3 on its entry stop and fail it with ENOSYS on its exit stop,
+ * see xr_tracer_is_clone3. Syscall number is gone on exit stop, hence task
+ * is marked on entry.
+ *
+ * @@tracer
+ * @thread thread stopped at syscall
+ * @syscall syscall number peeked
+ *
+ * @return whether stop is swallowed, errno is set if it fails.
+ */
+static inline bool xr_ptrace_tracer_skip_clone3(xr_tracer_t *tracer,
+                                                xr_thread_t *thread,
+                                                long syscall) {
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  xr_tracer_ptrace_task_t *task = NULL;
+  if (thread->syscall_status == XR_THREAD_CALLIN) {
+    if (xr_tracer_is_clone3(syscall) == false) {
+      return false;
+    } else if ((task = xr_ptrace_tracer_find_task(tracer, thread->tid)) ==
+               NULL) {
+      errno = ESRCH;
+      return false;
+    } else if (xr_ptrace_tracer_poke_scno(thread->tid, -1) == false) {
+      return false;
+    }
+    task->skipped = true;
+    data->nskipped++;
+  } else {
+    if (data->nskipped == 0 ||
+        (task = xr_ptrace_tracer_find_task(tracer, thread->tid)) == NULL ||
+        task->skipped == false) {
+      return false;
+    }
+    task->skipped = false;
+    data->nskipped--;
+    if (xr_ptrace_tracer_poke_retval(thread->tid, -ENOSYS) == false) {
+      return false;
+    }
+  }
+  return ptrace(PTRACE_SYSCALL, thread->tid, NULL, NULL) == 0;
+}
+
 void xr_tracer_ptrace_init(xr_tracer_t *tracer, const char *name) {
   xr_tracer_init(tracer, name);
   tracer->spwan = xr_ptrace_tracer_spawn;
@@ -79,23 +219,100 @@ void xr_tracer_ptrace_init(xr_tracer_t *tracer, const char *name) {
   tracer->kill = xr_ptrace_tracer_kill;
   tracer->_delete = xr_ptrace_tracer_delete;
   tracer->clean = xr_ptrace_tracer_clean;
-  tracer->tracer_data = _XR_NEW(xr_tracer_ptrace_data_t);
-  memset(tracer->tracer_data, 0, sizeof(xr_tracer_ptrace_data_t));
+  tracer->syscall_exit = true;
+  // orphaned tracees are reparented to tracer, then drain reaps them as well.
+  prctl(PR_SET_CHILD_SUBREAPER, 1);
+  xr_tracer_ptrace_data_t *data = _XR_NEW(xr_tracer_ptrace_data_t);
+  memset(data, 0, sizeof(xr_tracer_ptrace_data_t));
+  xr_hash_init(&data->tasks);
+  xr_pool_init(&data->task_pool, sizeof(xr_tracer_ptrace_task_t));
+  tracer->tracer_data = data;
+}
+
+/**
+ * Take a state change of a killed tracee. A killed tracee still stops at
+ * PTRACE_EVENT_EXIT, which is resumed here.
+ *
+ * @@tracer
+ * @info state change of tracee
+ */
+static inline void xr_ptrace_tracer_reaped(xr_tracer_t *tracer,
+                                           siginfo_t *info) {
+  if (info->si_code == CLD_TRAPPED || info->si_code == CLD_STOPPED) {
+    ptrace(PTRACE_CONT, info->si_pid, NULL, NULL);
+  } else {
+    xr_ptrace_tracer_drop_task(tracer, info->si_pid);
+  }
+}
+
+/**
+ * Reap tracees after they are killed. It blocks until group of run has no
+ * tracee left, then polls tracees which left the group one by one, as a
+ * leader is not reaped before its threads. Other children of tracer are never
+ * waited for.
+ *
+ * @@tracer
+ */
+static inline void xr_ptrace_tracer_drain(xr_tracer_t *tracer) {
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  siginfo_t info;
+  while (tracer->pgid > 0) {
+    if (waitid(P_PGID, tracer->pgid, &info,
+               WEXITED | WSTOPPED | XR_PTRACE_WAIT) == 0) {
+      xr_ptrace_tracer_reaped(tracer, &info);
+    } else if (errno != EINTR) {
+      break;
+    }
+  }
+  while (data->tasks.size != 0) {
+    size_t i, size = data->tasks.size;
+    xr_hash_node_t *cur, *temp;
+    _xr_hash_for_each_safe(&data->tasks, i, cur, temp) {
+      info.si_pid = 0;
+      if (waitid(P_PID, cur->key, &info,
+                 WEXITED | WSTOPPED | WNOHANG | XR_PTRACE_WAIT) == -1) {
+        // reaped already, or not a tracee any more.
+        if (errno != EINTR) {
+          xr_ptrace_tracer_drop_task(tracer, cur->key);
+        }
+      } else if (info.si_pid != 0) {
+        xr_ptrace_tracer_reaped(tracer, &info);
+      }
+    }
+    if (data->tasks.size == size) {
+      nanosleep(&(struct timespec){.tv_nsec = XR_PTRACE_DRAIN_INTERVAL}, NULL);
+    }
+  }
+  errno = 0;
 }
 
 void xr_ptrace_tracer_clean(xr_tracer_t *tracer) {
-  xr_tracer_ptrace_data_delete(tracer, xr_tracer_ptrace_data(tracer));
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  // processes have been killed with their threads, only tasks which never
+  // got a thread are still alive here.
+  size_t i;
+  xr_hash_node_t *cur, *temp;
+  _xr_hash_for_each_safe(&data->tasks, i, cur, temp) {
+    if (xr_hash_entry(cur, xr_tracer_ptrace_task_t, node)->thread == NULL) {
+      tracer->kill(tracer, cur->key);
+    }
+  }
+  xr_ptrace_tracer_drain(tracer);
+  xr_tracer_ptrace_data_delete(tracer, data);
 }
 
 void xr_ptrace_tracer_delete(xr_tracer_t *tracer) {
   xr_ptrace_tracer_clean(tracer);
+  xr_hash_delete(&xr_tracer_ptrace_data(tracer)->tasks);
+  xr_pool_delete(&xr_tracer_ptrace_data(tracer)->task_pool);
   free(tracer->tracer_data);
 }
 
 static inline bool xr_ptrace_tracer_setopt(int pid) {
   return ptrace(PTRACE_SETOPTIONS, pid, NULL,
                 PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE |
-                  PTRACE_O_TRACEVFORK | PTRACE_O_TRACEFORK) == 0;
+                  PTRACE_O_TRACEVFORK | PTRACE_O_TRACEFORK |
+                  PTRACE_O_TRACEEXIT | PTRACE_O_EXITKILL) == 0;
 }
 
 // we try to set close on exec for any other file description
@@ -117,6 +334,15 @@ static inline void do_exec(xr_tracer_t *tracer, xr_entry_t *entry) {
     _XR_TRACER_ERROR(tracer, "prctl PR_SET_PDEATHSIG failed.");
     return;
   }
+  if (setpgid(0, 0) == -1) {
+    _XR_TRACER_ERROR(tracer, "setpgid of tracee failed.");
+    return;
+  }
+  if (tracer->sandbox != NULL &&
+      xr_sandbox_enter(tracer->sandbox) == false) {
+    _XR_TRACER_ERROR(tracer, "enter sandbox failed.");
+    return;
+  }
   for (int i = 0; i < 3; ++i) {
     if (dup2(i, entry->stdio[i]) == -1) {
       _XR_TRACER_ERROR(tracer, "dup file %d error.", i);
@@ -124,6 +350,13 @@ static inline void do_exec(xr_tracer_t *tracer, xr_entry_t *entry) {
     }
   }
   xr_ptrace_try_cloexec();
+  if (tracer->option->landlock && xr_landlock_abi() > 0 &&
+      xr_landlock_restrict(tracer->option,
+                           tracer->workspace ? &tracer->workspace->path : NULL,
+                           &entry->root) == false) {
+    _XR_TRACER_ERROR(tracer, "landlock restrict error.");
+    return;
+  }
   xr_entry_execve(entry);
   _XR_TRACER_ERROR(tracer, "execvpe error.");
 }
@@ -163,26 +396,145 @@ static inline bool do_rlimit_setup(xr_option_t *option) {
          rlimit_nproc(option->nprocess);
 }
 
-static bool get_resource_info(xr_trace_trap_t *trap, struct rusage *ru) {
-  trap->thread->process->time =
-    xr_time_from_timeval(ru->ru_stime, ru->ru_utime);
-  trap->thread->process->memory = ru->ru_maxrss;
-  return true;
+/**
+ * Whether a child waited for is a tracee of this thread. A task which has
+ * not been indexed yet, e.g. a new thread before its clone event or one
+ * killed before its first stop, is asked for its tracer.
+ *
+ * @@tracer
+ * @pid pid of child
+ */
+static inline bool xr_ptrace_tracer_traces(xr_tracer_t *tracer, pid_t pid) {
+  pid_t tracer_tid = 0;
+  return xr_ptrace_tracer_find_task(tracer, pid) != NULL ||
+         (xr_proc_tracer(pid, &tracer_tid) &&
+          tracer_tid == syscall(__NR_gettid));
+}
+
+/**
+ * Reap an exited tracee with its rusage. A zombie leader is reported after
+ * all of its threads, its cpu clock is final and is read first, since rusage
+ * has children it waited for as well.
+ *
+ * @@tracer
+ * @pid pid of tracee
+ * @status status of exit, in the same encoding as wait3
+ * @usage rusage of tracee
+ *
+ * @return pid of tracee, or -1 on error.
+ */
+static inline pid_t xr_ptrace_tracer_reap(xr_tracer_t *tracer, pid_t pid,
+                                          int *status, struct rusage *usage) {
+  xr_tracer_ptrace_task_t *task = xr_ptrace_tracer_find_task(tracer, pid);
+  if (task != NULL && task->thread != NULL &&
+      task->thread->process->pid == pid) {
+    xr_proc_cpu_ns(pid, &task->thread->process->cpu_ns);
+  }
+  return wait4(pid, status, XR_PTRACE_WAIT, usage);
+}
+
+/**
+ * Take the next stop of an indexed task, while a child which is not a
+ * tracee has changed state and hides tracees from a wait for any child. If
+ * none of them has stopped, it sleeps for XR_PTRACE_DRAIN_INTERVAL and fails
+ * with EINTR, so that caller waits again.
+ *
+ * @@tracer
+ * @status status of stop, in the same encoding as wait3
+ * @usage rusage of an exited tracee, untouched for other stops
+ *
+ * @return pid of stopped tracee, or -1 on error.
+ */
+static inline pid_t xr_ptrace_tracer_poll(xr_tracer_t *tracer, int *status,
+                                          struct rusage *usage) {
+  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
+  siginfo_t info;
+  size_t i;
+  xr_hash_node_t *cur, *temp;
+  _xr_hash_for_each_safe(&data->tasks, i, cur, temp) {
+    info.si_pid = 0;
+    if (waitid(P_PID, cur->key, &info,
+               WEXITED | WSTOPPED | WNOHANG | WNOWAIT | XR_PTRACE_WAIT) ==
+          -1 ||
+        info.si_pid == 0) {
+      continue;
+    } else if (info.si_code == CLD_TRAPPED || info.si_code == CLD_STOPPED) {
+      info.si_pid = 0;
+      if (waitid(P_PID, cur->key, &info,
+                 WSTOPPED | WNOHANG | XR_PTRACE_WAIT) == -1 ||
+          info.si_pid == 0) {
+        continue;
+      }
+      *status = (info.si_status << 8) | 0x7f;
+      return info.si_pid;
+    }
+    return xr_ptrace_tracer_reap(tracer, cur->key, status, usage);
+  }
+  nanosleep(&(struct timespec){.tv_nsec = XR_PTRACE_DRAIN_INTERVAL}, NULL);
+  errno = EINTR;
+  return -1;
+}
+
+/**
+ * Wait for next stop of any tracee. Unlike wait3, waitid does not make
+ * kernel sum up rusage of all threads of a stopped tracee, which costs
+ * more than the wait itself for a large thread group. The stop is peeked
+ * first, only an exit is reaped with rusage, which is the final usage of
+ * the thread group and finer than what /proc reports. A child which is not
+ * a tracee is left to its owner, see xr_ptrace_tracer_poll.
+ *
+ * @@tracer
+ * @status status of stop, in the same encoding as wait3
+ * @usage rusage of an exited tracee, untouched for other stops
+ *
+ * @return pid of stopped tracee, or -1 on error.
+ */
+static inline pid_t xr_ptrace_tracer_wait(xr_tracer_t *tracer, int *status,
+                                          struct rusage *usage) {
+  siginfo_t info;
+  for (;;) {
+    info.si_pid = 0;
+    if (waitid(P_ALL, 0, &info,
+               WEXITED | WSTOPPED | WNOWAIT | XR_PTRACE_WAIT) == -1) {
+      return -1;
+    }
+    pid_t pid = info.si_pid;
+    if (xr_ptrace_tracer_traces(tracer, pid) == false) {
+      return xr_ptrace_tracer_poll(tracer, status, usage);
+    }
+    switch (info.si_code) {
+      case CLD_EXITED:
+      case CLD_KILLED:
+      case CLD_DUMPED:
+        return xr_ptrace_tracer_reap(tracer, pid, status, usage);
+      default:
+        break;
+    }
+    // a tracee killed after the peek has no stop left, its exit is peeked
+    // then.
+    info.si_pid = 0;
+    if (waitid(P_PID, pid, &info, WSTOPPED | WNOHANG | XR_PTRACE_WAIT) == -1) {
+      return -1;
+    } else if (info.si_pid != 0) {
+      // si_status of a ptrace stop keeps event in its high bits.
+      *status = (info.si_status << 8) | 0x7f;
+      return info.si_pid;
+    }
+  }
 }
 
 static xr_thread_t *create_spawned_process(xr_tracer_t *tracer, pid_t child,
                                            xr_path_t *pwd) {
-  xr_process_t *process = _XR_NEW(xr_process_t);
-  xr_thread_t *thread = _XR_NEW(xr_thread_t);
+  xr_process_t *process = xr_tracer_new_process(tracer);
+  xr_thread_t *thread = xr_tracer_new_thread(tracer);
+  // objects from pools are dirty.
+  xr_process_init(process);
   process->pid = child;
-  process->nthread = 0;
-  process->compat = XR_COMPAT_SYSCALL_INVALID;
-
-  xr_list_init(&(process->threads));
   xr_list_add(&(tracer->processes), &(process->processes));
   tracer->nprocess++;
   tracer->nthread++;
 
+  xr_thread_init(thread);
   thread->tid = child;
   thread->syscall_status = XR_THREAD_CALLOUT;
   // Current state should be XR_THREAD_CALLIN, Since child process will be
@@ -194,6 +546,13 @@ static xr_thread_t *create_spawned_process(xr_tracer_t *tracer, pid_t child,
   xr_string_copy(xr_fs_pwd(&thread->fs), pwd);
 
   xr_process_add_thread(process, thread);
+  xr_tracer_ptrace_task_t *task =
+    xr_ptrace_tracer_add_task(tracer, child, thread, 0);
+  if (task == NULL) {
+    return NULL;
+  }
+  // first stop of spawned task is taken by spawn.
+  task->started = true;
   return thread;
 }
 
@@ -264,6 +623,8 @@ bool xr_ptrace_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry) {
   if (WIFEXITED(status)) {
     return _XR_TRACER_ERROR(tracer, "waiting first child %d failed.", fork_ret);
   }
+  // child has joined its own group before stopping at execve.
+  xr_tracer_own_group(tracer, entry, fork_ret);
 
   // set options here
   if (xr_ptrace_tracer_setopt(fork_ret) == false) {
@@ -296,20 +657,6 @@ bool xr_ptrace_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry) {
 #define XR_CLONE_UNUSED_ARG 5
 #define XR_CLONE2_UNUSED_ARG 1
 
-#ifndef XR_SYSCALL_CLONE
-#define XR_SYSCALL_CLONE -1
-#endif
-#ifndef XR_SYSCALL_FORK
-#define XR_SYSCALL_FORK -1
-#endif
-#ifndef XR_SYSCALL_VFORK
-#define XR_SYSCALL_VFORK -1
-#endif
-
-#define XR_IS_CLONE(syscall)                                        \
-  ((syscall) == XR_SYSCALL_CLONE || (syscall) == XR_SYSCALL_FORK || \
-   (syscall) == XR_SYSCALL_VFORK)
-
 bool xr_ptrace_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
   return ptrace(PTRACE_SYSCALL, trap->thread->tid, NULL, NULL) == 0;
 }
@@ -320,113 +667,113 @@ bool xr_ptrace_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
     (thread)->syscall_status ^= 1;           \
   } while (0)
 
-static inline xr_thread_t *xr_tracer_select_thread(xr_tracer_t *tracer,
-                                                   pid_t pid) {
-  // trap stopped thread
-  xr_thread_t *thread;
-  xr_process_t *process;
-  _xr_list_for_each_entry(&(tracer->processes), process, xr_process_t,
-                          processes) {
-    _xr_list_for_each_entry(&(process->threads), thread, xr_thread_t, threads) {
-      if (thread->tid == pid) {
-        return thread;
-      }
-    }
-  }
-  return NULL;
-}
-
-static inline xr_thread_t *xr_ptrace_tracer_recover_thread(xr_tracer_t *tracer,
-                                                           pid_t pid,
-                                                           int *status,
-                                                           struct rusage *ru) {
-  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
-  xr_tracer_ptrace_pending_clone_t *pending = data->pending, *prev = NULL;
-  while (pending) {
-    if (pending->pid == pid) {
-      *status = pending->status;
-      *ru = pending->ru;
-      xr_thread_t *thread = _XR_NEW(xr_thread_t);
-      xr_thread_init(thread);
-      thread->tid = pid;
-      if (prev) {
-        prev->next = pending->next;
-      } else {
-        data->pending = pending->next;
-      }
-      free(pending);
-      return thread;
-    }
-  }
-  return NULL;
-}
-
-static inline bool xr_ptrace_tracer_hang_thread(xr_tracer_t *tracer, pid_t pid,
-                                                int status, struct rusage *ru) {
-  xr_tracer_ptrace_data_t *data = xr_tracer_ptrace_data(tracer);
-  xr_tracer_ptrace_pending_clone_t *pending =
-    _XR_NEW(xr_tracer_ptrace_pending_clone_t);
-  pending->pid = pid;
-  pending->status = status;
-  pending->ru = *ru;
-  pending->next = data->pending;
-  data->pending = pending;
-  return true;
-}
-
 #define XR_WIFEVENT(status) \
   (WIFSTOPPED(status) && (status >> 8 & 0xff) == SIGTRAP)
 
 #define XR_WEVENT(status) (XR_WIFEVENT(status) ? ((status) >> 16) : 0)
 
-#ifdef XR_PTRACESYSGOOD_ENABLE
+// syscall stops come with SIGTRAP | 0x80, since PTRACE_O_TRACESYSGOOD is
+// always set by xr_ptrace_tracer_setopt.
 #define XR_WIFTRACED(status) \
   (WIFSTOPPED(status) && WSTOPSIG(status) == (SIGTRAP | 0x80))
-#else
-#define XR_WIFTRACED(status) (WIFSTOPPED(status) && WSTOPSIG(status) == SIGTRAP)
-#endif
 
-#define CLONE_FLAG_ARGS(syscall) 1
-#ifndef CLONE_UNTRACED
-#define CLONE_UNTRACED 0x00800000
-#endif
+// a cloned task reports SIGSTOP as its first stop instead of a clone exit
+// stop, which is swallowed since task is created on clone event.
+#define XR_WIFSTARTED(status) \
+  (WIFSTOPPED(status) && WSTOPSIG(status) == SIGSTOP)
+
+/**
+ * Create thread of a new task on clone event of its parent, and a process
+ * for it unless it is cloned with CLONE_THREAD.
+ *
+ * @@tracer
+ * @from thread calling clone, fork or vfork
+ * @tid tid of new task
+ * @event kind of clone event, which guesses flags not taken on entry
+ */
+static xr_thread_t *xr_ptrace_tracer_attach(xr_tracer_t *tracer,
+                                            xr_thread_t *from, pid_t tid,
+                                            int event) {
+  unsigned long flags = from->clone_flags;
+  if (flags == XR_THREAD_CLONE_UNKNOWN) {
+    flags = event == PTRACE_EVENT_CLONE ? XR_PTRACE_CLONE_THREAD : SIGCHLD;
+  }
+  from->clone_flags = XR_THREAD_CLONE_UNKNOWN;
+  xr_process_t *process = from->process;
+  if ((flags & CLONE_THREAD) == 0) {
+    process = xr_tracer_new_process(tracer);
+    xr_process_init(process);
+    process->pid = tid;
+    xr_list_add(&tracer->processes, &process->processes);
+    tracer->nprocess++;
+  }
+  xr_thread_t *thread = xr_tracer_new_thread(tracer);
+  xr_thread_init(thread);
+  thread->tid = tid;
+  thread->clone_flags = XR_THREAD_CLONE_UNKNOWN;
+  // new task starts by returning from clone.
+  thread->syscall_status = XR_THREAD_CALLOUT;
+  xr_thread_inherit(thread, from, (flags & CLONE_FILES) != 0,
+                    (flags & CLONE_FS) != 0);
+  xr_process_add_thread(process, thread);
+  tracer->nthread++;
+  return thread;
+}
 
 bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
-  struct rusage ru;
   int status;
-  pid_t pid = 0;
-  bool recovered = false;
+  struct rusage usage;
+  pid_t pid = 0, reaped = 0;
   trap->thread = NULL;
   while (trap->thread == NULL || XR_WIFEVENT(status)) {
-    pid = wait3(&status, __WALL, &ru);
-    if (pid == -1) {
+    if (xr_tracer_perf_trap(tracer, trap)) {
+      return true;
+    }
+    XR_STATS_BEGIN(tracer->stats, wait_start);
+    pid = xr_ptrace_tracer_wait(tracer, &status, &usage);
+    if (pid == -1 && errno == EINTR) {
+      continue;
+    } else if (pid == -1) {
       return _XR_TRACER_ERROR(tracer, "waiting child failed.");
     }
+    reaped = WIFEXITED(status) || WIFSIGNALED(status) ? pid : 0;
+    XR_STATS_END(tracer->stats, phases[XR_STATS_WAIT], wait_start);
 
     /**
-     * there is two case of a new cloned thread.
+     * there is two case of a new cloned thread, see xr_tracer_ptrace_task_t.
      * 1. ptrace_event is faster than new thread clone return.
-     *    in this case, thread struct will create before clone return.
-     *    and trap->thread is not null.
+     *    in this case, thread struct is created by the event and indexed
+     *    before clone return, the first stop is swallowed.
      * 2. ptrace_event is slower than new thread clone return.
-     *    in this case, trap->thread will be null. we put pid into a
-     *    pending list and hang on this thread until the event.
+     *    in this case, task is not found. we index it without thread and
+     *    hang on this thread until the event.
      */
-    trap->thread = xr_tracer_select_thread(tracer, pid);
+    xr_tracer_ptrace_task_t *task = xr_ptrace_tracer_find_task(tracer, pid);
+    trap->thread = task != NULL ? task->thread : NULL;
 
-    if (trap->thread == NULL) {
+    if (task == NULL) {
       /* case 2 happened */
-      /* hanging thread until a ptrace event */
-      if (xr_ptrace_tracer_hang_thread(tracer, pid, status, &ru) == false) {
+      /* hanging thread until a ptrace event, options of new thread are
+       * inherited from its parent. */
+      if (xr_ptrace_tracer_add_task(tracer, pid, NULL, status) == NULL) {
         return _XR_TRACER_ERROR(tracer, "tracer hang new thread %d failed.",
                                 pid);
       }
-      /* set ptrace option again */
-      if (xr_ptrace_tracer_setopt(pid) == false) {
-        return _XR_TRACER_ERROR(
-          tracer, "tracer set options for new thread %d failed.", pid);
-      }
       /* new thread hanged */
+    } else if (trap->thread == NULL) {
+      /* a hanged thread is killed before the event, keep its exit */
+      task->status = status;
+    } else if (task->started == false) {
+      task->started = true;
+      if (XR_WIFSTARTED(status)) {
+        /* case 1 happened */
+        /* new thread has been created by the event, just let it go */
+        if (ptrace(PTRACE_SYSCALL, pid, NULL, NULL) != 0) {
+          return _XR_TRACER_ERROR(tracer, "continue new thread %d failed.",
+                                  pid);
+        }
+        trap->thread = NULL;
+      }
     } else if (XR_WIFEVENT(status)) {
       /* ptrace event */
       pid_t evented_pid = pid;
@@ -441,29 +788,44 @@ bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
               tracer, "tracer retrieve event pid of thread %d failed.", pid);
           }
           pid = pid_;
-          /* try recover hanged new thread */
-          xr_thread_t *cloned_thread =
-            xr_ptrace_tracer_recover_thread(tracer, pid, &status, &ru);
-          if (cloned_thread != NULL) {
+          /* create new thread by flags taken on entry of clone */
+          xr_thread_t *thread = xr_ptrace_tracer_attach(
+            tracer, trap->thread, pid, XR_WEVENT(status));
+          xr_tracer_ptrace_task_t *cloned = xr_ptrace_tracer_find_task(tracer,
+                                                                       pid);
+          trap->thread = NULL;
+          if (cloned != NULL && cloned->thread == NULL) {
             /* case 2 happened */
-            /* now select event thread */
-            xr_process_add_thread(trap->thread->process, cloned_thread);
-            cloned_thread->from = trap->thread;
-            trap->thread = cloned_thread;
-          } else {
+            /* recover hanged thread, report it only if it has exited */
+            cloned->thread = thread;
+            if (WIFSTOPPED(cloned->status) == false) {
+              status = cloned->status;
+              trap->thread = thread;
+            } else if (ptrace(PTRACE_SYSCALL, pid, NULL, NULL) != 0) {
+              return _XR_TRACER_ERROR(tracer, "continue new thread %d failed.",
+                                      pid);
+            }
+          } else if (cloned != NULL) {
+            /* case 1 happened */
+            /* a task left by a thread with the same tid is stale. */
+            cloned->thread = thread;
+            cloned->started = false;
+          } else if (xr_ptrace_tracer_add_task(tracer, pid, thread, 0) ==
+                     NULL) {
             /* case 1 happened */
-            /* create new thread which will be traped. */
-            xr_thread_t *thread = _XR_NEW(xr_thread_t);
-            xr_thread_init(thread);
-            thread->tid = pid;
-            thread->from = trap->thread;
-            /* add to new thread to evented process */
-            xr_process_add_thread(trap->thread->process, thread);
-            /* mark trap->thread as null to skip recover */
-            trap->thread = NULL;
+            return _XR_TRACER_ERROR(
+              tracer, "tracer index new thread %d failed.", pid);
           }
-          recovered = true;
+          break;
         }
+        case PTRACE_EVENT_EXIT:
+          // sched of tracee is gone once it exits, read it when the last
+          // thread is leaving, time and memory come with its exit.
+          if (trap->thread->threads.next == trap->thread->threads.prev) {
+            xr_proc_nmigration(trap->thread->process->pid,
+                               &trap->thread->process->nmigration);
+          }
+          break;
         default:
           /* ignore other event and continue */
           break;
@@ -476,12 +838,22 @@ bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
     }
   }
 
+  if (reaped != 0 && trap->thread->tid == reaped &&
+      trap->thread->process != NULL) {
+    // a recovered thread has exited earlier, its usage is not at hand.
+    trap->thread->process->time =
+      xr_time_from_timeval(usage.ru_stime, usage.ru_utime);
+    trap->thread->process->memory = usage.ru_maxrss;
+  }
+
   if (WIFEXITED(status)) {
     trap->trap = XR_TRACE_TRAP_EXIT;
     trap->exit_code = WEXITSTATUS(status);
+    xr_ptrace_tracer_drop_task(tracer, trap->thread->tid);
   } else if (WIFSIGNALED(status)) {
     trap->trap = XR_TRACE_TRAP_SIGEXIT;
     trap->stop_signal = WTERMSIG(status);
+    xr_ptrace_tracer_drop_task(tracer, trap->thread->tid);
   } else if (XR_WIFTRACED(status)) {
     trap->trap = XR_TRACE_TRAP_SYSCALL;
     __flip_thread_syscall_status(trap->thread);
@@ -493,12 +865,23 @@ bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
       }
     }
 
+    XR_STATS_BEGIN(tracer->stats, peek_start);
     if (xr_ptrace_tracer_peek_syscall(pid, &trap->syscall_info,
                                       trap->thread->process->compat) == false) {
       return _XR_TRACER_ERROR(
         tracer, "getting system call infomation of process %d failed.",
         trap->thread->process->pid);
     }
+    XR_STATS_END(tracer->stats, phases[XR_STATS_PEEK], peek_start);
+
+    errno = 0;
+    if (xr_ptrace_tracer_skip_clone3(tracer, trap->thread,
+                                     trap->syscall_info.syscall)) {
+      return xr_ptrace_tracer_trap(tracer, trap);
+    } else if (errno != 0) {
+      return _XR_TRACER_ERROR(tracer, "failing clone3 of thread %d failed.",
+                              pid);
+    }
 
     if ((trap->syscall_info.syscall == XR_SYSCALL_EXECVE ||
          trap->syscall_info.syscall == XR_SYSCALL_EXECVEAT) &&
@@ -506,11 +889,8 @@ bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
       // we will detect syscall compat mode in next syscall
       trap->thread->process->compat = XR_COMPAT_SYSCALL_INVALID;
     }
-    if (trap->syscall_info.syscall == -1 && recovered) {
-      trap->syscall_info.syscall = trap->thread->from->to_call;
-    } else if (XR_IS_CLONE(trap->syscall_info.syscall) &&
-               trap->thread->syscall_status == XR_THREAD_CALLIN) {
-      trap->thread->to_call = trap->syscall_info.syscall;
+    if (trap->thread->syscall_status == XR_THREAD_CALLIN) {
+      xr_tracer_take_clone_flags(tracer, trap);
     }
   } else if (WIFSTOPPED(status)) {
     trap->trap = XR_TRACE_TRAP_SIGNAL;
@@ -518,16 +898,11 @@ bool xr_ptrace_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
   }
 
   if (trap->thread->process == NULL) {
-    free(trap->thread);
+    xr_ptrace_tracer_drop_task(tracer, trap->thread->tid);
+    xr_tracer_free_thread(tracer, trap->thread);
     return _XR_TRACER_ERROR(tracer, "untraced process/thread %d occured.", pid);
   }
 
-  if (get_resource_info(trap, &ru) == false) {
-    return _XR_TRACER_ERROR(
-      tracer, "getting resource information of process %d failed.",
-      trap->thread->process->pid);
-  }
-
   return true;
 }
 
@@ -535,13 +910,23 @@ const static unsigned long __xr_address_align = -sizeof(long);
 
 bool xr_ptrace_tracer_get(xr_tracer_t *tracer, int pid, void *address,
                           void *buffer, size_t size) {
+  XR_STATS_BEGIN(tracer->stats, start);
+  // read in bulk, peek word by word only if tracee memory can not be read in
+  // this way, e.g. on a kernel without process_vm_readv.
+  struct iovec local = {.iov_base = buffer, .iov_len = size};
+  struct iovec remote = {.iov_base = address, .iov_len = size};
+  if (process_vm_readv(pid, &local, 1, &remote, 1, 0) == size) {
+    XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
+    return true;
+  }
   // aligned address in kernel
   long addr = (long)address & __xr_address_align;
   // offset of needed data
-  size_t offset = addr - (long)address;
+  size_t offset = (long)address - addr;
   long data_ = 0;
   void *data = (void *)&data_;
-  while (true) {
+  while (size > 0) {
+    errno = 0;
     data_ = ptrace(PTRACE_PEEKDATA, pid, addr, NULL);
     if (errno) {
       return _XR_TRACER_ERROR(
@@ -550,10 +935,11 @@ bool xr_ptrace_tracer_get(xr_tracer_t *tracer, int pid, void *address,
     size_t need = XR_MIN(sizeof(long) - offset, size);
     memcpy(buffer, data + offset, need);
     addr += sizeof(long);
-    buffer += sizeof(long);
+    buffer += need;
     size -= need;
     offset = 0;
   }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
   return true;
 }
 
@@ -562,25 +948,37 @@ bool xr_ptrace_tracer_set(xr_tracer_t *tracer, int pid, void *address,
   // aligned address in kernel
   long addr = (long)address & __xr_address_align;
   // offset of needed data
-  size_t offset = addr - (long)address;
+  size_t offset = (long)address - addr;
   // rest part of data
   size_t rest = size;
   long data_ = 0;
   void *data = (void *)&data_;
-  while (true) {
+  XR_STATS_BEGIN(tracer->stats, start);
+  while (rest > 0) {
     size_t need = XR_MIN(sizeof(long) - offset, rest);
     if (need < sizeof(long)) {
+      // keep bytes around data in a partial word
+      errno = 0;
       data_ = ptrace(PTRACE_PEEKDATA, pid, addr, NULL);
+      if (errno) {
+        return _XR_TRACER_ERROR(
+          tracer, "ptrace_tracer peeking child %d data at %p failed.", pid,
+          addr);
+      }
     }
     memcpy((void *)(data + offset), buffer, need);
 
-    ptrace(PTRACE_POKEDATA, pid, addr, NULL);
+    if (ptrace(PTRACE_POKEDATA, pid, addr, data_) == -1) {
+      return _XR_TRACER_ERROR(
+        tracer, "ptrace_tracer poking child %d data at %p failed.", pid, addr);
+    }
 
     addr += sizeof(long);
-    buffer += sizeof(long);
+    buffer += need;
     rest -= need;
     offset = 0;
   }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
   return true;
 }
 
@@ -593,7 +991,9 @@ bool xr_ptrace_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
   size_t offset = (long)address - addr;
   long data_ = 0;
   char *data = (char *)&data_;
+  XR_STATS_BEGIN(tracer->stats, start);
   while (true) {
+    errno = 0;
     data_ = ptrace(PTRACE_PEEKDATA, pid, addr, NULL);
     if (errno) {
       return _XR_TRACER_ERROR(
@@ -607,6 +1007,7 @@ bool xr_ptrace_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
     xr_string_concat_raw(str, data + offset, need);
 
     if (term != NULL) {
+      XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
       return true;
     }
 
@@ -620,5 +1021,6 @@ bool xr_ptrace_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
 }
 
 void xr_ptrace_tracer_kill(xr_tracer_t *tracer, pid_t pid) {
-  ptrace(PTRACE_KILL, pid, 0, 0);
+  // PTRACE_KILL only works on a stopped tracee, SIGKILL wakes it anyway.
+  kill(pid, SIGKILL);
 }
@@ -73,13 +73,14 @@ bool xr_ptrace_tracer_peek_syscall(int pid,
   if (ptrace(PTRACE_GETREGS, pid, NULL, &regs) == -1) {
     return false;
   }
-  syscall_info->syscall = regs.orig_rax;
+  syscall_info->syscall = syscall_info->nr = regs.orig_rax;
   syscall_info->retval = regs.rax;
 
   switch (compat) {
       // fallback to x64
     case XR_COMPAT_SYSCALL_X86_X32:
-      syscall_info->syscall = xr_syscall_x64_from_x32(syscall_info->syscall);
+      syscall_info->syscall = syscall_info->nr =
+        xr_syscall_x64_from_x32(syscall_info->syscall);
       // x32 is similar to x64, with some difference at call number.
       // fallback to x64
     case XR_COMPAT_SYSCALL_X86_64:
@@ -122,6 +123,14 @@ bool xr_ptrace_tracer_poke_syscall(int pid, long arg, int index, int compat) {
   return ptrace(PTRACE_POKEUSER, pid, offset * 8, 0) != -1;
 }
 
+bool xr_ptrace_tracer_poke_scno(int pid, long scno) {
+  return ptrace(PTRACE_POKEUSER, pid, ORIG_RAX * 8, scno) != -1;
+}
+
+bool xr_ptrace_tracer_poke_retval(int pid, long retval) {
+  return ptrace(PTRACE_POKEUSER, pid, RAX * 8, retval) != -1;
+}
+
 int xr_ptrace_tracer_elf_compat(xr_path_t *elf) {
   e_ident_t eident;
   int elffd = open(elf->string, O_RDONLY);
@@ -154,7 +163,7 @@ bool xr_ptrace_tracer_peek_syscall(int pid,
   if (ptrace(PTRACE_GETREGS, pid, NULL, &regs) == -1) {
     return false;
   }
-  syscall_info->syscall = regs.orig_eax;
+  syscall_info->syscall = syscall_info->nr = regs.orig_eax;
   syscall_info->retval = regs.eax;
   syscall_info->args[0] = regs.ebx;
   syscall_info->args[1] = regs.ecx;
@@ -177,6 +186,14 @@ bool xr_ptrace_tracer_poke_syscall(int pid, long arg, int index, int compat) {
   return ptrace(PTRACE_POKEUSER, pid, arg_index[index] * 4, 0) != -1;
 }
 
+bool xr_ptrace_tracer_poke_scno(int pid, long scno) {
+  return ptrace(PTRACE_POKEUSER, pid, ORIG_EAX * 4, scno) != -1;
+}
+
+bool xr_ptrace_tracer_poke_retval(int pid, long retval) {
+  return ptrace(PTRACE_POKEUSER, pid, EAX * 4, retval) != -1;
+}
+
 #endif /* XR_ARCH_X86_64 */
 
 #endif
@@ -0,0 +1,488 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xrun/capture.h"
+#include "xrun/entry.h"
+#include "xrun/process.h"
+#include "xrun/tracer.h"
+#include "xrun/tracers/replay/tracer.h"
+#include "xrun/utils/hash.h"
+#include "xrun/utils/pool.h"
+#include "xrun/utils/utils.h"
+
+struct xr_tracer_replay_task_s;
+typedef struct xr_tracer_replay_task_s xr_tracer_replay_task_t;
+// a replayed task indexed by its captured tid.
+struct xr_tracer_replay_task_s {
+  xr_hash_node_t node;
+  xr_thread_t *thread;
+};
+
+struct xr_tracer_replay_run_s;
+typedef struct xr_tracer_replay_run_s xr_tracer_replay_run_t;
+struct xr_tracer_replay_run_s {
+  // offset of the record after XR_CAPTURE_BEGIN
+  size_t begin;
+  xr_tracer_code_t status;
+};
+
+struct xr_tracer_replay_data_s;
+typedef struct xr_tracer_replay_data_s xr_tracer_replay_data_t;
+struct xr_tracer_replay_data_s {
+  // whole capture, loaded once
+  char *buffer;
+  size_t size;
+  xr_tracer_replay_run_t *runs;
+  int nrun;
+  // run replayed now, -1 before the first one, and offset of its next record
+  int run;
+  size_t offset;
+  // XR_CAPTURE_MEMORY records following trap replayed now, and the one
+  // after the record read last.
+  size_t memory_begin, memory_end, memory;
+  // tasks keyed by tid, taken from task_pool
+  xr_hash_t tasks;
+  xr_pool_t task_pool;
+};
+
+static inline xr_tracer_replay_data_t *xr_tracer_replay_data(
+  xr_tracer_t *tracer) {
+  return (xr_tracer_replay_data_t *)tracer->tracer_data;
+}
+
+/**
+ * Read the record at offset of capture.
+ *
+ * @@data
+ * @offset offset of record, which is moved to the next one
+ * @record output header of record
+ * @payload output payload of record
+ *
+ * @return false at the end of capture, or if record is truncated.
+ */
+static inline bool xr_replay_tracer_record(xr_tracer_replay_data_t *data,
+                                           size_t *offset,
+                                           xr_capture_record_t *record,
+                                           const char **payload) {
+  if (data->size - *offset < sizeof(xr_capture_record_t)) {
+    return false;
+  }
+  memcpy(record, data->buffer + *offset, sizeof(xr_capture_record_t));
+  if (data->size - *offset - sizeof(xr_capture_record_t) < record->size) {
+    return false;
+  }
+  *payload = data->buffer + *offset + sizeof(xr_capture_record_t);
+  *offset += sizeof(xr_capture_record_t) + record->size;
+  return true;
+}
+
+static inline bool xr_replay_tracer_peek(xr_tracer_replay_data_t *data,
+                                         xr_capture_kind_t kind) {
+  size_t offset = data->offset;
+  xr_capture_record_t record;
+  const char *payload;
+  return xr_replay_tracer_record(data, &offset, &record, &payload) &&
+         record.kind == kind;
+}
+
+static inline xr_thread_t *xr_replay_tracer_find(xr_tracer_t *tracer,
+                                                 pid_t tid) {
+  xr_hash_node_t *node = xr_hash_find(&xr_tracer_replay_data(tracer)->tasks,
+                                      tid);
+  return node ? xr_hash_entry(node, xr_tracer_replay_task_t, node)->thread
+              : NULL;
+}
+
+static inline void xr_replay_tracer_drop(xr_tracer_t *tracer, pid_t tid) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  xr_hash_node_t *node = xr_hash_remove(&data->tasks, tid);
+  if (node != NULL) {
+    xr_pool_free(&data->task_pool,
+                 xr_hash_entry(node, xr_tracer_replay_task_t, node));
+  }
+}
+
+static inline xr_process_t *xr_replay_tracer_process(xr_tracer_t *tracer,
+                                                     xr_thread_t *from,
+                                                     pid_t pid) {
+  if (from != NULL && from->process->pid == pid) {
+    return from->process;
+  }
+  xr_process_t *process;
+  _xr_list_for_each_entry(&tracer->processes, process, xr_process_t,
+                          processes) {
+    if (process->pid == pid) {
+      return process;
+    }
+  }
+  process = xr_tracer_new_process(tracer);
+  xr_process_init(process);
+  process->pid = pid;
+  xr_list_add(&tracer->processes, &process->processes);
+  tracer->nprocess++;
+  return process;
+}
+
+/**
+ * Create thread of a captured task, from its parent if it has one.
+ *
+ * @@tracer
+ * @payload payload of XR_CAPTURE_TASK
+ * @size size of payload
+ */
+static bool xr_replay_tracer_task(xr_tracer_t *tracer, const char *payload,
+                                  size_t size) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  xr_capture_task_t task;
+  if (size < sizeof(task)) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer task record is truncated.");
+  }
+  memcpy(&task, payload, sizeof(task));
+  xr_thread_t *from = NULL;
+  if (task.parent != 0) {
+    from = xr_replay_tracer_find(tracer, task.parent);
+    if (from == NULL) {
+      return _XR_TRACER_ERROR(
+        tracer, "replay_tracer parent %d of task %d is not replayed.",
+        task.parent, task.tid);
+    }
+  }
+  xr_tracer_replay_task_t *node = xr_pool_alloc(&data->task_pool);
+  if (node == NULL) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer index task %d failed.",
+                            task.tid);
+  }
+  xr_process_t *process = xr_replay_tracer_process(tracer, from, task.pid);
+  xr_thread_t *thread = xr_tracer_new_thread(tracer);
+  xr_thread_init(thread);
+  thread->tid = task.tid;
+  thread->syscall_status = XR_THREAD_CALLOUT;
+  if (from != NULL) {
+    xr_thread_inherit(thread, from, task.share_files, task.share_fs);
+  } else {
+    xr_file_set_create(&thread->fset);
+    xr_fs_create(&thread->fs);
+    xr_path_t *pwd = xr_fs_pwd(&thread->fs);
+    pwd->length = 0;
+    xr_string_concat_raw(pwd, payload + sizeof(task), size - sizeof(task));
+  }
+  xr_process_add_thread(process, thread);
+  tracer->nthread++;
+  node->node.key = task.tid;
+  node->thread = thread;
+  if (xr_hash_insert(&data->tasks, &node->node) == false) {
+    xr_pool_free(&data->task_pool, node);
+    return _XR_TRACER_ERROR(tracer, "replay_tracer index task %d failed.",
+                            task.tid);
+  }
+  return true;
+}
+
+// time and memory of tracees are not captured, pids are not of this system.
+static bool xr_replay_tracer_sample(xr_tracer_t *tracer,
+                                    xr_process_t *process) {
+  return true;
+}
+
+void xr_tracer_replay_init(xr_tracer_t *tracer, const char *name) {
+  xr_tracer_init(tracer, name);
+  tracer->spwan = xr_replay_tracer_spawn;
+  tracer->step = xr_replay_tracer_step;
+  tracer->trap = xr_replay_tracer_trap;
+  tracer->get = xr_replay_tracer_get;
+  tracer->set = xr_replay_tracer_set;
+  tracer->strcpy = xr_replay_tracer_strcpy;
+  tracer->kill = xr_replay_tracer_kill;
+  tracer->sample = xr_replay_tracer_sample;
+  tracer->task_path = xr_replay_tracer_task_path;
+  tracer->_delete = xr_replay_tracer_delete;
+  tracer->clean = xr_replay_tracer_clean;
+  tracer->syscall_exit = true;
+  xr_tracer_replay_data_t *data = _XR_NEW(xr_tracer_replay_data_t);
+  memset(data, 0, sizeof(xr_tracer_replay_data_t));
+  data->run = -1;
+  xr_hash_init(&data->tasks);
+  xr_pool_init(&data->task_pool, sizeof(xr_tracer_replay_task_t));
+  tracer->tracer_data = data;
+}
+
+static inline bool xr_replay_tracer_read(xr_tracer_replay_data_t *data,
+                                         FILE *file) {
+  if (fseek(file, 0, SEEK_END) == -1) {
+    return false;
+  }
+  long size = ftell(file);
+  if (size < (long)sizeof(xr_capture_header_t) ||
+      fseek(file, 0, SEEK_SET) == -1) {
+    return false;
+  }
+  data->buffer = malloc(size);
+  if (data->buffer == NULL) {
+    return false;
+  }
+  data->size = size;
+  return fread(data->buffer, size, 1, file) == 1;
+}
+
+bool xr_tracer_replay_load(xr_tracer_t *tracer, const char *path) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  FILE *file = fopen(path, "re");
+  if (file == NULL) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer open capture %s failed.",
+                            path);
+  }
+  bool read = xr_replay_tracer_read(data, file);
+  fclose(file);
+  xr_capture_header_t header;
+  if (read) {
+    memcpy(&header, data->buffer, sizeof(header));
+  }
+  if (read == false ||
+      memcmp(header.magic, XR_CAPTURE_MAGIC, XR_CAPTURE_MAGIC_SIZE) != 0) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer %s is not a capture.",
+                            path);
+  }
+  tracer->syscall_exit = header.syscall_exit;
+  // index runs, a run which did not end has no status.
+  size_t offset = sizeof(header);
+  xr_capture_record_t record;
+  const char *payload;
+  int capacity = 0;
+  while (xr_replay_tracer_record(data, &offset, &record, &payload)) {
+    if (record.kind == XR_CAPTURE_BEGIN) {
+      if (data->nrun == capacity) {
+        capacity = capacity == 0 ? 16 : capacity * 2;
+        data->runs =
+          realloc(data->runs, capacity * sizeof(xr_tracer_replay_run_t));
+      }
+      data->runs[data->nrun].begin = offset;
+      data->runs[data->nrun].status = XR_RESULT_UNKNOWN;
+      data->nrun++;
+    } else if (record.kind == XR_CAPTURE_END && data->nrun > 0 &&
+               record.size >= sizeof(xr_capture_end_t)) {
+      memcpy(&data->runs[data->nrun - 1].status, payload,
+             sizeof(xr_capture_end_t));
+    }
+  }
+  if (data->nrun == 0) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer %s has no run.", path);
+  }
+  return true;
+}
+
+xr_tracer_code_t xr_tracer_replay_expect(xr_tracer_t *tracer) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  return data->run == -1 ? XR_RESULT_UNKNOWN : data->runs[data->run].status;
+}
+
+void xr_replay_tracer_clean(xr_tracer_t *tracer) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  size_t i;
+  xr_hash_node_t *cur, *temp;
+  _xr_hash_for_each_safe(&data->tasks, i, cur, temp) {
+    xr_pool_free(&data->task_pool,
+                 xr_hash_entry(cur, xr_tracer_replay_task_t, node));
+  }
+  xr_hash_clear(&data->tasks);
+}
+
+void xr_replay_tracer_delete(xr_tracer_t *tracer) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  xr_replay_tracer_clean(tracer);
+  xr_hash_delete(&data->tasks);
+  xr_pool_delete(&data->task_pool);
+  free(data->buffer);
+  free(data->runs);
+  free(tracer->tracer_data);
+}
+
+bool xr_replay_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  if (data->nrun == 0) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer has no capture loaded.");
+  }
+  data->run = (data->run + 1) % data->nrun;
+  data->offset = data->runs[data->run].begin;
+  data->memory_begin = data->memory_end = data->memory = data->offset;
+  // tasks of the first trap are recorded right after the run begins.
+  while (xr_replay_tracer_peek(data, XR_CAPTURE_TASK)) {
+    xr_capture_record_t record;
+    const char *payload;
+    xr_replay_tracer_record(data, &data->offset, &record, &payload);
+    if (xr_replay_tracer_task(tracer, payload, record.size) == false) {
+      return false;
+    }
+  }
+  if (xr_list_empty(&tracer->processes)) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer run %d has no task.",
+                            data->run);
+  }
+  return true;
+}
+
+// tracees of a replay do not run, they are resumed by the next trap.
+bool xr_replay_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  return true;
+}
+
+bool xr_replay_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  xr_capture_record_t record;
+  const char *payload;
+  trap->thread = NULL;
+  while (true) {
+    if (xr_replay_tracer_record(data, &data->offset, &record, &payload) ==
+          false ||
+        record.kind == XR_CAPTURE_BEGIN || record.kind == XR_CAPTURE_END) {
+      return _XR_TRACER_ERROR(tracer, "replay_tracer capture of run ended.");
+    }
+    if (record.kind == XR_CAPTURE_TRAP) {
+      break;
+    }
+    // memory read by tracer itself before the trap is not replayed.
+    if (record.kind == XR_CAPTURE_TASK &&
+        xr_replay_tracer_task(tracer, payload, record.size) == false) {
+      return false;
+    }
+  }
+  xr_capture_trap_t captured;
+  if (record.size < sizeof(captured)) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer trap record is truncated.");
+  }
+  memcpy(&captured, payload, sizeof(captured));
+  xr_thread_t *thread = xr_replay_tracer_find(tracer, captured.tid);
+  if (thread == NULL) {
+    return _XR_TRACER_ERROR(tracer, "replay_tracer task %d is not replayed.",
+                            captured.tid);
+  }
+  thread->syscall_status = captured.syscall_status;
+  thread->clone_flags = captured.clone_flags;
+  thread->process->compat = captured.compat;
+  trap->thread = thread;
+  trap->trap = captured.trap;
+  if (trap->trap == XR_TRACE_TRAP_SYSCALL) {
+    trap->syscall_info = captured.syscall_info;
+  } else {
+    trap->exit_code = captured.exit_code;
+  }
+  // memory read by checkers on this trap follows it.
+  data->memory_begin = data->memory = data->offset;
+  while (xr_replay_tracer_peek(data, XR_CAPTURE_MEMORY)) {
+    xr_replay_tracer_record(data, &data->offset, &record, &payload);
+  }
+  data->memory_end = data->offset;
+  if (trap->trap == XR_TRACE_TRAP_EXIT ||
+      trap->trap == XR_TRACE_TRAP_SIGEXIT) {
+    xr_replay_tracer_drop(tracer, thread->tid);
+  }
+  return true;
+}
+
+/**
+ * Find memory of task at address which checkers read on trap replayed now.
+ * Reads are matched in order they were captured, from the one after the
+ * record found last.
+ *
+ * @@tracer
+ * @pid tid of task
+ * @address address in task
+ * @op op which read it
+ * @memory output payload of record
+ * @size output size of bytes following memory
+ *
+ * @return NULL if no such memory is captured.
+ */
+static const char *xr_replay_tracer_memory(xr_tracer_t *tracer, int pid,
+                                           xr_capture_op_t op,
+                                           unsigned long address,
+                                           xr_capture_memory_t *memory,
+                                           size_t *size) {
+  xr_tracer_replay_data_t *data = xr_tracer_replay_data(tracer);
+  size_t offsets[2] = {data->memory, data->memory_begin};
+  size_t ends[2] = {data->memory_end, data->memory};
+  for (int pass = 0; pass < 2; ++pass) {
+    size_t offset = offsets[pass];
+    xr_capture_record_t record;
+    const char *payload;
+    while (offset < ends[pass] &&
+           xr_replay_tracer_record(data, &offset, &record, &payload)) {
+      if (record.size < sizeof(xr_capture_memory_t)) {
+        continue;
+      }
+      memcpy(memory, payload, sizeof(xr_capture_memory_t));
+      if (memory->tid == pid && memory->op == op &&
+          memory->address == address) {
+        data->memory = offset;
+        *size = record.size - sizeof(xr_capture_memory_t);
+        return payload + sizeof(xr_capture_memory_t);
+      }
+    }
+  }
+  return NULL;
+}
+
+bool xr_replay_tracer_get(xr_tracer_t *tracer, int pid, void *address,
+                          void *buffer, size_t size) {
+  xr_capture_memory_t memory;
+  size_t captured;
+  const char *bytes = xr_replay_tracer_memory(
+    tracer, pid, XR_CAPTURE_GET, (unsigned long)address, &memory, &captured);
+  if (bytes == NULL || (memory.ok && captured != size)) {
+    return _XR_TRACER_ERROR(
+      tracer, "replay_tracer %zu bytes of task %d at %p are not captured.",
+      size, pid, address);
+  }
+  if (memory.ok == false) {
+    return _XR_TRACER_ERROR(
+      tracer, "replay_tracer reading task %d at %p failed when captured.", pid,
+      address);
+  }
+  memcpy(buffer, bytes, size);
+  return true;
+}
+
+// replayed tracees never run, what is written to them is dropped.
+bool xr_replay_tracer_set(xr_tracer_t *tracer, int pid, void *address,
+                          const void *buffer, size_t size) {
+  return true;
+}
+
+bool xr_replay_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                             xr_string_t *str) {
+  xr_capture_memory_t memory;
+  size_t captured;
+  const char *bytes = xr_replay_tracer_memory(
+    tracer, pid, XR_CAPTURE_STRCPY, (unsigned long)address, &memory, &captured);
+  if (bytes == NULL) {
+    return _XR_TRACER_ERROR(
+      tracer, "replay_tracer string of task %d at %p is not captured.", pid,
+      address);
+  }
+  if (memory.ok == false) {
+    return _XR_TRACER_ERROR(
+      tracer, "replay_tracer reading task %d at %p failed when captured.", pid,
+      address);
+  }
+  str->length = 0;
+  xr_string_concat_raw(str, bytes, captured);
+  return true;
+}
+
+// pwd or opened directories of tasks are served as tracer resolved them.
+bool xr_replay_tracer_task_path(xr_tracer_t *tracer, int tid, int fd,
+                                xr_path_t *path) {
+  xr_capture_memory_t memory;
+  size_t captured;
+  const char *bytes = xr_replay_tracer_memory(
+    tracer, tid, XR_CAPTURE_TASK_PATH, fd, &memory, &captured);
+  if (bytes == NULL || memory.ok == false) {
+    return false;
+  }
+  path->length = 0;
+  xr_string_concat_raw(path, bytes, captured);
+  return true;
+}
+
+void xr_replay_tracer_kill(xr_tracer_t *tracer, pid_t pid) {}
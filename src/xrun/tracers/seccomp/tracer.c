@@ -0,0 +1,1316 @@
+#define _GNU_SOURCE
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <endian.h>
+#include <fcntl.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "xrun/calls.h"
+#include "xrun/entry.h"
+#include "xrun/landlock.h"
+#include "xrun/option.h"
+#include "xrun/process.h"
+#include "xrun/sandbox.h"
+#include "xrun/stats.h"
+#include "xrun/tracer.h"
+#include "xrun/tracers/seccomp/tracer.h"
+#include "xrun/utils/proc.h"
+#include "xrun/utils/utils.h"
+#include "xrun/workspace.h"
+
+#if defined(SECCOMP_RET_USER_NOTIF) && defined(__NR_pidfd_open)
+
+#if defined(XR_ARCH_X86_64)
+#define XR_SECCOMP_AUDIT_ARCH AUDIT_ARCH_X86_64
+#elif defined(XR_ARCH_X86_IA32)
+#define XR_SECCOMP_AUDIT_ARCH AUDIT_ARCH_I386
+#elif defined(XR_ARCH_ARM)
+#define XR_SECCOMP_AUDIT_ARCH AUDIT_ARCH_ARM
+#elif defined(XR_ARCH_AARCH64)
+#define XR_SECCOMP_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#endif
+
+#ifndef XR_SYSCALL_EXECVE
+#define XR_SYSCALL_EXECVE -1
+#endif
+#ifndef XR_SYSCALL_EXECVEAT
+#define XR_SYSCALL_EXECVEAT -1
+#endif
+
+// waitid on a pidfd, in linux/wait.h only.
+#ifndef P_PIDFD
+#define P_PIDFD 3
+#endif
+
+// syscalls checked by checkers on entry, they trap even if permitted.
+static const long xr_seccomp_watched_calls[] = {
+#ifdef XR_SYSCALL_OPEN
+  XR_SYSCALL_OPEN,
+#endif
+#ifdef XR_SYSCALL_OPENAT
+  XR_SYSCALL_OPENAT,
+#endif
+#ifdef XR_SYSCALL_CREAT
+  XR_SYSCALL_CREAT,
+#endif
+#ifdef XR_SYSCALL_CHDIR
+  XR_SYSCALL_CHDIR,
+#endif
+#ifdef XR_SYSCALL_CLONE
+  XR_SYSCALL_CLONE,
+#endif
+#ifdef XR_SYSCALL_FORK
+  XR_SYSCALL_FORK,
+#endif
+#ifdef XR_SYSCALL_VFORK
+  XR_SYSCALL_VFORK,
+#endif
+  // thread exits are only visible on exit syscall.
+  XR_SYSCALL_EXIT,
+  // a child is only reaped, or orphaned, after its parent traps in them, so
+  // children of clones can always be found before they are gone.
+#ifdef XR_SYSCALL_WAIT4
+  XR_SYSCALL_WAIT4,
+#endif
+#ifdef XR_SYSCALL_WAITID
+  XR_SYSCALL_WAITID,
+#endif
+#ifdef XR_SYSCALL_WAITPID
+  XR_SYSCALL_WAITPID,
+#endif
+#ifdef XR_SYSCALL_EXIT_GROUP
+  XR_SYSCALL_EXIT_GROUP,
+#endif
+};
+
+#define XR_SECCOMP_WATCHED_CALLS \
+  (sizeof(xr_seccomp_watched_calls) / sizeof(long))
+
+// two instructions per syscall, with header, sendmsg and clone3 exceptions.
+#define XR_SECCOMP_FILTER_MAX \
+  ((XR_SYSCALL_MAX + XR_SECCOMP_WATCHED_CALLS) * 2 + 20)
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define XR_SECCOMP_ARG_LOW 0
+#define XR_SECCOMP_ARG_HIGH sizeof(__u32)
+#else
+#define XR_SECCOMP_ARG_LOW sizeof(__u32)
+#define XR_SECCOMP_ARG_HIGH 0
+#endif
+
+#define XR_SECCOMP_ARG(index, half) \
+  (offsetof(struct seccomp_data, args) + (index) * sizeof(__u64) + (half))
+
+// epoll tags of listener and deadline timer, other events are tagged with
+// pid of pidfd.
+#define XR_SECCOMP_EVENT_LISTENER 0
+#define XR_SECCOMP_EVENT_TIMER UINT64_MAX
+
+// child of a clone which is not found by then is attached on its first trap.
+#define XR_SECCOMP_CLONE_TIMEOUT 10000000ull
+// deadline timer never fires more often than this.
+#define XR_SECCOMP_DEADLINE_MIN 1000000ull
+
+struct xr_tracer_seccomp_task_s;
+typedef struct xr_tracer_seccomp_task_s xr_tracer_seccomp_task_t;
+struct xr_tracer_seccomp_task_s {
+  pid_t pid;
+  int pidfd;
+  xr_tracer_seccomp_task_t *next;
+};
+
+// a clone which is continued, whose child is not attached yet.
+typedef struct xr_tracer_seccomp_clone_s xr_tracer_seccomp_clone_t;
+struct xr_tracer_seccomp_clone_s {
+  pid_t tid, tgid;
+  // raw syscall number of clone, which task is in until clone returns.
+  int nr;
+  unsigned long flags;
+  unsigned long long since;
+};
+
+typedef struct xr_tracer_seccomp_exit_s xr_tracer_seccomp_exit_t;
+struct xr_tracer_seccomp_exit_s {
+  xr_thread_t *thread;
+  int exit_code;
+};
+
+struct xr_tracer_seccomp_data_s;
+typedef struct xr_tracer_seccomp_data_s xr_tracer_seccomp_data_t;
+struct xr_tracer_seccomp_data_s {
+  int listener, epoll, timer;
+  struct seccomp_notif_sizes sizes;
+  struct seccomp_notif *notif;
+  struct seccomp_notif_resp *resp;
+
+  // notification being checked, pending until it is replied.
+  __u64 id;
+  pid_t pid;
+  bool pending, clone;
+  // spawned task whose execve is not reported.
+  pid_t execve;
+
+  xr_tracer_seccomp_task_t *tasks;
+  xr_tracer_seccomp_exit_t *exits;
+  int nexit, cexit;
+  xr_tracer_seccomp_clone_t *clones;
+  int nclone, cclone;
+  // children listed from /proc.
+  pid_t *pids;
+  int cpid;
+  xr_path_t pwd;
+};
+
+static inline xr_tracer_seccomp_data_t *xr_tracer_seccomp_data(
+  xr_tracer_t *tracer) {
+  return (xr_tracer_seccomp_data_t *)tracer->tracer_data;
+}
+
+void xr_tracer_seccomp_init(xr_tracer_t *tracer, const char *name) {
+  xr_tracer_init(tracer, name);
+  tracer->spwan = xr_seccomp_tracer_spawn;
+  tracer->step = xr_seccomp_tracer_step;
+  tracer->trap = xr_seccomp_tracer_trap;
+  tracer->get = xr_seccomp_tracer_get;
+  tracer->set = xr_seccomp_tracer_set;
+  tracer->strcpy = xr_seccomp_tracer_strcpy;
+  tracer->kill = xr_seccomp_tracer_kill;
+  tracer->_delete = xr_seccomp_tracer_delete;
+  tracer->clean = xr_seccomp_tracer_clean;
+  tracer->syscall_exit = false;
+  // orphaned tracees are reparented to tracer, then we can reap them.
+  prctl(PR_SET_CHILD_SUBREAPER, 1);
+
+  xr_tracer_seccomp_data_t *data = _XR_NEW(xr_tracer_seccomp_data_t);
+  memset(data, 0, sizeof(xr_tracer_seccomp_data_t));
+  data->listener = data->epoll = data->timer = -1;
+  if (syscall(__NR_seccomp, SECCOMP_GET_NOTIF_SIZES, 0, &data->sizes) == -1) {
+    // fallback to sizes of headers, kernel will refuse them if too small.
+    data->sizes.seccomp_notif = sizeof(struct seccomp_notif);
+    data->sizes.seccomp_notif_resp = sizeof(struct seccomp_notif_resp);
+    errno = 0;
+  }
+  data->notif = malloc(
+    XR_MAX(data->sizes.seccomp_notif, sizeof(struct seccomp_notif)));
+  data->resp = malloc(
+    XR_MAX(data->sizes.seccomp_notif_resp, sizeof(struct seccomp_notif_resp)));
+  tracer->tracer_data = data;
+}
+
+/**
+ * Reply a notification, which continues its syscall, or fails it with error.
+ *
+ * @data tracer data
+ * @id id of notification
+ * @error negative errno of syscall, or 0 to continue it
+ */
+static inline bool xr_seccomp_tracer_reply(xr_tracer_seccomp_data_t *data,
+                                           __u64 id, int error) {
+  memset(data->resp, 0, data->sizes.seccomp_notif_resp);
+  data->resp->id = id;
+  if (error == 0) {
+    data->resp->flags = SECCOMP_USER_NOTIF_FLAG_CONTINUE;
+  } else {
+    data->resp->error = error;
+  }
+  data->pending = false;
+  if (ioctl(data->listener, SECCOMP_IOCTL_NOTIF_SEND, data->resp) == -1) {
+    // task has been killed while trapping.
+    if (errno == ENOENT) {
+      errno = 0;
+      return true;
+    }
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reap tracees after they are killed. It blocks until process group of run
+ * has no tracee left, orphaned tracees included, since tracer is their
+ * subreaper. Then tracees which left the group are reaped by their pidfds if
+ * they are children of tracer by now. Other children of tracer are never
+ * waited for.
+ *
+ * @@tracer
+ */
+static inline void xr_seccomp_tracer_drain(xr_tracer_t *tracer) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  siginfo_t info;
+  while (tracer->pgid > 0 &&
+         (waitid(P_PGID, tracer->pgid, &info, WEXITED | __WALL) == 0 ||
+          errno == EINTR)) {
+  }
+  for (xr_tracer_seccomp_task_t *task = data->tasks; task; task = task->next) {
+    while (waitid(P_PIDFD, task->pidfd, &info, WEXITED | __WALL) == -1 &&
+           errno == EINTR) {
+    }
+  }
+  errno = 0;
+}
+
+void xr_seccomp_tracer_clean(xr_tracer_t *tracer) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  // a denied syscall fails with EPERM, rather than ENOSYS of closing listener.
+  if (data->pending) {
+    xr_seccomp_tracer_reply(data, data->id, -EPERM);
+  }
+  // closing listener fails pending and further notification with ENOSYS.
+  if (data->listener != -1) {
+    close(data->listener);
+    data->listener = -1;
+  }
+  if (data->epoll != -1) {
+    close(data->epoll);
+    data->epoll = -1;
+  }
+  if (data->timer != -1) {
+    close(data->timer);
+    data->timer = -1;
+  }
+  xr_tracer_seccomp_task_t *task;
+  for (task = data->tasks; task != NULL; task = task->next) {
+    kill(task->pid, SIGKILL);
+  }
+  xr_seccomp_tracer_drain(tracer);
+  while (data->tasks) {
+    task = data->tasks;
+    data->tasks = task->next;
+    close(task->pidfd);
+    free(task);
+  }
+  data->nexit = 0;
+  data->nclone = 0;
+  data->execve = 0;
+}
+
+void xr_seccomp_tracer_delete(xr_tracer_t *tracer) {
+  xr_seccomp_tracer_clean(tracer);
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  free(data->notif);
+  free(data->resp);
+  free(data->exits);
+  free(data->clones);
+  free(data->pids);
+  xr_path_delete(&data->pwd);
+  free(data);
+}
+
+static inline void xr_bpf_push(struct sock_filter *filter, int *n,
+                               __u16 code, __u8 jt, __u8 jf, __u32 k) {
+  filter[*n] = (struct sock_filter){code, jt, jf, k};
+  (*n)++;
+}
+
+static inline bool xr_seccomp_open_call(long call) {
+#ifdef XR_SYSCALL_OPEN
+  if (call == XR_SYSCALL_OPEN) {
+    return true;
+  }
+#endif
+#ifdef XR_SYSCALL_OPENAT
+  if (call == XR_SYSCALL_OPENAT) {
+    return true;
+  }
+#endif
+#ifdef XR_SYSCALL_CREAT
+  if (call == XR_SYSCALL_CREAT) {
+    return true;
+  }
+#endif
+  return false;
+}
+
+/**
+ * Build filter of tracee. Permitted syscalls are allowed unless they are
+ * watched, and the others trap into tracer. sendmsg on sock with msg is
+ * allowed, since it delivers the listener before tracer is listening. clone3
+ * fails with ENOSYS, see xr_tracer_is_clone3. Opens are not watched if
+ * landlock covers access lists, landlock enforces them alone then. As seccomp
+ * never traps on exit, its denials are only seen by tracee as EACCES.
+ *
+ * @option tracer option
+ * @filter output filter with XR_SECCOMP_FILTER_MAX instructions
+ * @sock socket delivering listener
+ * @msg address of message delivering listener
+ *
+ * @return length of filter
+ */
+static inline int xr_seccomp_filter_build(xr_option_t *option,
+                                          struct sock_filter *filter, int sock,
+                                          void *msg) {
+  int n = 0;
+  __u64 address = (uintptr_t)msg;
+  // syscalls of other abi are always trapped
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              offsetof(struct seccomp_data, arch));
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 1, 0,
+              XR_SECCOMP_AUDIT_ARCH);
+  xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0, SECCOMP_RET_USER_NOTIF);
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              offsetof(struct seccomp_data, nr));
+#ifdef XR_SYSCALL_SENDMSG
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 7, XR_SYSCALL_SENDMSG);
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              XR_SECCOMP_ARG(0, XR_SECCOMP_ARG_LOW));
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 5, sock);
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              XR_SECCOMP_ARG(1, XR_SECCOMP_ARG_LOW));
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 3, (__u32)address);
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              XR_SECCOMP_ARG(1, XR_SECCOMP_ARG_HIGH));
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 1, address >> 32);
+  xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0, SECCOMP_RET_ALLOW);
+  xr_bpf_push(filter, &n, BPF_LD | BPF_W | BPF_ABS, 0, 0,
+              offsetof(struct seccomp_data, nr));
+#endif
+#ifdef XR_SYSCALL_CLONE3
+  xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 1, XR_SYSCALL_CLONE3);
+  xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0,
+              SECCOMP_RET_ERRNO | (ENOSYS & SECCOMP_RET_DATA));
+#endif
+  bool opens = (option->landlock && xr_landlock_abi() > 0 &&
+                xr_landlock_covers(option)) == false;
+  for (int i = 0; i < XR_SECCOMP_WATCHED_CALLS; ++i) {
+    if (opens == false && xr_seccomp_open_call(xr_seccomp_watched_calls[i])) {
+      continue;
+    }
+    xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 1,
+                xr_seccomp_watched_calls[i]);
+    xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0, SECCOMP_RET_USER_NOTIF);
+  }
+  for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
+    if (option->calls[i]) {
+      xr_bpf_push(filter, &n, BPF_JMP | BPF_JEQ | BPF_K, 0, 1, i);
+      xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0, SECCOMP_RET_ALLOW);
+    }
+  }
+  xr_bpf_push(filter, &n, BPF_RET | BPF_K, 0, 0, SECCOMP_RET_USER_NOTIF);
+  return n;
+}
+
+// we try to set close on exec for any other file description
+static inline void xr_seccomp_try_cloexec() {
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    for (int i = 3; i < limit.rlim_cur; ++i) {
+      fcntl(i, F_SETFD, FD_CLOEXEC);
+    }
+  }
+}
+
+static inline void do_exec(xr_tracer_t *tracer, xr_entry_t *entry, int sock) {
+  if (prctl(PR_SET_PDEATHSIG, SIGKILL) == -1) {
+    _XR_TRACER_ERROR(tracer, "prctl PR_SET_PDEATHSIG failed.");
+    return;
+  }
+  if (setpgid(0, 0) == -1) {
+    _XR_TRACER_ERROR(tracer, "setpgid of tracee failed.");
+    return;
+  }
+  if (tracer->sandbox != NULL &&
+      xr_sandbox_enter(tracer->sandbox) == false) {
+    _XR_TRACER_ERROR(tracer, "enter sandbox failed.");
+    return;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (dup2(i, entry->stdio[i]) == -1) {
+      _XR_TRACER_ERROR(tracer, "dup file %d error.", i);
+      return;
+    }
+  }
+  xr_seccomp_try_cloexec();
+  if (tracer->option->landlock && xr_landlock_abi() > 0 &&
+      xr_landlock_restrict(tracer->option,
+                           tracer->workspace ? &tracer->workspace->path : NULL,
+                           &entry->root) == false) {
+    _XR_TRACER_ERROR(tracer, "landlock restrict error.");
+    return;
+  }
+  // filter is installed after chroot and chdir, which are not reported.
+  if (xr_entry_enter(entry) == false) {
+    _XR_TRACER_ERROR(tracer, "enter root and pwd of entry failed.");
+    return;
+  }
+  if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1) {
+    _XR_TRACER_ERROR(tracer, "prctl PR_SET_NO_NEW_PRIVS failed.");
+    return;
+  }
+
+  char byte = 0;
+  struct iovec iov = {.iov_base = &byte, .iov_len = sizeof(byte)};
+  union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+  struct msghdr msg = {
+    .msg_iov = &iov,
+    .msg_iovlen = 1,
+    .msg_control = control.buf,
+    .msg_controllen = sizeof(control.buf),
+  };
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+
+  struct sock_filter *filter =
+    malloc(sizeof(struct sock_filter) * XR_SECCOMP_FILTER_MAX);
+  struct sock_fprog prog = {
+    .len = xr_seccomp_filter_build(tracer->option, filter, sock, &msg),
+    .filter = filter,
+  };
+  int listener = syscall(__NR_seccomp, SECCOMP_SET_MODE_FILTER,
+                         SECCOMP_FILTER_FLAG_NEW_LISTENER, &prog);
+  if (listener == -1) {
+    _XR_TRACER_ERROR(tracer, "install seccomp filter failed.");
+    return;
+  }
+  // listener is close on exec, no need to close it.
+  memcpy(CMSG_DATA(cmsg), &listener, sizeof(int));
+  if (sendmsg(sock, &msg, 0) == -1) {
+    _XR_TRACER_ERROR(tracer, "send seccomp listener failed.");
+    return;
+  }
+  xr_entry_exec(entry);
+  _XR_TRACER_ERROR(tracer, "execvpe error.");
+}
+
+static inline int xr_seccomp_recv_listener(int sock) {
+  char byte = 0;
+  struct iovec iov = {.iov_base = &byte, .iov_len = sizeof(byte)};
+  union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } control;
+  struct msghdr msg = {
+    .msg_iov = &iov,
+    .msg_iovlen = 1,
+    .msg_control = control.buf,
+    .msg_controllen = sizeof(control.buf),
+  };
+  if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+    return -1;
+  }
+  struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS) {
+    return -1;
+  }
+  int listener;
+  memcpy(&listener, CMSG_DATA(cmsg), sizeof(int));
+  return listener;
+}
+
+/**
+ * Watch exit of process via pidfd.
+ *
+ * @@tracer
+ * @pid pid of process
+ */
+static inline bool xr_seccomp_tracer_watch(xr_tracer_t *tracer, pid_t pid) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  int pidfd = syscall(__NR_pidfd_open, pid, 0);
+  if (pidfd == -1) {
+    return false;
+  }
+  struct epoll_event event = {.events = EPOLLIN, .data.u64 = pid};
+  if (epoll_ctl(data->epoll, EPOLL_CTL_ADD, pidfd, &event) == -1) {
+    close(pidfd);
+    return false;
+  }
+  xr_tracer_seccomp_task_t *task = _XR_NEW(xr_tracer_seccomp_task_t);
+  task->pid = pid;
+  task->pidfd = pidfd;
+  task->next = data->tasks;
+  data->tasks = task;
+  return true;
+}
+
+static inline void xr_seccomp_tracer_unwatch(xr_tracer_t *tracer, pid_t pid) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  xr_tracer_seccomp_task_t **task = &data->tasks;
+  while (*task) {
+    if ((*task)->pid == pid) {
+      xr_tracer_seccomp_task_t *unwatched = *task;
+      *task = unwatched->next;
+      epoll_ctl(data->epoll, EPOLL_CTL_DEL, unwatched->pidfd, NULL);
+      close(unwatched->pidfd);
+      free(unwatched);
+      return;
+    }
+    task = &(*task)->next;
+  }
+}
+
+static inline xr_process_t *xr_tracer_select_process(xr_tracer_t *tracer,
+                                                     pid_t pid) {
+  xr_process_t *process;
+  _xr_list_for_each_entry(&(tracer->processes), process, xr_process_t,
+                          processes) {
+    if (process->pid == pid) {
+      return process;
+    }
+  }
+  return NULL;
+}
+
+static inline xr_thread_t *xr_tracer_select_thread(xr_tracer_t *tracer,
+                                                   pid_t pid) {
+  xr_thread_t *thread;
+  xr_process_t *process;
+  _xr_list_for_each_entry(&(tracer->processes), process, xr_process_t,
+                          processes) {
+    _xr_list_for_each_entry(&(process->threads), thread, xr_thread_t, threads) {
+      if (thread->tid == pid) {
+        return thread;
+      }
+    }
+  }
+  return NULL;
+}
+
+static xr_process_t *create_process(xr_tracer_t *tracer, pid_t pid) {
+  if (xr_seccomp_tracer_watch(tracer, pid) == false) {
+    return NULL;
+  }
+  xr_process_t *process = xr_tracer_new_process(tracer);
+  xr_process_init(process);
+  process->pid = pid;
+  xr_list_add(&(tracer->processes), &(process->processes));
+  tracer->nprocess++;
+  return process;
+}
+
+/**
+ * Read thread group and parent of a task from /proc.
+ *
+ * @tid task id
+ * @tgid thread group id of task
+ * @ppid parent process id of task
+ */
+static inline bool xr_seccomp_task_ids(pid_t tid, pid_t *tgid, pid_t *ppid) {
+  char path[32], line[128];
+  snprintf(path, sizeof(path), "/proc/%d/status", tid);
+  FILE *status = fopen(path, "re");
+  if (status == NULL) {
+    return false;
+  }
+  int found = 0;
+  while (found != 2 && fgets(line, sizeof(line), status) != NULL) {
+    found += sscanf(line, "Tgid: %d", tgid) == 1;
+    found += sscanf(line, "PPid: %d", ppid) == 1;
+  }
+  fclose(status);
+  return found == 2;
+}
+
+/**
+ * Create a task trapped for the first time. Since clone never traps on exit,
+ * the task is attached to its thread group or parent here. Threads share
+ * files and fs with thread group, while processes copy them from parent.
+ *
+ * @@tracer
+ * @tid task id
+ */
+static xr_thread_t *xr_seccomp_tracer_attach(xr_tracer_t *tracer, pid_t tid) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  pid_t tgid = 0, ppid = 0;
+  if (xr_seccomp_task_ids(tid, &tgid, &ppid) == false) {
+    return NULL;
+  }
+  xr_process_t *process = xr_tracer_select_process(tracer, tgid);
+  xr_thread_t *from = xr_process_first_thread(process);
+  bool fork = (process == NULL);
+  if (fork) {
+    from = xr_process_first_thread(xr_tracer_select_process(tracer, ppid));
+    process = create_process(tracer, tgid);
+    if (process == NULL) {
+      return NULL;
+    }
+  }
+  xr_thread_t *thread = xr_tracer_new_thread(tracer);
+  xr_thread_init(thread);
+  thread->tid = tid;
+  if (from != NULL) {
+    xr_thread_inherit(thread, from, !fork, !fork);
+  } else {
+    xr_file_set_create(&thread->fset);
+    xr_fs_create(&thread->fs);
+    xr_string_copy(xr_fs_pwd(&thread->fs), &data->pwd);
+  }
+  xr_process_add_thread(process, thread);
+  tracer->nthread++;
+  return thread;
+}
+
+/**
+ * Attach tasks listed from /proc which are not attached yet. Tasks are listed
+ * oldest first, so the list is walked back until an attached one.
+ *
+ * @@tracer
+ * @n number of tasks in pids of tracer data
+ *
+ * @return number of attached tasks
+ */
+static inline int xr_seccomp_tracer_attach_listed(xr_tracer_t *tracer, int n) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  int nattached = 0;
+  for (int i = n - 1; i >= 0; --i) {
+    if (xr_tracer_select_thread(tracer, data->pids[i]) != NULL) {
+      break;
+    }
+    nattached += xr_seccomp_tracer_attach(tracer, data->pids[i]) != NULL;
+  }
+  return nattached;
+}
+
+/**
+ * Attach children of continued clones. Clone never traps on exit, so the
+ * child is looked up among children of cloning task in /proc once it has
+ * left clone, or once clone has made a vfork child. Threads are left to their
+ * first trap, which exit syscall is at the latest.
+ *
+ * @@tracer
+ * @tid only clones of tid, which has left clone, or 0 for all
+ */
+static inline void xr_seccomp_tracer_adopt(xr_tracer_t *tracer, pid_t tid) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  unsigned long long now = xr_time_now_ns();
+  for (int i = data->nclone - 1; i >= 0; --i) {
+    xr_tracer_seccomp_clone_t *clone = &data->clones[i];
+    if (tid != 0 && clone->tid != tid) {
+      continue;
+    }
+    // a running task may still be in clone, which can not be told.
+    long nr = clone->nr;
+    bool done = tid != 0 || kill(clone->tid, 0) == -1 ||
+                (xr_proc_syscall(clone->tid, &nr) && nr != clone->nr) ||
+                now - clone->since > XR_SECCOMP_CLONE_TIMEOUT;
+    if (done == false && (clone->flags & CLONE_VFORK) == 0) {
+      continue;
+    }
+    int n = xr_proc_children(clone->tid, &data->pids, &data->cpid);
+    if ((n > 0 && xr_seccomp_tracer_attach_listed(tracer, n) != 0) || done) {
+      data->clones[i] = data->clones[--data->nclone];
+    }
+  }
+  errno = 0;
+}
+
+/**
+ * Arm deadline timer to fire after ns. Timer is not armed without a time
+ * limit.
+ *
+ * @data tracer data
+ * @ns time to fire in ns
+ */
+static inline bool xr_seccomp_tracer_arm(xr_tracer_seccomp_data_t *data,
+                                         unsigned long long ns) {
+  if (data->timer == -1) {
+    return true;
+  }
+  ns = XR_MAX(ns, XR_SECCOMP_DEADLINE_MIN);
+  struct itimerspec spec = {
+    .it_value = {.tv_sec = ns / 1000000000, .tv_nsec = ns % 1000000000},
+  };
+  return timerfd_settime(data->timer, 0, &spec, NULL) == 0;
+}
+
+static inline unsigned long long xr_seccomp_left_ns(xr_time_ms_t limit,
+                                                    unsigned long long ns) {
+  if (limit == ULONG_MAX) {
+    return ULLONG_MAX;
+  }
+  return ns >= limit * 1000000ull ? 0 : limit * 1000000ull - ns;
+}
+
+/**
+ * Cpu time a process may still run before it exceeds a time limit. user_time
+ * per process limits its whole cpu time, as RLIMIT_CPU would, and sys_time
+ * its sys time. Run limits are held by each process, as resource checker
+ * holds them.
+ *
+ * @option tracer option
+ * @ns cpu time of process in ns
+ * @time user and sys time of process
+ *
+ * @return ns left, 0 if a limit is exceeded, ULLONG_MAX if none is set.
+ */
+static inline unsigned long long xr_seccomp_time_left(xr_option_t *option,
+                                                      unsigned long long ns,
+                                                      xr_time_t time) {
+  const xr_time_t *process = &option->limit_per_process.time,
+                  *run = &option->limit.time;
+  unsigned long long left = xr_seccomp_left_ns(process->user_time, ns);
+  left = XR_MIN(left, xr_seccomp_left_ns(process->sys_time,
+                                         time.sys_time * 1000000ull));
+  left = XR_MIN(left, xr_seccomp_left_ns(run->user_time,
+                                         time.user_time * 1000000ull));
+  return XR_MIN(left, xr_seccomp_left_ns(run->sys_time,
+                                         time.sys_time * 1000000ull));
+}
+
+/**
+ * Check time of processes when deadline timer fires, as resource checker
+ * does on traps, which a task spinning in user mode never hits. A process
+ * over a limit is reported as stopped by SIGXCPU, as kernel signals it.
+ * Otherwise timer is armed again for the process closest to a limit, whose
+ * cpu time grows at most nthread times as fast as wall time.
+ *
+ * @@tracer
+ * @@trap
+ *
+ * @return true if a process is over a limit.
+ */
+static inline bool xr_seccomp_tracer_deadline(xr_tracer_t *tracer,
+                                              xr_trace_trap_t *trap) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  uint64_t expirations;
+  read(data->timer, &expirations, sizeof(expirations));
+  unsigned long long left = ULLONG_MAX;
+  xr_process_t *process;
+  _xr_list_for_each_entry(&tracer->processes, process, xr_process_t,
+                          processes) {
+    xr_thread_t *thread = xr_process_first_thread(process);
+    if (thread == NULL || tracer->sample(tracer, process) == false) {
+      continue;
+    }
+    unsigned long long ns = process->cpu_ns;
+    xr_time_t time = process->time;
+    if (tracer->option->compensate) {
+      ns = xr_tracer_compensate_ns(tracer, process->nstop, ns);
+      time = xr_tracer_compensate_time(tracer, process->nstop, time);
+    }
+    unsigned long long process_left =
+      xr_seccomp_time_left(tracer->option, ns, time);
+    if (process_left == 0) {
+      trap->trap = XR_TRACE_TRAP_SIGNAL;
+      trap->thread = thread;
+      trap->stop_signal = SIGXCPU;
+      trap->synthetic = true;
+      return true;
+    }
+    left = XR_MIN(left, process_left / XR_MAX(process->nthread, 1));
+  }
+  errno = 0;
+  xr_seccomp_tracer_arm(data, left);
+  return false;
+}
+
+#define xr_close_pipe(pipe) \
+  do {                      \
+    close(pipe[0]);         \
+    close(pipe[1]);         \
+  } while (0)
+
+bool xr_seccomp_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  // open pipe for delivering error
+  int error_pipe[2] = {};
+  if (pipe2(error_pipe, O_NONBLOCK | O_CLOEXEC) == -1) {
+    return _XR_TRACER_ERROR(tracer, "seccomp_tracer popen error pipe failed.");
+  }
+  // socket for delivering listener
+  int sock[2] = {};
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sock) == -1) {
+    xr_close_pipe(error_pipe);
+    return _XR_TRACER_ERROR(tracer, "seccomp_tracer open socket failed.");
+  }
+  pid_t fork_ret = fork();
+  if (fork_ret < 0) {
+    xr_close_pipe(error_pipe);
+    xr_close_pipe(sock);
+    return _XR_TRACER_ERROR(tracer, "seccomp_tracer fork failed.");
+  }
+
+  if (fork_ret == 0) {
+    close(sock[0]);
+    do_exec(tracer, entry, sock[1]);
+
+    // exec failed. die here
+    // send tracer->error into pipe
+    xr_string_t estr;
+    xr_string_zero(&estr);
+    xr_error_tostring(&tracer->error, &estr);
+    write(error_pipe[1], &estr.length, sizeof(estr.length));
+    write(error_pipe[1], estr.string, sizeof(char) * estr.length);
+    _exit(1);
+  }
+
+  // nothing stops child before execve, both sides set group as shells do.
+  setpgid(fork_ret, fork_ret);
+  xr_tracer_own_group(tracer, entry, fork_ret);
+  close(sock[1]);
+  int listener = xr_seccomp_recv_listener(sock[0]);
+  close(sock[0]);
+  if (listener == -1) {
+    // child died before delivering listener, try to read error info
+    waitpid(fork_ret, NULL, __WALL);
+    size_t estr_len;
+    if (read(error_pipe[0], &estr_len, sizeof(estr_len)) ==
+        sizeof(estr_len)) {
+      xr_string_t estr;
+      xr_string_init(&estr, estr_len + 1);
+      estr.length = XR_MAX(read(error_pipe[0], estr.string, estr_len), 0);
+      estr.string[estr.length] = 0;
+      errno = 0;
+      xr_tracer_error(tracer, estr.string);
+      xr_string_delete(&estr);
+    }
+    xr_close_pipe(error_pipe);
+    return _XR_TRACER_ERROR(tracer, "receiving listener of child %d failed.",
+                            fork_ret);
+  }
+  xr_close_pipe(error_pipe);
+
+  data->listener = listener;
+  data->epoll = epoll_create1(EPOLL_CLOEXEC);
+  struct epoll_event event = {
+    .events = EPOLLIN,
+    .data.u64 = XR_SECCOMP_EVENT_LISTENER,
+  };
+  if (data->epoll == -1 ||
+      epoll_ctl(data->epoll, EPOLL_CTL_ADD, listener, &event) == -1) {
+    kill(fork_ret, SIGKILL);
+    waitpid(fork_ret, NULL, __WALL);
+    return _XR_TRACER_ERROR(tracer, "seccomp_tracer epoll listener failed.");
+  }
+  // nothing traps a task spinning in user mode, time limits need a deadline.
+  unsigned long long left =
+    xr_seccomp_time_left(tracer->option, 0, (xr_time_t){0, 0});
+  if (left != ULLONG_MAX) {
+    data->timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    event.data.u64 = XR_SECCOMP_EVENT_TIMER;
+    if (data->timer == -1 ||
+        epoll_ctl(data->epoll, EPOLL_CTL_ADD, data->timer, &event) == -1 ||
+        xr_seccomp_tracer_arm(data, left) == false) {
+      kill(fork_ret, SIGKILL);
+      waitpid(fork_ret, NULL, __WALL);
+      return _XR_TRACER_ERROR(tracer, "seccomp_tracer arm deadline failed.");
+    }
+  }
+  xr_string_copy(&data->pwd, &entry->pwd);
+
+  xr_process_t *process = create_process(tracer, fork_ret);
+  if (process == NULL) {
+    kill(fork_ret, SIGKILL);
+    waitpid(fork_ret, NULL, __WALL);
+    return _XR_TRACER_ERROR(tracer, "seccomp create a process error.");
+  }
+  xr_thread_t *thread = xr_tracer_new_thread(tracer);
+  xr_thread_init(thread);
+  thread->tid = fork_ret;
+  xr_file_set_create(&thread->fset);
+  xr_fs_create(&thread->fs);
+  xr_string_copy(xr_fs_pwd(&thread->fs), &entry->pwd);
+  xr_process_add_thread(process, thread);
+  tracer->nthread++;
+  // child is trapped into its first execve, which should not be reported.
+  data->execve = fork_ret;
+  return true;
+}
+
+/**
+ * Convert syscall in notification into syscall of default abi.
+ *
+ * @sd seccomp data of notification
+ * @syscall output syscall number
+ * @nr output syscall number in table of compat mode
+ *
+ * @return compat mode of syscall
+ */
+static inline int xr_seccomp_syscall(struct seccomp_data *sd, long *syscall,
+                                     long *nr) {
+  *nr = sd->nr;
+#ifdef XR_ARCH_X86_64
+  if (sd->arch == AUDIT_ARCH_I386) {
+    *syscall = sd->nr >= 0 ? xr_syscall_x64_from_x86(sd->nr) : -1;
+    return XR_COMPAT_SYSCALL_X86_IA32;
+  } else if (sd->nr & XR_X32_MASK_BIT_SYSCALL) {
+    *syscall = *nr = xr_syscall_x64_from_x32(sd->nr);
+    return XR_COMPAT_SYSCALL_X86_X32;
+  }
+#endif
+  *syscall = sd->nr;
+  return XR_COMPAT_SYSCALL_DEFAULT;
+}
+
+static inline void xr_seccomp_tracer_push_exit(xr_tracer_seccomp_data_t *data,
+                                               xr_thread_t *thread,
+                                               int exit_code) {
+  if (data->nexit == data->cexit) {
+    data->cexit = XR_MAX(data->cexit * 2, 4);
+    data->exits = realloc(data->exits,
+                          sizeof(xr_tracer_seccomp_exit_t) * data->cexit);
+  }
+  data->exits[data->nexit].thread = thread;
+  data->exits[data->nexit].exit_code = exit_code;
+  data->nexit++;
+}
+
+/**
+ * Reap an exited process and report exit of its all threads.
+ *
+ * @@tracer
+ * @pid pid of exited process
+ */
+static inline void xr_seccomp_tracer_exited(xr_tracer_t *tracer, pid_t pid) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  xr_seccomp_tracer_unwatch(tracer, pid);
+  xr_process_t *process = xr_tracer_select_process(tracer, pid);
+  int status = 0, exit_code = 0;
+  struct rusage ru;
+  // sched and cpu clock of leader are gone once it is reaped.
+  if (process != NULL) {
+    xr_proc_nmigration(pid, &process->nmigration);
+    xr_proc_cpu_ns(pid, &process->cpu_ns);
+  }
+  // only our children and orphans can be reaped, others are left to parent.
+  if (wait4(pid, &status, WNOHANG | __WALL, &ru) == pid) {
+    exit_code = WIFSIGNALED(status) ? 128 + WTERMSIG(status)
+                                    : WEXITSTATUS(status);
+    if (process != NULL) {
+      process->time = xr_time_from_timeval(ru.ru_stime, ru.ru_utime);
+      process->memory = ru.ru_maxrss;
+    }
+  }
+  errno = 0;
+  if (process == NULL) {
+    // all threads have exited via exit syscall.
+    return;
+  }
+  xr_thread_t *thread;
+  _xr_list_for_each_entry(&process->threads, thread, xr_thread_t, threads) {
+    xr_seccomp_tracer_push_exit(data, thread, exit_code);
+  }
+}
+
+#define XR_SECCOMP_TRAP_ERROR -1
+#define XR_SECCOMP_TRAP_NONE 0
+#define XR_SECCOMP_TRAP_SYSCALL 1
+
+static inline int xr_seccomp_tracer_recv(xr_tracer_t *tracer,
+                                         xr_trace_trap_t *trap) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  struct seccomp_notif *notif = data->notif;
+  memset(notif, 0, data->sizes.seccomp_notif);
+  XR_STATS_BEGIN(tracer->stats, peek_start);
+  int received = ioctl(data->listener, SECCOMP_IOCTL_NOTIF_RECV, notif);
+  XR_STATS_END(tracer->stats, phases[XR_STATS_PEEK], peek_start);
+  if (received == -1) {
+    // task has been killed before receiving.
+    if (errno == ENOENT || errno == EINTR) {
+      errno = 0;
+      return XR_SECCOMP_TRAP_NONE;
+    }
+    _XR_TRACER_ERROR(tracer, "receiving seccomp notification failed.");
+    return XR_SECCOMP_TRAP_ERROR;
+  }
+
+  long syscall, nr;
+  int compat = xr_seccomp_syscall(&notif->data, &syscall, &nr);
+  if (notif->pid == data->execve) {
+    if (syscall == XR_SYSCALL_EXECVE || syscall == XR_SYSCALL_EXECVEAT) {
+      return xr_seccomp_tracer_reply(data, notif->id, 0)
+               ? XR_SECCOMP_TRAP_NONE
+               : XR_SECCOMP_TRAP_ERROR;
+    }
+    data->execve = 0;
+  }
+  // clone3 of other abi, native one fails in filter.
+  if (xr_tracer_is_clone3(syscall)) {
+    return xr_seccomp_tracer_reply(data, notif->id, -ENOSYS)
+             ? XR_SECCOMP_TRAP_NONE
+             : XR_SECCOMP_TRAP_ERROR;
+  }
+
+  // a task trapping again has left its clone.
+  if (data->nclone != 0) {
+    xr_seccomp_tracer_adopt(tracer, notif->pid);
+  }
+  xr_thread_t *thread = xr_tracer_select_thread(tracer, notif->pid);
+  if (thread == NULL) {
+    thread = xr_seccomp_tracer_attach(tracer, notif->pid);
+  }
+  if (thread == NULL) {
+    // task is gone before it could be attached.
+    if (ioctl(data->listener, SECCOMP_IOCTL_NOTIF_ID_VALID, &notif->id) ==
+        -1) {
+      errno = 0;
+      return XR_SECCOMP_TRAP_NONE;
+    }
+    _XR_TRACER_ERROR(tracer, "attaching new task %d failed.", notif->pid);
+    return XR_SECCOMP_TRAP_ERROR;
+  }
+
+  data->id = notif->id;
+  data->pid = notif->pid;
+  data->pending = true;
+  thread->syscall_status = XR_THREAD_CALLIN;
+  thread->process->compat = compat;
+  trap->trap = XR_TRACE_TRAP_SYSCALL;
+  trap->thread = thread;
+  trap->syscall_info.syscall = syscall;
+  trap->syscall_info.nr = nr;
+  for (int i = 0; i < 6; ++i) {
+    trap->syscall_info.args[i] = notif->data.args[i];
+  }
+  trap->syscall_info.retval = -ENOSYS;
+  data->clone = xr_tracer_take_clone_flags(tracer, trap);
+  return XR_SECCOMP_TRAP_SYSCALL;
+}
+
+bool xr_seccomp_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  trap->thread = NULL;
+  while (true) {
+    if (data->nexit != 0) {
+      data->nexit--;
+      trap->trap = XR_TRACE_TRAP_EXIT;
+      trap->thread = data->exits[data->nexit].thread;
+      trap->exit_code = data->exits[data->nexit].exit_code;
+      return true;
+    }
+
+    // children of clones are polled for until they are attached.
+    if (data->nclone != 0) {
+      xr_seccomp_tracer_adopt(tracer, 0);
+    }
+
+    if (xr_tracer_perf_trap(tracer, trap)) {
+      return true;
+    }
+    struct epoll_event event;
+    XR_STATS_BEGIN(tracer->stats, wait_start);
+    int nevent = epoll_wait(data->epoll, &event, 1, data->nclone ? 0 : -1);
+    XR_STATS_END(tracer->stats, phases[XR_STATS_WAIT], wait_start);
+    if (nevent == -1) {
+      if (errno == EINTR) {
+        errno = 0;
+        continue;
+      }
+      return _XR_TRACER_ERROR(tracer, "waiting seccomp events failed.");
+    } else if (nevent == 0) {
+      continue;
+    }
+
+    if (event.data.u64 == XR_SECCOMP_EVENT_TIMER) {
+      if (xr_seccomp_tracer_deadline(tracer, trap)) {
+        return true;
+      }
+    } else if (event.data.u64 != XR_SECCOMP_EVENT_LISTENER) {
+      xr_seccomp_tracer_exited(tracer, event.data.u64);
+    } else if (event.events & EPOLLIN) {
+      int trapped = xr_seccomp_tracer_recv(tracer, trap);
+      if (trapped == XR_SECCOMP_TRAP_ERROR) {
+        return false;
+      } else if (trapped == XR_SECCOMP_TRAP_SYSCALL) {
+        return true;
+      }
+    } else {
+      // no task is using filter any more, remaining exits come from pidfd.
+      epoll_ctl(data->epoll, EPOLL_CTL_DEL, data->listener, NULL);
+    }
+  }
+}
+
+bool xr_seccomp_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  xr_tracer_seccomp_data_t *data = xr_tracer_seccomp_data(tracer);
+  if (trap->trap == XR_TRACE_TRAP_SIGNAL) {
+    // deadline passed and no checker ended run, signal it as kernel does.
+    kill(trap->thread->process->pid, trap->stop_signal);
+    return true;
+  } else if (trap->trap != XR_TRACE_TRAP_SYSCALL) {
+    return true;
+  }
+  if (xr_seccomp_tracer_reply(data, data->id, 0) == false) {
+    return _XR_TRACER_ERROR(tracer, "continue syscall of task %d failed.",
+                            trap->thread->tid);
+  }
+  // child of a thread is a thread unless flags say otherwise.
+  if (data->clone && (trap->thread->clone_flags == XR_THREAD_CLONE_UNKNOWN ||
+                      (trap->thread->clone_flags & CLONE_THREAD) == 0)) {
+    if (data->nclone == data->cclone) {
+      data->cclone = XR_MAX(data->cclone * 2, 4);
+      data->clones = realloc(data->clones, sizeof(xr_tracer_seccomp_clone_t) *
+                                             data->cclone);
+    }
+    data->clones[data->nclone++] = (xr_tracer_seccomp_clone_t){
+      .tid = trap->thread->tid,
+      .tgid = trap->thread->process->pid,
+      .nr = data->notif->data.nr,
+      .flags = trap->thread->clone_flags,
+      .since = xr_time_now_ns(),
+    };
+  }
+  if (trap->syscall_info.syscall == XR_SYSCALL_EXIT) {
+    xr_seccomp_tracer_push_exit(data, trap->thread,
+                                trap->syscall_info.args[0]);
+  }
+  return true;
+}
+
+/**
+ * Memory of trapped task is trusted only if its notification is still
+ * valid, otherwise the task may have been killed and its pid reused.
+ *
+ * @data tracer data
+ * @pid pid of task
+ */
+static inline bool xr_seccomp_tracer_valid(xr_tracer_seccomp_data_t *data,
+                                           int pid) {
+  return pid != data->pid ||
+         ioctl(data->listener, SECCOMP_IOCTL_NOTIF_ID_VALID, &data->id) == 0;
+}
+
+bool xr_seccomp_tracer_get(xr_tracer_t *tracer, int pid, void *address,
+                           void *buffer, size_t size) {
+  XR_STATS_BEGIN(tracer->stats, start);
+  struct iovec local = {.iov_base = buffer, .iov_len = size};
+  struct iovec remote = {.iov_base = address, .iov_len = size};
+  if (process_vm_readv(pid, &local, 1, &remote, 1, 0) != size) {
+    return _XR_TRACER_ERROR(
+      tracer, "seccomp_tracer reading child %d data at %p failed.", pid,
+      address);
+  }
+  if (xr_seccomp_tracer_valid(xr_tracer_seccomp_data(tracer), pid) == false) {
+    return _XR_TRACER_ERROR(tracer, "notification of child %d is invalid.",
+                            pid);
+  }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
+  return true;
+}
+
+bool xr_seccomp_tracer_set(xr_tracer_t *tracer, int pid, void *address,
+                           const void *buffer, size_t size) {
+  XR_STATS_BEGIN(tracer->stats, start);
+  if (xr_seccomp_tracer_valid(xr_tracer_seccomp_data(tracer), pid) == false) {
+    return _XR_TRACER_ERROR(tracer, "notification of child %d is invalid.",
+                            pid);
+  }
+  struct iovec local = {.iov_base = (void *)buffer, .iov_len = size};
+  struct iovec remote = {.iov_base = address, .iov_len = size};
+  if (process_vm_writev(pid, &local, 1, &remote, 1, 0) != size) {
+    return _XR_TRACER_ERROR(
+      tracer, "seccomp_tracer writing child %d data at %p failed.", pid,
+      address);
+  }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
+  return true;
+}
+
+#define XR_SECCOMP_STRCPY_CHUNK 4096
+
+bool xr_seccomp_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                              xr_string_t *str) {
+  XR_STATS_BEGIN(tracer->stats, start);
+  str->length = 0;
+  uintptr_t addr = (uintptr_t)address;
+  while (true) {
+    // never read across a page, a fault at next page stops the whole read.
+    size_t need =
+      XR_SECCOMP_STRCPY_CHUNK - (addr & (XR_SECCOMP_STRCPY_CHUNK - 1));
+    if (str->capacity <= str->length + need) {
+      xr_string_grow(str,
+                     XR_MAX(str->capacity * 3 / 2, str->length + need + 1));
+    }
+    struct iovec local = {.iov_base = str->string + str->length,
+                          .iov_len = need};
+    struct iovec remote = {.iov_base = (void *)addr, .iov_len = need};
+    ssize_t nread = process_vm_readv(pid, &local, 1, &remote, 1, 0);
+    if (nread <= 0) {
+      return _XR_TRACER_ERROR(
+        tracer, "seccomp_tracer reading child %d data at %p failed.", pid,
+        (void *)addr);
+    }
+    char *term = memchr(local.iov_base, '\0', nread);
+    str->length += (term == NULL ? nread : term - (char *)local.iov_base);
+    if (term != NULL) {
+      break;
+    }
+    addr += nread;
+  }
+  str->string[str->length] = 0;
+  if (xr_seccomp_tracer_valid(xr_tracer_seccomp_data(tracer), pid) == false) {
+    return _XR_TRACER_ERROR(tracer, "notification of child %d is invalid.",
+                            pid);
+  }
+  XR_STATS_END(tracer->stats, phases[XR_STATS_MEMORY], start);
+  return true;
+}
+
+void xr_seccomp_tracer_kill(xr_tracer_t *tracer, pid_t pid) {
+  kill(pid, SIGKILL);
+}
+
+#else /* SECCOMP_RET_USER_NOTIF && __NR_pidfd_open */
+
+void xr_tracer_seccomp_init(xr_tracer_t *tracer, const char *name) {
+  xr_tracer_init(tracer, name);
+  tracer->spwan = xr_seccomp_tracer_spawn;
+  tracer->step = xr_seccomp_tracer_step;
+  tracer->trap = xr_seccomp_tracer_trap;
+  tracer->get = xr_seccomp_tracer_get;
+  tracer->set = xr_seccomp_tracer_set;
+  tracer->strcpy = xr_seccomp_tracer_strcpy;
+  tracer->kill = xr_seccomp_tracer_kill;
+  tracer->_delete = xr_seccomp_tracer_delete;
+  tracer->clean = xr_seccomp_tracer_clean;
+}
+
+bool xr_seccomp_tracer_spawn(xr_tracer_t *tracer, xr_entry_t *entry) {
+  return _XR_TRACER_ERROR(tracer, "seccomp user notification is unsupported.");
+}
+
+bool xr_seccomp_tracer_step(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  return false;
+}
+
+bool xr_seccomp_tracer_trap(xr_tracer_t *tracer, xr_trace_trap_t *trap) {
+  return false;
+}
+
+bool xr_seccomp_tracer_get(xr_tracer_t *tracer, int pid, void *address,
+                           void *buffer, size_t size) {
+  return false;
+}
+
+bool xr_seccomp_tracer_set(xr_tracer_t *tracer, int pid, void *address,
+                           const void *buffer, size_t size) {
+  return false;
+}
+
+bool xr_seccomp_tracer_strcpy(xr_tracer_t *tracer, int pid, void *address,
+                              xr_string_t *str) {
+  return false;
+}
+
+void xr_seccomp_tracer_kill(xr_tracer_t *tracer, pid_t pid) {}
+
+void xr_seccomp_tracer_clean(xr_tracer_t *tracer) {}
+
+void xr_seccomp_tracer_delete(xr_tracer_t *tracer) {}
+
+#endif /* SECCOMP_RET_USER_NOTIF && __NR_pidfd_open */
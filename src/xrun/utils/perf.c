@@ -0,0 +1,100 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "xrun/utils/perf.h"
+
+static int xr_perf_open_counter(pid_t pid, unsigned type,
+                                unsigned long long config, bool user,
+                                unsigned long long limit, pid_t owner,
+                                int signal) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.inherit = 1;
+  attr.exclude_kernel = user;
+  attr.exclude_hv = user;
+  if (limit != XR_PERF_UNLIMITED) {
+    attr.sample_period = limit;
+  }
+  int fd = syscall(SYS_perf_event_open, &attr, pid, -1, -1,
+                   PERF_FLAG_FD_CLOEXEC);
+  // kernel mode is only counted for privileged callers, as
+  // perf_event_paranoid says.
+  if (fd == -1 && errno == EACCES && user == false) {
+    attr.exclude_kernel = attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, pid, -1, -1,
+                 PERF_FLAG_FD_CLOEXEC);
+  }
+  if (fd == -1 || limit == XR_PERF_UNLIMITED) {
+    return fd;
+  }
+  // overflow of counter, or of any inherited one, signals owner thread.
+  struct f_owner_ex ex = {.type = F_OWNER_TID, .pid = owner};
+  if (fcntl(fd, F_SETOWN_EX, &ex) == -1 ||
+      fcntl(fd, F_SETSIG, signal) == -1 ||
+      fcntl(fd, F_SETFL, O_ASYNC) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool xr_perf_open(xr_perf_t *perf, pid_t pid, const xr_perf_count_t *limit,
+                  pid_t owner, int signal) {
+  perf->task_clock =
+    xr_perf_open_counter(pid, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK,
+                         false, limit->task_clock, owner, signal);
+  if (perf->task_clock == -1) {
+    return false;
+  }
+  // instructions of kernel mode depend on what else kernel is doing.
+  perf->instructions =
+    xr_perf_open_counter(pid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS,
+                         true, limit->instructions, owner, signal);
+  if (perf->instructions == -1 &&
+      limit->instructions != XR_PERF_UNLIMITED) {
+    xr_perf_close(perf);
+    return false;
+  }
+  errno = 0;
+  return true;
+}
+
+static inline unsigned long long xr_perf_read_counter(int fd) {
+  unsigned long long count;
+  if (fd == -1 || read(fd, &count, sizeof(count)) != sizeof(count)) {
+    return XR_PERF_UNAVAILABLE;
+  }
+  return count;
+}
+
+void xr_perf_read(xr_perf_t *perf, xr_perf_count_t *count) {
+  count->task_clock = xr_perf_read_counter(perf->task_clock);
+  count->instructions = xr_perf_read_counter(perf->instructions);
+}
+
+bool xr_perf_exceeded(const xr_perf_count_t *count,
+                      const xr_perf_count_t *limit) {
+  return (count->task_clock != XR_PERF_UNAVAILABLE &&
+          count->task_clock > limit->task_clock) ||
+         (count->instructions != XR_PERF_UNAVAILABLE &&
+          count->instructions > limit->instructions);
+}
+
+void xr_perf_close(xr_perf_t *perf) {
+  if (perf->task_clock != -1) {
+    close(perf->task_clock);
+  }
+  if (perf->instructions != -1) {
+    close(perf->instructions);
+  }
+  xr_perf_init(perf);
+}
@@ -0,0 +1,172 @@
+#define _GNU_SOURCE
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xrun/utils/proc.h"
+
+#define XR_PROC_BUFFER_SIZE 2048
+
+static inline ssize_t xr_proc_read(pid_t pid, const char *name, char *buffer,
+                                   size_t size) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/%s", pid, name);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return -1;
+  }
+  ssize_t nread = read(fd, buffer, size - 1);
+  close(fd);
+  if (nread >= 0) {
+    buffer[nread] = '\0';
+  }
+  return nread;
+}
+
+bool xr_proc_sample(pid_t pid, xr_time_t *time, int *memory) {
+  static long ticks = 0;
+  if (ticks <= 0) {
+    ticks = sysconf(_SC_CLK_TCK);
+  }
+  char buffer[XR_PROC_BUFFER_SIZE];
+  if (xr_proc_read(pid, "stat", buffer, sizeof(buffer)) <= 0) {
+    return false;
+  }
+  // comm may contain spaces and parentheses, fields restart after last ')'.
+  char *fields = strrchr(buffer, ')');
+  unsigned long utime = 0, stime = 0;
+  if (fields == NULL ||
+      sscanf(fields + 1,
+             " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime,
+             &stime) != 2) {
+    return false;
+  }
+  time->user_time = utime * 1000 / ticks;
+  time->sys_time = stime * 1000 / ticks;
+
+  if (xr_proc_read(pid, "status", buffer, sizeof(buffer)) <= 0) {
+    return false;
+  }
+  // a zombie leader of live threads has no memory, keep the last sample.
+  char *hwm = strstr(buffer, "VmHWM:");
+  if (hwm != NULL) {
+    *memory = atoi(hwm + strlen("VmHWM:"));
+  }
+  return true;
+}
+
+bool xr_proc_cpu_ns(pid_t pid, unsigned long long *ns) {
+  clockid_t clock;
+  struct timespec ts;
+  if (clock_getcpuclockid(pid, &clock) == 0 &&
+      clock_gettime(clock, &ts) == 0) {
+    *ns = ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    return true;
+  }
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task", pid);
+  DIR *dir = opendir(path);
+  if (dir == NULL) {
+    return false;
+  }
+  // first field of schedstat is time on cpu in ns.
+  unsigned long long total = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    char buffer[128], name[32];
+    // entries are tids, which keeps name short.
+    pid_t tid = atoi(entry->d_name);
+    if (tid <= 0) {
+      continue;
+    }
+    snprintf(name, sizeof(name), "task/%d/schedstat", tid);
+    if (xr_proc_read(pid, name, buffer, sizeof(buffer)) > 0) {
+      total += strtoull(buffer, NULL, 10);
+    }
+  }
+  closedir(dir);
+  *ns = total;
+  return true;
+}
+
+bool xr_proc_nmigration(pid_t tid, long *nmigration) {
+  char buffer[XR_PROC_BUFFER_SIZE];
+  if (xr_proc_read(tid, "sched", buffer, sizeof(buffer)) <= 0) {
+    return false;
+  }
+  char *field = strstr(buffer, "se.nr_migrations");
+  if (field != NULL && (field = strchr(field, ':')) != NULL) {
+    *nmigration = atol(field + 1);
+  }
+  return true;
+}
+
+bool xr_proc_syscall(pid_t tid, long *nr) {
+  char buffer[256];
+  if (xr_proc_read(tid, "syscall", buffer, sizeof(buffer)) <= 0 ||
+      strncmp(buffer, "running", strlen("running")) == 0) {
+    return false;
+  }
+  *nr = strtol(buffer, NULL, 10);
+  return true;
+}
+
+bool xr_proc_tracer(pid_t tid, pid_t *tracer) {
+  char buffer[XR_PROC_BUFFER_SIZE];
+  if (xr_proc_read(tid, "status", buffer, sizeof(buffer)) <= 0) {
+    return false;
+  }
+  char *field = strstr(buffer, "TracerPid:");
+  *tracer = field != NULL ? atoi(field + strlen("TracerPid:")) : 0;
+  return true;
+}
+
+static inline void xr_proc_push_pid(pid_t **pids, int *capacity, int n,
+                                    pid_t pid) {
+  if (n == *capacity) {
+    *capacity = *capacity == 0 ? 16 : *capacity * 2;
+    *pids = realloc(*pids, sizeof(pid_t) * *capacity);
+  }
+  (*pids)[n] = pid;
+}
+
+int xr_proc_children(pid_t tid, pid_t **pids, int *capacity) {
+  char path[64];
+  snprintf(path, sizeof(path), "/proc/%d/task/%d/children", tid, tid);
+  FILE *file = fopen(path, "re");
+  if (file == NULL) {
+    return -1;
+  }
+  int n = 0;
+  pid_t pid;
+  while (fscanf(file, "%d", &pid) == 1) {
+    xr_proc_push_pid(pids, capacity, n++, pid);
+  }
+  fclose(file);
+  return n;
+}
+
+bool xr_proc_steal_ns(unsigned long long *ns) {
+  static long ticks = 0;
+  if (ticks <= 0) {
+    ticks = sysconf(_SC_CLK_TCK);
+  }
+  FILE *file = fopen("/proc/stat", "re");
+  if (file == NULL) {
+    return false;
+  }
+  // first line sums up all cpus, steal is its 8th field in ticks.
+  unsigned long long steal;
+  int nread = fscanf(file, "cpu %*u %*u %*u %*u %*u %*u %*u %llu", &steal);
+  fclose(file);
+  if (nread != 1) {
+    return false;
+  }
+  *ns = steal * (1000000000ull / ticks);
+  return true;
+}
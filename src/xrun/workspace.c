@@ -0,0 +1,245 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "xrun/utils/utils.h"
+#include "xrun/workspace.h"
+
+#define XR_WORKSPACE_MOUNT_FLAGS (MS_NOSUID | MS_NODEV)
+
+static inline bool xr_workspace_mkdir(const char *path) {
+  return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+static bool xr_workspace_mount(xr_workspace_t *workspace) {
+  xr_workspace_pool_t *pool = workspace->pool;
+  // only tracees, which run as caller, may enter workspace.
+  char options[96];
+  int n = snprintf(options, sizeof(options), "mode=0700,uid=%u,gid=%u",
+                   (unsigned)pool->uid, (unsigned)pool->gid);
+  if (pool->quota != 0) {
+    snprintf(options + n, sizeof(options) - n, ",size=%zu", pool->quota);
+  }
+  if (mount("tmpfs", workspace->mount.string, "tmpfs",
+            XR_WORKSPACE_MOUNT_FLAGS, options) == -1) {
+    return false;
+  }
+  if (pool->lower.length == 0) {
+    return true;
+  }
+  xr_path_t dir;
+  xr_string_zero(&dir);
+  const char *const dirs[] = {"upper", "work", "merged"};
+  bool ok = true;
+  for (int i = 0; ok && i < 3; ++i) {
+    xr_string_format(&dir, "%s/%s", workspace->mount.string, dirs[i]);
+    ok = mkdir(dir.string, 0700) == 0;
+  }
+  if (ok) {
+    xr_string_format(&dir, "lowerdir=%s,upperdir=%s/upper,workdir=%s/work",
+                     pool->lower.string, workspace->mount.string,
+                     workspace->mount.string);
+    ok = mount("overlay", workspace->path.string, "overlay",
+               XR_WORKSPACE_MOUNT_FLAGS, dir.string) == 0;
+  }
+  xr_path_delete(&dir);
+  if (ok == false) {
+    umount2(workspace->mount.string, MNT_DETACH);
+  }
+  return ok;
+}
+
+// files in a tmpfs are freed once it is unmounted.
+static inline void xr_workspace_umount(xr_workspace_t *workspace) {
+  if (workspace->pool->lower.length != 0) {
+    umount2(workspace->path.string, MNT_DETACH);
+  }
+  umount2(workspace->mount.string, MNT_DETACH);
+}
+
+static void xr_workspace_destroy(xr_workspace_t *workspace) {
+  xr_workspace_umount(workspace);
+  rmdir(workspace->mount.string);
+  xr_path_delete(&workspace->mount);
+  xr_path_delete(&workspace->path);
+  free(workspace);
+}
+
+static xr_workspace_t *xr_workspace_build(xr_workspace_pool_t *pool) {
+  xr_workspace_t *workspace = _XR_NEW(xr_workspace_t);
+  workspace->id = pool->nworkspace++;
+  workspace->pool = pool;
+  xr_string_zero(&workspace->mount);
+  xr_string_zero(&workspace->path);
+  xr_string_format(&workspace->mount, "%s/%u", pool->base.string,
+                   workspace->id);
+  if (pool->lower.length == 0) {
+    xr_string_copy(&workspace->path, &workspace->mount);
+  } else {
+    xr_string_format(&workspace->path, "%s/merged", workspace->mount.string);
+  }
+  if (xr_workspace_mkdir(workspace->mount.string) == false ||
+      xr_workspace_mount(workspace) == false) {
+    rmdir(workspace->mount.string);
+    xr_path_delete(&workspace->mount);
+    xr_path_delete(&workspace->path);
+    free(workspace);
+    return NULL;
+  }
+  return workspace;
+}
+
+// reset drops a used workspace, and mounts an empty one at the same path.
+static inline xr_workspace_t *xr_workspace_reset(xr_workspace_t *workspace) {
+  xr_workspace_umount(workspace);
+  if (xr_workspace_mount(workspace) == false) {
+    xr_workspace_destroy(workspace);
+    return NULL;
+  }
+  return workspace;
+}
+
+static void *xr_workspace_pool_main(void *arg) {
+  xr_workspace_pool_t *pool = arg;
+  struct sched_param param = {.sched_priority = 0};
+  sched_setscheduler(0, SCHED_IDLE, &param);
+  pthread_mutex_lock(&pool->lock);
+  while (pool->stop == false) {
+    if (pool->failed == false &&
+        pool->nready < pool->nwarm + pool->nwaiting) {
+      // used workspaces are reset before new ones are mounted.
+      xr_list_t *used = NULL;
+      if (xr_list_empty(&pool->used) == false) {
+        used = pool->used.next;
+        xr_list_del(used);
+      }
+      pthread_mutex_unlock(&pool->lock);
+      xr_workspace_t *workspace =
+        used ? xr_workspace_reset(
+                 xr_list_entry(used, xr_workspace_t, workspaces))
+             : xr_workspace_build(pool);
+      pthread_mutex_lock(&pool->lock);
+      if (workspace != NULL) {
+        xr_list_add(&pool->warm, &workspace->workspaces);
+        pool->nready++;
+      } else if (used == NULL) {
+        pool->failed = true;
+      }
+      pthread_cond_broadcast(&pool->ready);
+    } else if (xr_list_empty(&pool->used) == false) {
+      // more workspaces than nwarm are not kept.
+      xr_list_t *used = pool->used.next;
+      xr_list_del(used);
+      pthread_mutex_unlock(&pool->lock);
+      xr_workspace_destroy(xr_list_entry(used, xr_workspace_t, workspaces));
+      pthread_mutex_lock(&pool->lock);
+    } else {
+      pthread_cond_wait(&pool->dirty, &pool->lock);
+    }
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+bool xr_workspace_pool_init(xr_workspace_pool_t *pool, const char *base,
+                            const char *lower, size_t quota, size_t nwarm) {
+  memset(pool, 0, sizeof(xr_workspace_pool_t));
+  pool->quota = quota;
+  pool->nwarm = nwarm;
+  pool->uid = geteuid();
+  pool->gid = getegid();
+  xr_list_init(&pool->warm);
+  xr_list_init(&pool->used);
+  // access lists take absolute paths without symbolic links.
+  char path[PATH_MAX];
+  if (xr_workspace_mkdir(base) == false || realpath(base, path) == NULL) {
+    return false;
+  }
+  xr_string_concat_raw(&pool->base, path, strlen(path));
+  if (lower != NULL) {
+    if (realpath(lower, path) == NULL) {
+      goto xr_workspace_pool_init_failed;
+    }
+    xr_string_concat_raw(&pool->lower, path, strlen(path));
+  }
+  if (mount(pool->base.string, pool->base.string, NULL, MS_BIND, NULL) ==
+      -1) {
+    goto xr_workspace_pool_init_failed;
+  }
+  if (mount(NULL, pool->base.string, NULL, MS_SHARED, NULL) == -1) {
+    umount2(pool->base.string, MNT_DETACH);
+    goto xr_workspace_pool_init_failed;
+  }
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->ready, NULL);
+  pthread_cond_init(&pool->dirty, NULL);
+  if (pthread_create(&pool->thread, NULL, xr_workspace_pool_main, pool) !=
+      0) {
+    umount2(pool->base.string, MNT_DETACH);
+    goto xr_workspace_pool_init_failed;
+  }
+  return true;
+
+xr_workspace_pool_init_failed:
+  xr_path_delete(&pool->base);
+  xr_path_delete(&pool->lower);
+  return false;
+}
+
+xr_workspace_t *xr_workspace_pool_take(xr_workspace_pool_t *pool) {
+  xr_workspace_t *workspace = NULL;
+  pthread_mutex_lock(&pool->lock);
+  while (pool->nready == 0 && pool->failed == false) {
+    pool->nwaiting++;
+    pthread_cond_signal(&pool->dirty);
+    pthread_cond_wait(&pool->ready, &pool->lock);
+    pool->nwaiting--;
+  }
+  if (pool->nready != 0) {
+    xr_list_t *warm = pool->warm.next;
+    xr_list_del(warm);
+    pool->nready--;
+    workspace = xr_list_entry(warm, xr_workspace_t, workspaces);
+    pthread_cond_signal(&pool->dirty);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return workspace;
+}
+
+void xr_workspace_pool_put(xr_workspace_pool_t *pool,
+                           xr_workspace_t *workspace) {
+  pthread_mutex_lock(&pool->lock);
+  xr_list_add(&pool->used, &workspace->workspaces);
+  pthread_cond_signal(&pool->dirty);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void xr_workspace_pool_delete(xr_workspace_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  pthread_cond_signal(&pool->dirty);
+  pthread_mutex_unlock(&pool->lock);
+  pthread_join(pool->thread, NULL);
+  xr_list_t *lists[] = {&pool->warm, &pool->used};
+  for (int i = 0; i < 2; ++i) {
+    xr_list_t *cur, *temp;
+    _xr_list_for_each_safe(lists[i], cur, temp) {
+      xr_list_del(cur);
+      xr_workspace_destroy(xr_list_entry(cur, xr_workspace_t, workspaces));
+    }
+  }
+  umount2(pool->base.string, MNT_DETACH);
+  pthread_cond_destroy(&pool->dirty);
+  pthread_cond_destroy(&pool->ready);
+  pthread_mutex_destroy(&pool->lock);
+  xr_path_delete(&pool->base);
+  xr_path_delete(&pool->lower);
+}
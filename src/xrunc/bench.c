@@ -0,0 +1,380 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "xrun/calls.h"
+#include "xrun/result.h"
+#include "xrun/utils/perf.h"
+#include "xrun/utils/proc.h"
+
+#include "xrunc/bench.h"
+#include "xrunc/stats.h"
+
+#define XRN_BENCH_TOP_CALLS 10
+
+enum xrn_bench_metric_e {
+  XRN_BENCH_WALL,
+  XRN_BENCH_USER,
+  XRN_BENCH_SYS,
+  XRN_BENCH_CPU,
+  XRN_BENCH_RSS,
+  XRN_BENCH_CSW,
+  XRN_BENCH_MIGRATION,
+  XRN_BENCH_FAULTS,
+  XRN_BENCH_TRACER_CSW,
+  XRN_BENCH_TRACER_MIGRATION,
+  XRN_BENCH_TASK_CLOCK,
+  XRN_BENCH_INSTRUCTIONS,
+  XRN_BENCH_NMETRIC,
+};
+
+static const char *const xrn_bench_metric_names[XRN_BENCH_NMETRIC] = {
+  [XRN_BENCH_WALL] = "wall (ms)",
+  [XRN_BENCH_USER] = "user (ms)",
+  [XRN_BENCH_SYS] = "sys (ms)",
+  [XRN_BENCH_CPU] = "cpu (ms)",
+  [XRN_BENCH_RSS] = "rss (KB)",
+  [XRN_BENCH_CSW] = "csw",
+  [XRN_BENCH_MIGRATION] = "migrations",
+  [XRN_BENCH_FAULTS] = "faults",
+  [XRN_BENCH_TRACER_CSW] = "tracer csw",
+  [XRN_BENCH_TRACER_MIGRATION] = "tracer mig",
+  [XRN_BENCH_TASK_CLOCK] = "task (ms)",
+  [XRN_BENCH_INSTRUCTIONS] = "insns (M)",
+};
+
+static inline double xrn_bench_now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static inline double xrn_bench_timeval_ms(struct timeval tv) {
+  return tv.tv_sec * 1e3 + tv.tv_usec / 1e3;
+}
+
+// counts of perf_event counters, 0 for those which are not available.
+static inline void xrn_bench_perf_metrics(const xr_perf_count_t *count,
+                                          double *metrics) {
+  metrics[XRN_BENCH_TASK_CLOCK] = count->task_clock == XR_PERF_UNAVAILABLE
+                                    ? 0
+                                    : count->task_clock / 1e6;
+  metrics[XRN_BENCH_INSTRUCTIONS] = count->instructions == XR_PERF_UNAVAILABLE
+                                      ? 0
+                                      : count->instructions / 1e6;
+}
+
+static bool xrn_bench_native(xr_entry_t *entry, double *metrics,
+                             xr_string_t *error) {
+  // child waits for counters to be opened before execve, as tracers do.
+  int gate[2];
+  if (pipe2(gate, O_CLOEXEC) == -1) {
+    xr_string_format(error, "pipe for native run failed.");
+    return false;
+  }
+  double start = xrn_bench_now_ms();
+  pid_t pid = fork();
+  if (pid == 0) {
+    char c;
+    close(gate[1]);
+    read(gate[0], &c, 1);
+    xr_entry_execve(entry);
+    _exit(127);
+  } else if (pid == -1) {
+    close(gate[0]);
+    close(gate[1]);
+    xr_string_format(error, "fork for native run failed.");
+    return false;
+  }
+  xr_perf_t perf;
+  xr_perf_init(&perf);
+  xr_perf_count_t unlimited = {XR_PERF_UNLIMITED, XR_PERF_UNLIMITED};
+  xr_perf_open(&perf, pid, &unlimited, 0, 0);
+  close(gate[0]);
+  close(gate[1]);
+  // sched of native run is read before it is reaped, as tracers do.
+  siginfo_t info;
+  long nmigration = 0;
+  if (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) == 0) {
+    xr_proc_nmigration(pid, &nmigration);
+  }
+  int status = 0;
+  struct rusage ru;
+  if (wait4(pid, &status, 0, &ru) != pid) {
+    xr_perf_close(&perf);
+    xr_string_format(error, "wait for native run failed.");
+    return false;
+  }
+  metrics[XRN_BENCH_WALL] = xrn_bench_now_ms() - start;
+  // rusage sums up the whole tree in us, as cpu_ns of a traced run does.
+  metrics[XRN_BENCH_USER] = xrn_bench_timeval_ms(ru.ru_utime);
+  metrics[XRN_BENCH_SYS] = xrn_bench_timeval_ms(ru.ru_stime);
+  metrics[XRN_BENCH_CPU] = metrics[XRN_BENCH_USER] + metrics[XRN_BENCH_SYS];
+  metrics[XRN_BENCH_RSS] = ru.ru_maxrss;
+  metrics[XRN_BENCH_CSW] = ru.ru_nvcsw + ru.ru_nivcsw;
+  metrics[XRN_BENCH_MIGRATION] = nmigration;
+  metrics[XRN_BENCH_FAULTS] = ru.ru_minflt + ru.ru_majflt;
+  metrics[XRN_BENCH_TRACER_CSW] = metrics[XRN_BENCH_TRACER_MIGRATION] = 0;
+  xr_perf_count_t count;
+  xr_perf_read(&perf, &count);
+  xr_perf_close(&perf);
+  xrn_bench_perf_metrics(&count, metrics);
+  return true;
+}
+
+static void xrn_bench_result_metrics(xr_result_t *result, double *metrics) {
+  // like maxrss of native run, the largest process.
+  metrics[XRN_BENCH_RSS] = 0;
+  for (xr_tracer_process_result_t *p = result->exited_processes; p != NULL;
+       p = p->next) {
+    if (p->memory > metrics[XRN_BENCH_RSS]) {
+      metrics[XRN_BENCH_RSS] = p->memory;
+    }
+  }
+  // user and sys time are rusage of the reaped tree, as in native run. cpu
+  // time sums up processes from scheduler in ns.
+  metrics[XRN_BENCH_USER] = result->sched.user_ns / 1e6;
+  metrics[XRN_BENCH_SYS] = result->sched.sys_ns / 1e6;
+  metrics[XRN_BENCH_CPU] = result->cpu_ns / 1e6;
+  metrics[XRN_BENCH_CSW] = result->sched.nvcsw + result->sched.nivcsw;
+  metrics[XRN_BENCH_MIGRATION] = result->sched.nmigration;
+  metrics[XRN_BENCH_FAULTS] = result->sched.nminflt + result->sched.nmajflt;
+  metrics[XRN_BENCH_TRACER_CSW] =
+    result->tracer_sched.nvcsw + result->tracer_sched.nivcsw;
+  metrics[XRN_BENCH_TRACER_MIGRATION] = result->tracer_sched.nmigration;
+  xrn_bench_perf_metrics(&result->perf, metrics);
+}
+
+static bool xrn_bench_traced(xr_tracer_t *tracer, xr_entry_t *entry,
+                             double *metrics, unsigned long *ntrap,
+                             unsigned long *ntrap_calls, xr_string_t *error) {
+  xr_result_t result;
+  xr_result_init(&result);
+  result.ntrap_calls = ntrap_calls;
+  double start = xrn_bench_now_ms();
+  bool ok = xr_tracer_trace(tracer, entry, &result);
+  metrics[XRN_BENCH_WALL] = xrn_bench_now_ms() - start;
+  if (ok == false) {
+    xr_error_tostring(&tracer->error, error);
+  } else if (result.status != XR_RESULT_OK) {
+    ok = false;
+    xr_string_format(error,
+                     "traced run stopped with status %d, run it without "
+                     "bench to see why.",
+                     result.status);
+  }
+  xrn_bench_result_metrics(&result, metrics);
+  *ntrap = result.ntrap;
+  xr_result_delete(&result);
+  return ok;
+}
+
+static void xrn_bench_print_calls(unsigned long *ntrap_calls, long nrun) {
+  int top[XRN_BENCH_TOP_CALLS];
+  int ntop = 0;
+  for (int call = 0; call < XR_SYSCALL_MAX; ++call) {
+    if (ntrap_calls[call] == 0) {
+      continue;
+    }
+    int i = ntop < XRN_BENCH_TOP_CALLS ? ntop++ : XRN_BENCH_TOP_CALLS;
+    while (i > 0 && ntrap_calls[top[i - 1]] < ntrap_calls[call]) {
+      if (i < XRN_BENCH_TOP_CALLS) {
+        top[i] = top[i - 1];
+      }
+      --i;
+    }
+    if (i < XRN_BENCH_TOP_CALLS) {
+      top[i] = call;
+    }
+  }
+  if (ntop == 0) {
+    return;
+  }
+  printf("\nstops per run of top syscalls:\n");
+  for (int i = 0; i < ntop; ++i) {
+    const char *name = XR_CALLS_NAME(top[i], XR_COMPAT_SYSCALL_DEFAULT);
+    printf("  %-24s %12.1f\n", name ? name : "unknown",
+           (double)ntrap_calls[top[i]] / nrun);
+  }
+}
+
+static void xrn_bench_print(double *samples[2][XRN_BENCH_NMETRIC],
+                            double *stops, unsigned long *ntrap_calls,
+                            long nrun) {
+  printf("%-10s %24s %24s  %s\n", "", "native", "traced",
+         "traced/native [95% CI]");
+  for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+    xrn_stats_t native, traced;
+    xrn_stats_compute(&native, samples[0][m], nrun);
+    xrn_stats_compute(&traced, samples[1][m], nrun);
+    printf("%-10s %12.3f +- %-8.3f %12.3f +- %-8.3f", xrn_bench_metric_names[m],
+           native.mean, xrn_stats_ci95(&native), traced.mean,
+           xrn_stats_ci95(&traced));
+    double lo, hi;
+    if (native.mean != 0) {
+      double ratio = xrn_stats_ratio_ci95(&traced, &native, &lo, &hi);
+      printf("  %.3f [%.3f, %.3f]\n", ratio, lo, hi);
+    } else {
+      printf("  -\n");
+    }
+  }
+  xrn_stats_t nstop;
+  xrn_stats_compute(&nstop, stops, nrun);
+  printf("%-10s %24s %12.1f +- %.1f\n", "stops", "-", nstop.mean,
+         xrn_stats_ci95(&nstop));
+  xrn_bench_print_calls(ntrap_calls, nrun);
+}
+
+bool xrn_bench(xr_tracer_t *tracer, xr_entry_t *entry,
+               const xrn_repeat_t *repeat, xr_string_t *error) {
+  long nrun = repeat->nrun;
+  double *samples[2][XRN_BENCH_NMETRIC];
+  for (int mode = 0; mode < 2; ++mode) {
+    for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+      samples[mode][m] = calloc(nrun, sizeof(double));
+    }
+  }
+  double *stops = calloc(nrun, sizeof(double));
+  unsigned long *ntrap_calls = calloc(XR_SYSCALL_MAX, sizeof(unsigned long));
+
+  bool ok = true;
+  double metrics[XRN_BENCH_NMETRIC];
+  unsigned long ntrap = 0;
+  for (long r = 0; r < repeat->warmup && ok; ++r) {
+    ok = xrn_bench_native(entry, metrics, error) &&
+         xrn_bench_traced(tracer, entry, metrics, &ntrap, NULL, error);
+  }
+  // run by turns, so that drift of machine affects both modes alike.
+  for (long r = 0; r < nrun && ok; ++r) {
+    ok = xrn_bench_native(entry, metrics, error);
+    for (int m = 0; m < XRN_BENCH_NMETRIC && ok; ++m) {
+      samples[0][m][r] = metrics[m];
+    }
+    ok = ok && xrn_bench_traced(tracer, entry, metrics, &ntrap, ntrap_calls,
+                                error);
+    for (int m = 0; m < XRN_BENCH_NMETRIC && ok; ++m) {
+      samples[1][m][r] = metrics[m];
+    }
+    stops[r] = ntrap;
+  }
+  if (ok) {
+    printf("bench %s with %ld runs of each mode:\n", entry->path.string, nrun);
+    xrn_bench_print(samples, stops, ntrap_calls, nrun);
+  }
+
+  free(ntrap_calls);
+  free(stops);
+  for (int mode = 0; mode < 2; ++mode) {
+    for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+      free(samples[mode][m]);
+    }
+  }
+  return ok;
+}
+
+static void xrn_repeat_print(double *samples[XRN_BENCH_NMETRIC], long nrun,
+                             const xrn_repeat_t *repeat) {
+  xrn_stats_t stats[XRN_BENCH_NMETRIC];
+  printf("summary of %ld runs after %ld warm-up runs:\n", nrun,
+         repeat->warmup);
+  printf("%-10s %10s %10s %10s %10s %10s %10s\n", "", "min", "median", "p90",
+         "p99", "mean", "stddev");
+  for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+    xrn_stats_compute(&stats[m], samples[m], nrun);
+    printf("%-10s %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+           xrn_bench_metric_names[m], stats[m].min, stats[m].median,
+           stats[m].p90, stats[m].p99, stats[m].mean, stats[m].stddev);
+  }
+
+  int noutlier = 0;
+  for (long r = 0; r < nrun; ++r) {
+    int nmetric = 0;
+    for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+      if (xrn_stats_outlier(&stats[m], samples[m][r]) == false) {
+        continue;
+      }
+      if (nmetric++ == 0) {
+        printf("outlier: run %ld, %s", r + 1, xrn_bench_metric_names[m]);
+      } else {
+        printf(", %s", xrn_bench_metric_names[m]);
+      }
+    }
+    if (nmetric != 0) {
+      printf("\n");
+      noutlier++;
+    }
+  }
+  if (noutlier == 0) {
+    printf("outlier: none\n");
+  }
+
+  if (repeat->stable > 0) {
+    double cv = xrn_stats_cv(&stats[XRN_BENCH_CPU]);
+    printf("cv of cpu time: %.4f, %s than %.4f.\n", cv,
+           cv < repeat->stable ? "less" : "still no less", repeat->stable);
+  }
+}
+
+void xrn_repeat(xr_tracer_t *tracer, xr_entry_t *entry,
+                const xrn_repeat_t *repeat, xrn_repeat_report_f *report,
+                void *ctx) {
+  xr_result_t result;
+  for (long r = 0; r < repeat->warmup; ++r) {
+    xr_result_init(&result);
+    xr_tracer_trace(tracer, entry, &result);
+    xr_result_delete(&result);
+  }
+
+  long capacity = repeat->nrun;
+  if (repeat->stable > 0 && capacity < XRN_REPEAT_STABLE_MAX) {
+    capacity = XRN_REPEAT_STABLE_MAX;
+  }
+  double *samples[XRN_BENCH_NMETRIC];
+  for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+    samples[m] = calloc(capacity, sizeof(double));
+  }
+
+  long nrun = 0;
+  for (long r = 0; r < capacity; ++r) {
+    if (r >= repeat->nrun) {
+      xrn_stats_t cpu;
+      xrn_stats_compute(&cpu, samples[XRN_BENCH_CPU], nrun);
+      if (xrn_stats_cv(&cpu) < repeat->stable) {
+        break;
+      }
+    }
+    xr_result_init(&result);
+    if (repeat->profile != NULL) {
+      memset(repeat->profile, 0, sizeof(xr_result_call_t) * XR_RESULT_NPROFILE);
+      result.profile = repeat->profile;
+    }
+    double metrics[XRN_BENCH_NMETRIC];
+    double start = xrn_bench_now_ms();
+    bool traced = xr_tracer_trace(tracer, entry, &result);
+    metrics[XRN_BENCH_WALL] = xrn_bench_now_ms() - start;
+    report(tracer, &result, traced, ctx);
+    // a run failed by tracer measures nothing.
+    if (traced) {
+      xrn_bench_result_metrics(&result, metrics);
+      for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+        samples[m][nrun] = metrics[m];
+      }
+      nrun++;
+    }
+    xr_result_delete(&result);
+  }
+
+  if (nrun > 1) {
+    xrn_repeat_print(samples, nrun, repeat);
+  }
+  for (int m = 0; m < XRN_BENCH_NMETRIC; ++m) {
+    free(samples[m]);
+  }
+}
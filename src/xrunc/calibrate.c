@@ -0,0 +1,89 @@
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "xrun/checkers.h"
+#include "xrun/entry.h"
+#include "xrun/option.h"
+#include "xrun/tracers/ptrace/tracer.h"
+#include "xrun/tracers/seccomp/tracer.h"
+
+#include "xrunc/calibrate.h"
+
+extern char **environ;
+
+int xrn_calibration_tracee() {
+  for (int i = 0; i < XRN_CALIBRATION_NCALL; ++i) {
+    int fd = openat(AT_FDCWD, "/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+      return 1;
+    }
+    close(fd);
+  }
+  return 0;
+}
+
+bool xrn_calibrate(xr_tracer_t *tracer, bool seccomp, xr_string_t *error) {
+  char path[PATH_MAX];
+  ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+  if (length == -1) {
+    xr_string_format(error, "can not find xrun for calibration.");
+    return false;
+  }
+  path[length] = '\0';
+
+  xr_option_t option;
+  xr_option_init(&option);
+  for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
+    option.calls[i] = true;
+  }
+  xr_access_list_append(&option.files, "/", 1, ~0L,
+                        XR_ACCESS_MODE_FLAG_CONTAINS);
+  xr_access_list_append(&option.directories, "/", 1, ~0L,
+                        XR_ACCESS_MODE_FLAG_CONTAINS);
+  // stops cost what they cost in runs, on the same cpus.
+  option.placement = tracer->option->placement;
+  xr_option_default(&option);
+
+  char *argv[] = {path, XRN_CALIBRATION_TRACEE, NULL};
+  xr_entry_t entry;
+  memset(&entry, 0, sizeof(xr_entry_t));
+  xr_entry_init(&entry);
+  xr_string_concat_raw(&entry.path, path, length);
+  xr_string_copy(&entry.root, &xr_path_slash);
+  xr_string_copy(&entry.pwd, &xr_path_slash);
+  for (int i = 0; i < 3; ++i) {
+    entry.stdio[i] = i;
+  }
+  entry.argv = argv;
+  entry.environs = environ;
+
+  xr_tracer_t calibration;
+  if (seccomp) {
+    xr_tracer_seccomp_init(&calibration, "xrunc_calibration");
+  } else {
+    xr_tracer_ptrace_init(&calibration, "xrunc_calibration");
+  }
+  xr_checker_id_t checkers[5] = {XR_CHECKER_FILE, XR_CHECKER_RESOURCE,
+                                 XR_CHECKER_IO, XR_CHECKER_FORK,
+                                 XR_CHECKER_SYSCALL};
+  bool ok = true;
+  for (int i = 0; ok && i < 5; ++i) {
+    ok = xr_tracer_add_checker(&calibration, checkers[i]);
+  }
+  ok = ok && xr_tracer_setup(&calibration, &option) &&
+       xr_tracer_calibrate(&calibration, &entry);
+  if (ok) {
+    tracer->stop_ns = calibration.stop_ns;
+  } else {
+    xr_error_tostring(&calibration.error, error);
+  }
+  xr_tracer_delete(&calibration);
+  xr_entry_delete(&entry);
+  xr_option_delete(&option);
+  return ok;
+}
@@ -114,8 +114,8 @@ bool xrn_config_parse_calls(xr_json_t *entries, bool *calls,
     if (XR_JSON_IS_INTEGER(call)) {
       v = XR_JSON_INTEGER(call);
     } else if (XR_JSON_IS_STRING(call)) {
-      // TODO: compat dectect.
-      v = XR_CALLS_CONVERT(_XR_JSON_STRING(call), 1);
+      v = XR_CALLS_CONVERT(_XR_JSON_STRING(call),
+                           XR_COMPAT_SYSCALL_DEFAULT);
     } else {
       xr_string_format(error, "config.calls[%d] is not a string or number.", i);
       return false;
@@ -161,6 +161,15 @@ bool xrn_config_parse(const char *config_path, xr_option_t *option,
     }
   }
 
+  xr_json_t *landlock = xr_json_get(cfg_json, "s", "landlock");
+  if (landlock) {
+    if (!XR_JSON_IS_TRUE(landlock) && !XR_JSON_IS_FALSE(landlock)) {
+      xr_string_format(error, "config.landlock is not a boolean.");
+      return __xrn_parse_failed(cfg_json);
+    }
+    option->landlock = option->landlock || XR_JSON_IS_TRUE(landlock);
+  }
+
   xr_json_t *calls = xr_json_get(cfg_json, "s", "calls");
   if (calls) {
     if (xrn_config_parse_calls(calls, option->calls, error) == false) {
@@ -229,6 +238,34 @@ bool xrn_config_parse(const char *config_path, xr_option_t *option,
     XRN_CONFIG_SIGN_IF_ZERO(option->limit_per_process.time.user_time, v);
   }
 
+  xr_json_t *cpu_ns = xr_json_get(cfg_json, "s", "cpu_ns");
+  if (cpu_ns) {
+    if (!XR_JSON_IS_INTEGER(cpu_ns)) {
+      xr_string_format(error, "config.cpu_ns is not a number.");
+      return __xrn_parse_failed(cfg_json);
+    }
+    long long v = XR_JSON_INTEGER(cpu_ns);
+    if (v <= 0) {
+      xr_string_format(error, "config.cpu_ns must be greater than 0.");
+      return __xrn_parse_failed(cfg_json);
+    }
+    XRN_CONFIG_SIGN_IF_ZERO(option->limit.perf.task_clock, v);
+  }
+
+  xr_json_t *instructions = xr_json_get(cfg_json, "s", "instructions");
+  if (instructions) {
+    if (!XR_JSON_IS_INTEGER(instructions)) {
+      xr_string_format(error, "config.instructions is not a number.");
+      return __xrn_parse_failed(cfg_json);
+    }
+    long long v = XR_JSON_INTEGER(instructions);
+    if (v <= 0) {
+      xr_string_format(error, "config.instructions must be greater than 0.");
+      return __xrn_parse_failed(cfg_json);
+    }
+    XRN_CONFIG_SIGN_IF_ZERO(option->limit.perf.instructions, v);
+  }
+
   xr_json_t *thread = xr_json_get(cfg_json, "s", "thread");
   if (thread) {
     if (!XR_JSON_IS_INTEGER(thread)) {
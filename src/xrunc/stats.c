@@ -0,0 +1,130 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "xrunc/stats.h"
+
+// t(0.975, df) for df from 1 to 30, larger df use normal distribution.
+static const double xrn_stats_t95_table[] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+#define XRN_STATS_T95_TABLE_SIZE \
+  (sizeof(xrn_stats_t95_table) / sizeof(double))
+
+#define XRN_STATS_OUTLIER_Z 3.5
+
+static int xrn_stats_cmp(const void *lhs, const void *rhs) {
+  double l = *(const double *)lhs, r = *(const double *)rhs;
+  return l < r ? -1 : (l > r ? 1 : 0);
+}
+
+// percentile of sorted samples with linear interpolation.
+static double xrn_stats_percentile(const double *sorted, size_t n, double p) {
+  double rank = p * (n - 1);
+  size_t lo = (size_t)rank;
+  if (lo + 1 >= n) {
+    return sorted[n - 1];
+  }
+  return sorted[lo] + (rank - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+static void xrn_stats_order(xrn_stats_t *stats, const double *samples,
+                            size_t n) {
+  double *sorted = malloc(sizeof(double) * n);
+  memcpy(sorted, samples, sizeof(double) * n);
+  qsort(sorted, n, sizeof(double), xrn_stats_cmp);
+  stats->median = xrn_stats_percentile(sorted, n, 0.5);
+  stats->p90 = xrn_stats_percentile(sorted, n, 0.9);
+  stats->p99 = xrn_stats_percentile(sorted, n, 0.99);
+  for (size_t i = 0; i < n; ++i) {
+    sorted[i] = fabs(samples[i] - stats->median);
+    stats->meanad += sorted[i] / n;
+  }
+  qsort(sorted, n, sizeof(double), xrn_stats_cmp);
+  stats->mad = xrn_stats_percentile(sorted, n, 0.5);
+  free(sorted);
+}
+
+void xrn_stats_compute(xrn_stats_t *stats, const double *samples, size_t n) {
+  memset(stats, 0, sizeof(xrn_stats_t));
+  stats->n = n;
+  if (n == 0) {
+    return;
+  }
+  xrn_stats_order(stats, samples, n);
+  double sum = 0;
+  stats->min = stats->max = samples[0];
+  for (size_t i = 0; i < n; ++i) {
+    sum += samples[i];
+    if (samples[i] < stats->min) {
+      stats->min = samples[i];
+    }
+    if (samples[i] > stats->max) {
+      stats->max = samples[i];
+    }
+  }
+  stats->mean = sum / n;
+  if (n == 1) {
+    return;
+  }
+  double var = 0;
+  for (size_t i = 0; i < n; ++i) {
+    var += (samples[i] - stats->mean) * (samples[i] - stats->mean);
+  }
+  stats->stddev = sqrt(var / (n - 1));
+}
+
+double xrn_stats_cv(const xrn_stats_t *stats) {
+  return stats->mean == 0 ? 0 : stats->stddev / fabs(stats->mean);
+}
+
+bool xrn_stats_outlier(const xrn_stats_t *stats, double sample) {
+  double z = 0, dev = fabs(sample - stats->median);
+  if (stats->mad != 0) {
+    z = 0.6745 * dev / stats->mad;
+  } else if (stats->meanad != 0) {
+    // more than half of samples are the same, e.g. cpu time in ms of a short
+    // program. scale mean absolute deviation instead.
+    z = dev / (1.253314 * stats->meanad);
+  }
+  return z > XRN_STATS_OUTLIER_Z;
+}
+
+double xrn_stats_t95(size_t df) {
+  if (df == 0) {
+    return INFINITY;
+  }
+  return df <= XRN_STATS_T95_TABLE_SIZE ? xrn_stats_t95_table[df - 1] : 1.960;
+}
+
+double xrn_stats_ci95(const xrn_stats_t *stats) {
+  if (stats->n < 2) {
+    return 0;
+  }
+  return xrn_stats_t95(stats->n - 1) * stats->stddev / sqrt(stats->n);
+}
+
+double xrn_stats_ratio_ci95(const xrn_stats_t *num, const xrn_stats_t *den,
+                            double *lo, double *hi) {
+  *lo = *hi = 0;
+  if (den->mean == 0) {
+    return 0;
+  }
+  double ratio = num->mean / den->mean;
+  double rel = 0;
+  if (num->mean != 0 && num->n != 0) {
+    rel += num->stddev * num->stddev / (num->n * num->mean * num->mean);
+  }
+  if (den->n != 0) {
+    rel += den->stddev * den->stddev / (den->n * den->mean * den->mean);
+  }
+  // conservative degrees of freedom of the smaller sample.
+  size_t n = num->n < den->n ? num->n : den->n;
+  double half = n < 2 ? 0 : xrn_stats_t95(n - 1) * ratio * sqrt(rel);
+  *lo = ratio - half;
+  *hi = ratio + half;
+  return ratio;
+}
@@ -1,22 +1,41 @@
 #include <stdio.h>
+#include <string.h>
 
 #include <getopt.h>
 #include <unistd.h>
 
 #include "xrun/calls.h"
+#include "xrun/capture.h"
 #include "xrun/checkers.h"
 #include "xrun/entry.h"
+#include "xrun/placement.h"
+#include "xrun/recorder.h"
 #include "xrun/result.h"
+#include "xrun/sandbox.h"
+#include "xrun/stats.h"
 #include "xrun/tracer.h"
 #include "xrun/tracers/ptrace/tracer.h"
+#include "xrun/tracers/replay/tracer.h"
+#include "xrun/tracers/seccomp/tracer.h"
+#include "xrun/workspace.h"
 
 #include "xrunc/access.h"
+#include "xrunc/bench.h"
+#include "xrunc/calibrate.h"
 #include "xrunc/config.h"
 #include "xrunc/option.h"
 
 extern char **environ;
 
 #define XRN_GLOBAL_OPTION_SLOT_SIZE 128
+// records dumped after a denied or failed run by default.
+#define XRN_RECORDS_DEFAULT 16
+
+enum xrn_profile_format_e {
+  XRN_PROFILE_NONE,
+  XRN_PROFILE_TEXT,
+  XRN_PROFILE_JSON,
+};
 
 struct xrn_global_config_set_s {
   char *config_path;
@@ -24,7 +43,25 @@ struct xrn_global_config_set_s {
   xr_option_t option;
   xr_entry_t entry;
   xr_string_t error;
-  long run;
+  xrn_repeat_t repeat;
+  bool seccomp;
+  bool bench;
+  bool stats;
+  // sandboxes kept ready, -1 if tracees are not isolated.
+  long sandbox;
+  // base of workspaces, NULL if tracees run in cwd.
+  char *workspace;
+  size_t quota;
+  // records dumped after each run, -1 for XRN_RECORDS_DEFAULT after denied or
+  // failed runs only.
+  long records;
+  // file runs are captured into, and capture which is replayed instead of
+  // running program, NULL if not given.
+  char *capture;
+  char *replay;
+  // a replayed run ended otherwise than its capture.
+  bool diverged;
+  enum xrn_profile_format_e profile;
 };
 typedef struct xrn_global_config_set_s xrn_global_config_set_t;
 
@@ -32,7 +69,21 @@ void xrn_global_option_set_init(xrn_global_config_set_t *cfg) {
   cfg->config_path = NULL;
   cfg->version = false;
   cfg->help = false;
-  cfg->run = 1;
+  cfg->repeat.nrun = 1;
+  cfg->repeat.warmup = 0;
+  cfg->repeat.stable = 0;
+  cfg->repeat.profile = NULL;
+  cfg->seccomp = false;
+  cfg->bench = false;
+  cfg->stats = false;
+  cfg->sandbox = -1;
+  cfg->workspace = NULL;
+  cfg->quota = 0;
+  cfg->records = -1;
+  cfg->capture = NULL;
+  cfg->replay = NULL;
+  cfg->diverged = false;
+  cfg->profile = XRN_PROFILE_NONE;
   xr_string_zero(&cfg->error);
 
   xr_option_t *xropt = &cfg->option;
@@ -43,6 +94,7 @@ void xrn_global_option_set_init(xrn_global_config_set_t *cfg) {
 }
 
 void xrn_global_option_set_delete(xrn_global_config_set_t *cfg) {
+  free(cfg->repeat.profile);
   xr_string_delete(&cfg->error);
   xr_option_delete(&cfg->option);
   xr_entry_delete(&cfg->entry);
@@ -74,11 +126,14 @@ bool xrn_set_call(char *arg, void *ctx) {
   xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
   char *endptr = NULL;
   long call = strtol(arg, &endptr, 10);
-  if (*endptr != '\0' || call <= 0 || call >= XR_SYSCALL_MAX) {
-    xr_string_format(
-      &cfg->error,
-      "--call must be a valid number between 0 to %d instead of \"%s\".\n",
-      XR_SYSCALL_MAX, arg);
+  if (endptr == arg || *endptr != '\0') {
+    call = XR_CALLS_CONVERT(arg, XR_COMPAT_SYSCALL_DEFAULT);
+  }
+  if (call < 0 || call >= XR_SYSCALL_MAX) {
+    xr_string_format(&cfg->error,
+                     "--call must be a syscall name or a number between 0 to "
+                     "%d instead of \"%s\".\n",
+                     XR_SYSCALL_MAX, arg);
     return false;
   }
   cfg->option.calls[call] = true;
@@ -97,6 +152,12 @@ bool xrn_set_dir_entry(char *arg, void *ctx) {
   return true;
 }
 
+bool xrn_set_landlock(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->option.landlock = true;
+  return true;
+}
+
 bool xrn_set_memory(char *arg, void *ctx) {
   xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
   char *endptr = NULL;
@@ -131,6 +192,48 @@ bool xrn_set_time(char *arg, void *ctx) {
   return true;
 }
 
+bool xrn_set_cpu_ns(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long long ns = strtoll(arg, &endptr, 10);
+  if (*endptr != '\0' || ns <= 0) {
+    xr_string_format(&cfg->error,
+                     "--cpu-ns must be a valid number which is greater than 0 "
+                     "instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->option.limit.perf.task_clock = ns;
+  return true;
+}
+
+bool xrn_set_instructions(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long long n = strtoll(arg, &endptr, 10);
+  if (*endptr != '\0' || n <= 0) {
+    xr_string_format(&cfg->error,
+                     "--instructions must be a valid number which is greater "
+                     "than 0 instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->option.limit.perf.instructions = n;
+  return true;
+}
+
+bool xrn_set_perf(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->option.perf = true;
+  return true;
+}
+
+bool xrn_set_compensate(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->option.compensate = true;
+  return true;
+}
+
 bool xrn_set_nfile(char *arg, void *ctx) {
   xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
   char *endptr = NULL;
@@ -193,7 +296,222 @@ bool xrn_set_nrun(char *arg, void *ctx) {
                      arg);
     return false;
   }
-  cfg->run = run;
+  cfg->repeat.nrun = run;
+  return true;
+}
+
+bool xrn_set_warmup(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long warmup = strtol(arg, &endptr, 10);
+  if (*endptr != '\0' || warmup < 0) {
+    xr_string_format(&cfg->error,
+                     "--warmup must be a valid number which is not less than "
+                     "0 instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->repeat.warmup = warmup;
+  return true;
+}
+
+bool xrn_set_stable(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  double stable = strtod(arg, &endptr);
+  if (*endptr != '\0' || stable <= 0 || stable >= 1) {
+    xr_string_format(&cfg->error,
+                     "--stable must be a coefficient of variation between 0 "
+                     "and 1 instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->repeat.stable = stable;
+  return true;
+}
+
+bool xrn_set_records(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long records = strtol(arg, &endptr, 10);
+  if (*endptr != '\0' || records < 0 || records > XR_RECORDER_NRECORD) {
+    xr_string_format(&cfg->error,
+                     "--records must be a valid number between 0 and %d "
+                     "instead of \"%s\".\n",
+                     XR_RECORDER_NRECORD, arg);
+    return false;
+  }
+  cfg->records = records;
+  return true;
+}
+
+bool xrn_set_capture(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->capture = arg;
+  return true;
+}
+
+bool xrn_set_replay(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->replay = arg;
+  return true;
+}
+
+bool xrn_set_stats(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->stats = true;
+  return true;
+}
+
+bool xrn_set_sandbox(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long sandbox = strtol(arg, &endptr, 10);
+  if (*endptr != '\0' || sandbox < 0) {
+    xr_string_format(&cfg->error,
+                     "--sandbox must be a valid number which is not less than "
+                     "0 instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->sandbox = sandbox;
+  return true;
+}
+
+bool xrn_set_workspace(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->workspace = arg;
+  return true;
+}
+
+bool xrn_set_quota(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long quota = strtol(arg, &endptr, 10);
+  if (*endptr != '\0' || quota <= 0) {
+    xr_string_format(&cfg->error,
+                     "--quota must be a valid number which is greater than 0 "
+                     "instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  cfg->quota = quota;
+  return true;
+}
+
+bool xrn_set_placement(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  if (strcmp(arg, "siblings") == 0) {
+    cfg->option.placement.mode = XR_PLACEMENT_SIBLINGS;
+  } else if (strcmp(arg, "exclusive") == 0) {
+    cfg->option.placement.mode = XR_PLACEMENT_EXCLUSIVE;
+  } else {
+    xr_string_format(
+      &cfg->error,
+      "--placement must be siblings or exclusive instead of \"%s\".\n", arg);
+    return false;
+  }
+  return true;
+}
+
+bool xrn_set_cpus(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  if (xr_cpus_parse(&cfg->option.placement.cpus, arg) == false ||
+      xr_cpus_empty(&cfg->option.placement.cpus)) {
+    xr_string_format(&cfg->error,
+                     "--cpus must be a cpu list like 0-3,8 instead of "
+                     "\"%s\".\n",
+                     arg);
+    return false;
+  }
+  return true;
+}
+
+bool xrn_set_ncpu(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  char *endptr = NULL;
+  long ncpu = strtol(arg, &endptr, 10);
+  if (*endptr != '\0' || ncpu <= 0 || ncpu > XR_PLACEMENT_MAXCPU) {
+    xr_string_format(&cfg->error,
+                     "--ncpu must be a valid number between 1 and %d instead "
+                     "of \"%s\".\n",
+                     XR_PLACEMENT_MAXCPU, arg);
+    return false;
+  }
+  cfg->option.placement.ncpu = ncpu;
+  return true;
+}
+
+bool xrn_set_noise(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  xr_noise_t *noise = &cfg->option.noise;
+  char *value = strchr(arg, ':'), *endptr = NULL;
+  long long n = value == NULL ? -1 : strtoll(value + 1, &endptr, 10);
+  if (n <= 0 || *endptr != '\0') {
+    goto xrn_set_noise_failed;
+  }
+  *value = '\0';
+  if (strcmp(arg, "csw") == 0) {
+    noise->nivcsw = n;
+  } else if (strcmp(arg, "migrations") == 0) {
+    noise->nmigration = n;
+  } else if (strcmp(arg, "faults") == 0) {
+    noise->nmajflt = n;
+  } else if (strcmp(arg, "steal") == 0) {
+    noise->steal_ns = n * 1000000ull;
+  } else {
+    *value = ':';
+    goto xrn_set_noise_failed;
+  }
+  return true;
+
+xrn_set_noise_failed:
+  xr_string_format(&cfg->error,
+                   "--noise must be csw, migrations, faults or steal with a "
+                   "number greater than 0 like csw:100 instead of \"%s\".\n",
+                   arg);
+  return false;
+}
+
+bool xrn_set_fifo(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->option.placement.fifo = true;
+  return true;
+}
+
+bool xrn_set_numa(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  cfg->option.placement.numa = true;
+  return true;
+}
+
+bool xrn_set_profile(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  if (strcmp(arg, "text") == 0) {
+    cfg->profile = XRN_PROFILE_TEXT;
+  } else if (strcmp(arg, "json") == 0) {
+    cfg->profile = XRN_PROFILE_JSON;
+  } else {
+    xr_string_format(&cfg->error,
+                     "--profile must be text or json instead of \"%s\".\n",
+                     arg);
+    return false;
+  }
+  return true;
+}
+
+bool xrn_set_tracer(char *arg, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  if (strcmp(arg, "ptrace") == 0) {
+    cfg->seccomp = false;
+  } else if (strcmp(arg, "seccomp") == 0) {
+    cfg->seccomp = true;
+  } else {
+    xr_string_format(
+      &cfg->error, "--tracer must be ptrace or seccomp instead of \"%s\".\n",
+      arg);
+    return false;
+  }
   return true;
 }
 
@@ -235,6 +553,17 @@ xrn_option_t options[] = {
     NULL,
     xrn_set_help,
   },
+  {
+    {"landlock", no_argument, NULL, 'L'},
+    "Enforce files and directories with landlock if kernel supports it. "
+    "Tracer stops checking opens only if landlock can enforce every entry "
+    "exactly, which are directories in containing mode with all flags but "
+    "access mode. Needs ptrace tracer, which sees denials of landlock on "
+    "syscall exit.",
+    NULL,
+    NULL,
+    xrn_set_landlock,
+  },
   {
     {"memory", required_argument, NULL, 'm'},
     "Memory limitation in byte.",
@@ -263,6 +592,38 @@ xrn_option_t options[] = {
     "N",
     xrn_set_time,
   },
+  {
+    {"cpu-ns", required_argument, NULL, 'k'},
+    "Cpu time limitation of all tracees in ns, counted by a task-clock "
+    "perf_event counter.",
+    NULL,
+    "N",
+    xrn_set_cpu_ns,
+  },
+  {
+    {"instructions", required_argument, NULL, 'i'},
+    "Limitation of user mode instructions all tracees retire, counted by a "
+    "perf_event counter. Needs a PMU.",
+    NULL,
+    "N",
+    xrn_set_instructions,
+  },
+  {
+    {"perf", no_argument, NULL, 'e'},
+    "Count cpu time and instructions of tracees with perf_event counters "
+    "and print them after each run.",
+    NULL,
+    NULL,
+    xrn_set_perf,
+  },
+  {
+    {"compensate", no_argument, NULL, 'o'},
+    "Calibrate cpu time each stop of tracer costs, then check time limits "
+    "against cpu time less cost of stops.",
+    NULL,
+    NULL,
+    xrn_set_compensate,
+  },
   {
     {"thread", required_argument, NULL, 'T'},
     "Thread number limitation.",
@@ -272,11 +633,150 @@ xrn_option_t options[] = {
   },
   {
     {"nrun", required_argument, NULL, 'r'},
-    "run entry with N times.",
+    "run entry with N times. In `xrun bench`, runs of each mode, 10 by "
+    "default.",
     NULL,
     "N",
     xrn_set_nrun,
   },
+  {
+    {"warmup", required_argument, NULL, 'w'},
+    "Run entry N times before runs which are measured.",
+    "0",
+    "N",
+    xrn_set_warmup,
+  },
+  {
+    {"stable", required_argument, NULL, 's'},
+    "Keep running after --nrun runs until coefficient of variation of cpu "
+    "time is less than CV, at most 200 runs.",
+    NULL,
+    "CV",
+    xrn_set_stable,
+  },
+  {
+    {"profile", required_argument, NULL, 'P'},
+    "Print count, latency from entry to exit and tracer time of each syscall "
+    "after each run, in a table or a json line. Latency is not available "
+    "with seccomp tracer.",
+    NULL,
+    "text|json",
+    xrn_set_profile,
+  },
+  {
+    {"sandbox", required_argument, NULL, 'N'},
+    "Run tracees in mount, ipc, net, uts and pid namespaces (user namespace "
+    "instead of pid one for non-root), taken from a pool which keeps N "
+    "sandboxes ready ahead of runs.",
+    NULL,
+    "N",
+    xrn_set_sandbox,
+  },
+  {
+    {"workspace", required_argument, NULL, 'W'},
+    "Run tracees in an empty tmpfs under DIR instead of cwd, which is allowed "
+    "in access lists and dropped after each run. Needs root.",
+    NULL,
+    "DIR",
+    xrn_set_workspace,
+  },
+  {
+    {"quota", required_argument, NULL, 'Q'},
+    "Size limitation of workspace in byte.",
+    NULL,
+    "N",
+    xrn_set_quota,
+  },
+  {
+    {"placement", required_argument, NULL, 'A'},
+    "Pin tracer and tracees to the core tracer runs on and its SMT siblings, "
+    "or to --ncpu cpus of --cpus held by this run only, which concurrent "
+    "xruns skip.",
+    NULL,
+    "siblings|exclusive",
+    xrn_set_placement,
+  },
+  {
+    {"cpus", required_argument, NULL, 'U'},
+    "Cpus exclusive placement takes from, all allowed cpus by default.",
+    NULL,
+    "LIST",
+    xrn_set_cpus,
+  },
+  {
+    {"ncpu", required_argument, NULL, 'K'},
+    "Cpus of each run with exclusive placement.",
+    "1",
+    "N",
+    xrn_set_ncpu,
+  },
+  {
+    {"fifo", no_argument, NULL, 'F'},
+    "Run tracer at lowest SCHED_FIFO priority during runs, tracees keep "
+    "normal policy. Needs CAP_SYS_NICE or RLIMIT_RTPRIO.",
+    NULL,
+    NULL,
+    xrn_set_fifo,
+  },
+  {
+    {"numa", no_argument, NULL, 'M'},
+    "Allocate memory of tracees from NUMA nodes of their cpus only.",
+    NULL,
+    NULL,
+    xrn_set_numa,
+  },
+  {
+    {"noise", required_argument, NULL, 'z'},
+    "Flag runs beyond N involuntary context switches, migrations or major "
+    "page faults of tracees, or N ms of steal time of host as noisy. Can be "
+    "given once for each kind.",
+    NULL,
+    "KIND:N",
+    xrn_set_noise,
+  },
+  {
+    {"records", required_argument, NULL, 'R'},
+    "Dump last N traps of each run with verdicts of checkers. By default "
+    "last 16 ones are dumped after denied or failed runs only.",
+    NULL,
+    "N",
+    xrn_set_records,
+  },
+  {
+    {"capture", required_argument, NULL, 'O'},
+    "Capture traps of runs and tracee memory checkers read into PATH, which "
+    "--replay feeds to checkers again.",
+    NULL,
+    "PATH",
+    xrn_set_capture,
+  },
+  {
+    {"replay", required_argument, NULL, 'Y'},
+    "Replay runs captured in PATH one by one through checkers instead of "
+    "running program, which may be omitted. Time and memory of tracees are "
+    "not replayed.",
+    NULL,
+    "PATH",
+    xrn_set_replay,
+  },
+  {
+    {"stats", no_argument, NULL, 'S'},
+    "Print latency of tracer stages, checkers and syscalls in ns after all "
+    "runs. Requires xrun configured with --enable-stats.",
+    NULL,
+    NULL,
+    xrn_set_stats,
+  },
+  {
+    {"tracer", required_argument, NULL, 'x'},
+    "Tracer backend. seccomp traps forbidden and checked syscalls on entry "
+    "only, hence io limits and file records are not available. Its path "
+    "checks are advisory, since a tracee can change a path after it is "
+    "checked, and --landlock is not available.",
+    "ptrace",
+    "ptrace|seccomp",
+    xrn_set_tracer,
+  },
   {
     {"version", no_argument, NULL, 'v'},
     "version information of xrun.",
@@ -313,7 +813,8 @@ static inline void xrn_print_trace_result(xr_result_t *result) {
     p = p->next;
   }
   if (result->status == XR_RESULT_OK) {
-    printf("Run %d processes with %d threads.\n", nprocess, nthread);
+    printf("Run %d processes with %d threads in %llu ns of cpu time.\n",
+           nprocess, nthread, result->cpu_ns);
     return;
   }
   p = result->aborted_processes;
@@ -324,6 +825,12 @@ static inline void xrn_print_trace_result(xr_result_t *result) {
   }
   switch (result->status) {
     case XR_RESULT_TIMEOUT: {
+      // perf limits are on all tasks, which may be caught after they exit.
+      if (result->perf.task_clock != XR_PERF_UNAVAILABLE) {
+        printf("Timeout: Tasks have been run %llu ns in total.\n",
+               result->perf.task_clock);
+        break;
+      }
       printf("Timeout: Task %d has been run %lu ms.\n", result->epid,
              result->error_process.time.user_time);
       break;
@@ -359,8 +866,11 @@ static inline void xrn_print_trace_result(xr_result_t *result) {
       break;
     }
     case XR_RESULT_PATHDENY: {
-      printf("Path is forbidden: Task %d try to access %s with flags %ld.\n",
-             result->epid, result->epath.string, result->eflags);
+      printf(
+        "Path is forbidden: Task %d try to access %s with flags %ld (denied "
+        "by %s).\n",
+        result->epid, result->epath.string, result->eflags,
+        result->ebackend == XR_RESULT_BACKEND_LANDLOCK ? "landlock" : "tracer");
       break;
     }
     case XR_RESULT_WRITEOUT: {
@@ -376,10 +886,227 @@ static inline void xrn_print_trace_result(xr_result_t *result) {
   }
 }
 
+static const char *const xrn_stats_phase_names[XR_STATS_NPHASE] = {
+  [XR_STATS_TRAP] = "trap",     [XR_STATS_WAIT] = "wait",
+  [XR_STATS_PEEK] = "peek",     [XR_STATS_MEMORY] = "memory",
+  [XR_STATS_CHECK] = "check",   [XR_STATS_STEP] = "step",
+  [XR_STATS_TEARDOWN] = "teardown",
+};
+
+static const char *const xrn_stats_checker_names[XR_STATS_NCHECKER] = {
+  [XR_CHECKER_FILE] = "file",         [XR_CHECKER_FORK] = "fork",
+  [XR_CHECKER_SYSCALL] = "syscall",   [XR_CHECKER_RESOURCE] = "resource",
+  [XR_CHECKER_IO] = "io",
+};
+
+static inline void xrn_print_stats_hist(const char *kind, const char *name,
+                                        const xr_stats_hist_t *hist) {
+  if (hist->count == 0) {
+    return;
+  }
+  printf("%-8s %-16s %10lu %14llu %10llu %10llu %10llu %10llu\n", kind, name,
+         hist->count, hist->total, hist->total / hist->count,
+         xr_stats_hist_quantile(hist, 0.5), xr_stats_hist_quantile(hist, 0.99),
+         hist->max);
+}
+
+static inline void xrn_print_stats(xr_stats_t *stats) {
+  printf("%-8s %-16s %10s %14s %10s %10s %10s %10s\n", "kind", "name",
+         "count", "total", "mean", "p50", "p99", "max");
+  for (int i = 0; i < XR_STATS_NPHASE; ++i) {
+    xrn_print_stats_hist("stage", xrn_stats_phase_names[i], &stats->phases[i]);
+  }
+  for (int i = 0; i < XR_STATS_NCHECKER; ++i) {
+    xrn_print_stats_hist("checker", xrn_stats_checker_names[i],
+                         &stats->checkers[i]);
+  }
+  for (int i = 0; i < XR_SYSCALL_MAX; ++i) {
+    char number[16];
+    const char *name = XR_CALLS_NAME(i, XR_COMPAT_SYSCALL_DEFAULT);
+    if (name == NULL) {
+      snprintf(number, sizeof(number), "%d", i);
+      name = number;
+    }
+    xrn_print_stats_hist("syscall", name, &stats->calls[i]);
+  }
+}
+
+static inline void xrn_print_profile(xr_result_call_t *profile,
+                                     enum xrn_profile_format_e format) {
+  bool first = true;
+  if (format == XRN_PROFILE_JSON) {
+    printf("{\"profile\": [");
+  } else {
+    printf("%-8s %-20s %10s %14s %12s %14s\n", "abi", "syscall", "count",
+           "total (us)", "max (us)", "tracer (us)");
+  }
+  for (int i = 0; i < XR_RESULT_NPROFILE; ++i) {
+    xr_result_call_t *call = &profile[i];
+    if (call->count == 0) {
+      continue;
+    }
+    int call_nr = i % XR_SYSCALL_MAX;
+    // syscall numbers of all abis are converted to default one.
+    const char *abi = XR_CALLS_COMPAT_NAME(i / XR_SYSCALL_MAX),
+               *name = XR_CALLS_NAME(call_nr, XR_COMPAT_SYSCALL_DEFAULT);
+    if (format == XRN_PROFILE_JSON) {
+      printf(
+        "%s{\"abi\": \"%s\", \"nr\": %d, \"syscall\": \"%s\", "
+        "\"count\": %lu, \"total_ns\": %llu, \"max_ns\": %llu, "
+        "\"tracer_ns\": %llu}",
+        first ? "" : ", ", abi, call_nr, name ? name : "", call->count,
+        call->total, call->max, call->tracer);
+    } else {
+      printf("%-8s %-20s %10lu %14.3f %12.3f %14.3f\n", abi,
+             name ? name : "unknown", call->count, call->total / 1e3,
+             call->max / 1e3, call->tracer / 1e3);
+    }
+    first = false;
+  }
+  if (format == XRN_PROFILE_JSON) {
+    printf("]}\n");
+  }
+}
+
+static const char *const xrn_checker_names[] = {
+  [XR_CHECKER_FILE] = "file",         [XR_CHECKER_FORK] = "fork",
+  [XR_CHECKER_SYSCALL] = "syscall",   [XR_CHECKER_RESOURCE] = "resource",
+  [XR_CHECKER_IO] = "io",
+};
+
+static inline void xrn_print_records(xr_tracer_t *tracer, xr_result_t *result,
+                                     long n) {
+  xr_record_t records[XR_RECORDER_NRECORD];
+  if (n > result->nrecord) {
+    n = result->nrecord;
+  }
+  size_t nrecord = xr_recorder_last(&tracer->recorder, records, n);
+  printf("Last %zu of %lu traps:\n", nrecord, result->nrecord);
+  for (size_t i = 0; i < nrecord; ++i) {
+    xr_record_t *record = &records[i];
+    printf("%12.3f us %7d ", (record->time - records[0].time) / 1e3,
+           record->tid);
+    switch (record->trap) {
+      case XR_TRACE_TRAP_SYSCALL: {
+        const char *abi = XR_CALLS_COMPAT_NAME(record->compat),
+                   *name = XR_CALLS_NAME(record->nr, record->compat);
+        printf("%s %s(%#lx, %#lx, %#lx)", abi ? abi : "unknown",
+               name ? name : "unknown", record->args[0], record->args[1],
+               record->args[2]);
+        if (record->out) {
+          printf(" = %ld", record->retval);
+        }
+        break;
+      }
+      case XR_TRACE_TRAP_SIGNAL:
+        printf("signal %ld", record->nr);
+        break;
+      default:
+        printf("exit %ld", record->nr);
+        break;
+    }
+    if (record->checker == XR_RECORD_PASSED) {
+      printf("\n");
+    } else {
+      printf(" denied by %s checker\n", xrn_checker_names[record->checker]);
+    }
+  }
+}
+
+static inline void xrn_print_perf(xr_perf_count_t *count) {
+  printf("Counted %llu ns of cpu time", count->task_clock);
+  if (count->instructions != XR_PERF_UNAVAILABLE) {
+    printf(" and %llu instructions", count->instructions);
+  }
+  printf(".\n");
+}
+
+static inline void xrn_print_compensated(xr_tracer_t *tracer,
+                                         xr_result_t *result) {
+  printf("Compensated %lu stops of %llu ns each, %llu ns of cpu time left.\n",
+         tracer->nstop, tracer->stop_ns, result->compensated_cpu_ns);
+  // a program which ran at all has cpu time left after its stops.
+  if (result->cpu_ns != 0 && result->compensated_cpu_ns == 0) {
+    printf("Compensation took all cpu time, stops cost less than "
+           "calibrated.\n");
+  }
+}
+
+static inline void xrn_print_sched(xr_result_t *result) {
+  printf("Scheduled with %ld+%ld context switches and %ld migrations, "
+         "tracer with %ld+%ld and %ld.\n",
+         result->sched.nvcsw, result->sched.nivcsw, result->sched.nmigration,
+         result->tracer_sched.nvcsw, result->tracer_sched.nivcsw,
+         result->tracer_sched.nmigration);
+  printf("Faulted %ld+%ld pages, tracer %ld+%ld, and %llu ns were stolen.\n",
+         result->sched.nminflt, result->sched.nmajflt,
+         result->tracer_sched.nminflt, result->tracer_sched.nmajflt,
+         result->steal_ns);
+  if (result->noisy) {
+    printf("Run is noisy, its timing is doubtful.\n");
+  }
+}
+
+static void xrn_report_trace_result(xr_tracer_t *tracer, xr_result_t *result,
+                                    bool traced, void *ctx) {
+  xrn_global_config_set_t *cfg = (xrn_global_config_set_t *)ctx;
+  if (traced == false) {
+    xr_string_t error;
+    xr_string_zero(&error);
+    xr_error_tostring(&tracer->error, &error);
+    xrn_print_error(&error);
+    xr_string_delete(&error);
+    if (cfg->records == -1) {
+      xrn_print_records(tracer, result, XRN_RECORDS_DEFAULT);
+    }
+  } else {
+    xrn_print_trace_result(result);
+    if (result->perf.task_clock != XR_PERF_UNAVAILABLE) {
+      xrn_print_perf(&result->perf);
+    }
+    if (cfg->option.compensate) {
+      xrn_print_compensated(tracer, result);
+    }
+    if (xr_placement_enabled(&cfg->option.placement) || result->noisy) {
+      xrn_print_sched(result);
+    }
+    if (cfg->records == -1 && result->status != XR_RESULT_OK) {
+      xrn_print_records(tracer, result, XRN_RECORDS_DEFAULT);
+    }
+  }
+  if (cfg->records > 0) {
+    xrn_print_records(tracer, result, cfg->records);
+  }
+  // a replay which fails has left the captured trap stream as well.
+  if (cfg->replay != NULL &&
+      (traced == false || result->status != xr_tracer_replay_expect(tracer))) {
+    printf("Replayed run ended with status %d, but captured one with %d.\n",
+           result->status, xr_tracer_replay_expect(tracer));
+    cfg->diverged = true;
+  }
+  if (result->profile != NULL) {
+    xrn_print_profile(result->profile, cfg->profile);
+  }
+}
+
 int main(int argc, char *argv[]) {
   int retval = 0;
   xrn_global_config_set_t cfg;
+  // xrun calibrates tracers with itself.
+  if (argc == 2 && strcmp(argv[1], XRN_CALIBRATION_TRACEE) == 0) {
+    return xrn_calibration_tracee();
+  }
   xrn_global_option_set_init(&cfg);
+  // `xrun bench [options] program` compares native and traced runs.
+  if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+    cfg.bench = true;
+    cfg.repeat.nrun = XRN_BENCH_DEFAULT_RUN;
+    // both modes are counted, if perf_event is available.
+    cfg.option.perf = true;
+    argv[1] = argv[0];
+    argc--;
+    argv++;
+  }
   bool parse = xrn_parse_options(argc, argv, options, &cfg.error, &cfg);
   if (cfg.help || parse == false) {
     if (parse == false) {
@@ -393,16 +1120,25 @@ int main(int argc, char *argv[]) {
     // xrn_print_version();
     goto xrn_parse_option_error;
   }
+  // seccomp never traps on exit, where denials of landlock are seen.
+  if (cfg.seccomp && cfg.option.landlock) {
+    xr_string_format(&cfg.error, "--landlock needs ptrace tracer.\n");
+    xrn_print_error(&cfg.error);
+    retval = 1;
+    goto xrn_parse_option_error;
+  }
 
   cfg.option.access_trigger = XR_ACCESS_TRIGGER_MODE_IN;
 
-  if (optind >= argc) {
+  if (optind >= argc && cfg.replay == NULL) {
     retval = 1;
     xrn_print_options(options);
     goto xrn_parse_option_error;
   }
-  char *prog = argv[optind];
-  xr_string_concat_raw(&cfg.entry.path, prog, strlen(prog));
+  if (optind < argc) {
+    char *prog = argv[optind];
+    xr_string_concat_raw(&cfg.entry.path, prog, strlen(prog));
+  }
   int entry_argc = argc - optind;
   cfg.entry.argv = malloc(sizeof(char *) * (entry_argc + 1));
   for (int i = 0; i < entry_argc; ++i) {
@@ -439,8 +1175,23 @@ int main(int argc, char *argv[]) {
   cfg.entry.pwd.length = strlen(cfg.entry.pwd.string);
 
   xr_tracer_t tracer;
-  xr_result_t result;
-  xr_tracer_ptrace_init(&tracer, "xrunc_tracer");
+  xr_sandbox_pool_t sandboxes;
+  xr_workspace_pool_t workspaces;
+  xr_capture_t capture;
+  if (cfg.replay != NULL) {
+    xr_tracer_replay_init(&tracer, "xrunc_tracer");
+  } else if (cfg.seccomp) {
+    xr_tracer_seccomp_init(&tracer, "xrunc_tracer");
+  } else {
+    xr_tracer_ptrace_init(&tracer, "xrunc_tracer");
+  }
+  if (cfg.replay != NULL &&
+      xr_tracer_replay_load(&tracer, cfg.replay) == false) {
+    xr_error_tostring(&tracer.error, &cfg.error);
+    xrn_print_error(&cfg.error);
+    retval = 1;
+    goto xrn_tracer_failed;
+  }
 
   xr_checker_id_t checkers[5] = {XR_CHECKER_FILE, XR_CHECKER_RESOURCE,
                                  XR_CHECKER_IO, XR_CHECKER_FORK,
@@ -451,25 +1202,85 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  if (cfg.profile != XRN_PROFILE_NONE) {
+    cfg.repeat.profile = calloc(XR_RESULT_NPROFILE, sizeof(xr_result_call_t));
+  }
+
+  if (cfg.stats && xr_tracer_enable_stats(&tracer) == false) {
+    xr_error_tostring(&tracer.error, &cfg.error);
+    xrn_print_error(&cfg.error);
+    retval = 1;
+    goto xrn_tracer_failed;
+  }
+
   if (xr_tracer_setup(&tracer, &cfg.option) == false) {
     xr_error_tostring(&tracer.error, &cfg.error);
     xrn_print_error(&cfg.error);
     retval = 1;
     goto xrn_tracer_failed;
   }
-  for (int i = 0; i < cfg.run; ++i) {
-    xr_result_init(&result);
-    bool res = xr_tracer_trace(&tracer, &cfg.entry, &result);
-    if (res == false) {
-      xr_error_tostring(&tracer.error, &cfg.error);
+  if (cfg.option.compensate &&
+      xrn_calibrate(&tracer, cfg.seccomp, &cfg.error) == false) {
+    xrn_print_error(&cfg.error);
+    retval = 1;
+    goto xrn_tracer_failed;
+  }
+  // workspaces are set up first, so that sandboxes see them.
+  if (cfg.workspace != NULL) {
+    if (xr_workspace_pool_init(&workspaces, cfg.workspace, NULL, cfg.quota,
+                               XR_WORKSPACE_DEFAULT_WARM) == false) {
+      xr_string_format(&cfg.error, "can not mount workspaces under %s.",
+                       cfg.workspace);
       xrn_print_error(&cfg.error);
-    } else {
-      xrn_print_trace_result(&result);
+      retval = 1;
+      goto xrn_tracer_failed;
     }
-    xr_result_delete(&result);
+    tracer.workspaces = &workspaces;
+  }
+  if (cfg.sandbox != -1) {
+    if (xr_sandbox_pool_init(&sandboxes, 0, cfg.sandbox) == false) {
+      xr_string_format(&cfg.error, "can not start pool of sandboxes.");
+      xrn_print_error(&cfg.error);
+      retval = 1;
+      goto xrn_tracer_failed;
+    }
+    tracer.sandboxes = &sandboxes;
+  }
+  if (cfg.capture != NULL &&
+      xr_capture_open(&capture, &tracer, cfg.capture) == false) {
+    xr_string_format(&cfg.error, "can not open capture %s.", cfg.capture);
+    xrn_print_error(&cfg.error);
+    retval = 1;
+    goto xrn_tracer_failed;
+  }
+  if (cfg.bench) {
+    if (xrn_bench(&tracer, &cfg.entry, &cfg.repeat, &cfg.error) == false) {
+      xrn_print_error(&cfg.error);
+      retval = 1;
+    }
+  } else {
+    xrn_repeat(&tracer, &cfg.entry, &cfg.repeat, xrn_report_trace_result,
+               &cfg);
+  }
+  if (tracer.stats != NULL) {
+    xrn_print_stats(tracer.stats);
+  }
+  if (cfg.diverged) {
+    retval = 1;
   }
 xrn_tracer_failed:
+  if (tracer.capture != NULL && xr_capture_close(&capture, &tracer) == false) {
+    xr_string_format(&cfg.error, "can not write capture %s.", cfg.capture);
+    xrn_print_error(&cfg.error);
+    retval = 1;
+  }
   xr_tracer_delete(&tracer);
+  if (tracer.sandboxes != NULL) {
+    xr_sandbox_pool_delete(&sandboxes);
+  }
+  if (tracer.workspaces != NULL) {
+    xr_workspace_pool_delete(&workspaces);
+  }
 xrn_set_entry_error:
   free(cfg.entry.argv);
 xrn_parse_option_error:
@@ -16,6 +16,7 @@ grep -E "^[0-9A-Fa-fXx]+[[:space:]]+" "$IN" | sort -n | (
   echo "#define XR_ARM_SYSCALL_PRIVATE 8"
   echo "#define XR_SYSCALL_MAX (XR_ARM_SYSCALL_NORMAL + XR_ARM_SYSCALL_PRIVATE)"
   echo "extern const char *xr_syscall_table_arm[XR_SYSCALL_MAX];"
+  echo "extern const xr_calls_phash_t xr_syscall_phash_arm;"
   echo
   echo "#define xr_syscall_arm_to_oabi(nr) ((nr) + 0x900000)"
   echo "#define xr_syscall_arm_from_oabi(nr) ((nr) - 0x900000)"
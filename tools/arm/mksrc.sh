@@ -24,5 +24,19 @@ grep -E "^[0-9A-Fa-fXx]+[[:space:]]+" "$IN" | sort -n | (
   echo "[XR_SYSCALL_SET_TLS] = \"set_tls\","
   echo "[XR_SYSCALL_GET_TLS] = \"get_tls\","
   echo "};"
-  echo "#endif"
 ) > "$SOURCE"
+
+# perfect hash of names
+PHASH="$(dirname "$0")/../phash.awk"
+grep -E "^[0-9A-Fa-fXx]+[[:space:]]+" "$IN" | sort -n | (
+  while read nr abi name entry compat; do
+    name_upper=$(echo ${name} | tr 'a-z' 'A-Z')
+    echo "$name XR_SYSCALL_${name_upper}"
+  done
+  for name in breakpoint cacheflush usr26 usr32 set_tls get_tls; do
+    name_upper=$(echo ${name} | tr 'a-z' 'A-Z')
+    echo "$name XR_SYSCALL_${name_upper}"
+  done
+) | ${AWK:-awk} -v table=xr_syscall_phash_arm -f "$PHASH" >> "$SOURCE"
+
+echo "#endif" >> "$SOURCE"
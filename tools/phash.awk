@@ -0,0 +1,130 @@
+# Generate a collision-free hash of syscall names with hash and displace.
+#
+# Input lines are "<name> <macro>", where macro expands to syscall number of
+# name. Output is a xr_calls_phash_t named by variable `table`:
+#
+#   bucket = h0(seed, name) & (nbucket - 1)
+#   slot   = (h1(name) + disp[bucket]) & (nslot - 1)
+#   slots[slot] is the only candidate of name, see xr_calls_phash_lookup.
+#
+# h0 and h1 are polynomial hashes with base 31 and 131 modulo 2^32, h0 starts
+# from seed. They must stay the same as xr_calls_phash_lookup. Two names in a
+# bucket with the same h1 modulo nslot can never be separated, so other seeds
+# are tried before nslot is doubled.
+#
+# Usage: awk -v table=xr_syscall_phash_x64 -f phash.awk names
+
+function hash(name, base, seed,    h, i) {
+  h = seed
+  for (i = 1; i <= length(name); ++i) {
+    h = (h * base + ord[substr(name, i, 1)]) % 4294967296
+  }
+  return h
+}
+
+# place keys of buckets in descending size order, return 0 on collision.
+function place(    b, i, k, d, s, ok, order, norder, tmp, seen) {
+  for (b = 0; b < nbucket; ++b) {
+    size[b] = 0
+  }
+  for (k = 0; k < n; ++k) {
+    b = hash(name[k], 31, seed) % nbucket
+    member[b, size[b]++] = k
+  }
+  norder = 0
+  for (b = 0; b < nbucket; ++b) {
+    if (size[b] != 0) {
+      order[norder++] = b
+    }
+  }
+  for (i = 1; i < norder; ++i) {
+    tmp = order[i]
+    for (k = i - 1; k >= 0 && size[order[k]] < size[tmp]; --k) {
+      order[k + 1] = order[k]
+    }
+    order[k + 1] = tmp
+  }
+  split("", used)
+  for (b = 0; b < nbucket; ++b) {
+    disp[b] = 0
+  }
+  for (i = 0; i < norder; ++i) {
+    b = order[i]
+    for (d = 0; d < nslot; ++d) {
+      split("", seen)
+      ok = 1
+      for (k = 0; k < size[b] && ok; ++k) {
+        s = (h1[member[b, k]] + d) % nslot
+        if (s in used || s in seen) {
+          ok = 0
+        }
+        seen[s] = 1
+      }
+      if (ok) {
+        break
+      }
+    }
+    if (!ok) {
+      return 0
+    }
+    disp[b] = d
+    for (k = 0; k < size[b]; ++k) {
+      s = (h1[member[b, k]] + d) % nslot
+      used[s] = member[b, k]
+    }
+  }
+  return 1
+}
+
+BEGIN {
+  for (i = 32; i < 127; ++i) {
+    ord[sprintf("%c", i)] = i
+  }
+  n = 0
+}
+
+NF >= 2 {
+  name[n] = $1
+  macro[n] = $2
+  h1[n] = hash($1, 131, 0)
+  n++
+}
+
+END {
+  nbucket = 1
+  while (nbucket * 4 < n) {
+    nbucket *= 2
+  }
+  nslot = 1
+  while (nslot < n) {
+    nslot *= 2
+  }
+  for (seed = 0; !place(); ++seed) {
+    if (seed == 255) {
+      seed = -1
+      nslot *= 2
+    }
+  }
+
+  print ""
+  print "/* perfect hash of syscall names, generated by tools/phash.awk */"
+  printf("static const unsigned short %s_disp[%d] = {\n", table, nbucket)
+  for (b = 0; b < nbucket; ++b) {
+    printf("  %d,\n", disp[b])
+  }
+  print "};"
+  printf("static const short %s_slots[%d] = {\n", table, nslot)
+  for (s = 0; s < nslot; ++s) {
+    if (s in used) {
+      printf("  [%d] = %s,\n", s, macro[used[s]])
+    }
+  }
+  print "};"
+  printf("const xr_calls_phash_t %s = {\n", table)
+  printf("  .seed = %d,\n", seed)
+  printf("  .nbucket = %d,\n", nbucket)
+  printf("  .nslot = %d,\n", nslot)
+  printf("  .disp = %s_disp,\n", table)
+  printf("  .slots = %s_slots,\n", table)
+  print "};"
+}
@@ -25,11 +25,14 @@ grep -E "^[0-9A-Fa-fXx]+[[:space:]]+" "$IN" | sort -n | (
     echo "#define XR_IA32_SYSCALL_MAX ${CALL_ENTRIES}"
     echo "extern const char *xr_syscall_table_ia32[XR_IA32_SYSCALL_MAX];"
     echo "extern const int xr_syscall_table_x86_to_x64[XR_IA32_SYSCALL_MAX];"
+    echo "extern const xr_calls_phash_t xr_syscall_phash_ia32;"
     echo "#define xr_syscall_x64_from_x86(call) \\"
     echo "  ((call) < XR_IA32_SYSCALL_MAX ? xr_syscall_table_x86_to_x64[call] : -1)"
   else
     echo "#define XR_X64_SYSCALL_MAX ${CALL_ENTRIES}"
     echo "extern const char *xr_syscall_table_x64[XR_SYSCALL_MAX];"
+    echo "extern const xr_calls_phash_t xr_syscall_phash_x64;"
+    echo "extern const xr_calls_phash_t xr_syscall_phash_x32;"
     echo "#define XR_X32_MASK_BIT_SYSCALL 0x40000000"
     echo "#define xr_syscall_x64_from_x32(call) ((call) & ~XR_X32_MASK_BIT_SYSCALL)"
   fi
@@ -49,4 +49,33 @@ if [ "$ABI" = "i386" ]; then
   ) >> "$SOURCE"
 fi
 
+# perfect hash of names for each abi
+PHASH="$(dirname "$0")/../phash.awk"
+grep -E "^[0-9A-Fa-fXx]+[[:space:]]+" "$IN" | sort -n | (
+  while read nr abi name entry compat; do
+    name_upper=$(echo ${name} | tr 'a-z' 'A-Z')
+    if [ "$abi" = "i386" ]; then
+      echo "ia32 $name XR_IA32_SYSCALL_${name_upper}"
+    elif [ "$abi" = "x32" ]; then
+      echo "x32 $name XR_X32_SYSCALL_${name_upper}"
+    elif [ "$abi" = "64" ]; then
+      echo "x64 $name XR_SYSCALL_${name_upper}"
+    else
+      echo "x64 $name XR_SYSCALL_${name_upper}"
+      echo "x32 $name XR_SYSCALL_${name_upper}"
+    fi
+  done
+) > "$SOURCE.names"
+
+if [ "$ABI" = "i386" ]; then
+  TABLES="ia32"
+else
+  TABLES="x64 x32"
+fi
+for table in $TABLES; do
+  grep "^$table " "$SOURCE.names" | cut -d' ' -f2- |
+    ${AWK:-awk} -v table=xr_syscall_phash_$table -f "$PHASH" >> "$SOURCE"
+done
+rm -f "$SOURCE.names"
+
 echo "#endif" >> "$SOURCE"